@@ -0,0 +1,154 @@
+// Frame-time cost of capturing every frame, at 1080p and 4K, without and with 4x MSAA: no
+// capture, a plain synchronous glReadPixels (what osgViewer's ScreenCaptureHandler does), and
+// FrameCapture's PBO ring encoding raw RGBA or PNGs on its worker thread:
+//
+//   QT_QPA_PLATFORM=offscreen ./bench-capture --frames 300 --spheres 2000
+//
+// Captured frames go to --output (a temporary directory by default) and are left there.
+//
+// NOTE: Nothing waits on the GPU between frames (there's no swap to pace them, and a glFinish()
+// would make every readback synchronous), so frame_ms is mostly what each mode costs the CPU;
+// total_ms includes one glFinish() at the end.
+
+#include <memory>
+#include <vector>
+
+#include <QGuiApplication>
+#include <QElapsedTimer>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QJsonArray>
+
+#include <osgGA/TrackballManipulator>
+
+#include "osg-qt6/bench.hpp"
+#include "osg-qt6/frame-capture.hpp"
+#include "osg-qt6/offscreen.hpp"
+#include "osg-qt6/scenes.hpp"
+
+int main(int argc, char** argv) {
+	QGuiApplication app(argc, argv);
+	QCommandLineParser parser;
+
+	parser.addHelpOption();
+	parser.addOptions({
+		{"frames", "Frames rendered per mode.", "count", "300"},
+		{"spheres", "Spheres in the (instanced) scene.", "count", "2000"},
+		{"modes", "Comma-separated: off, sync, raw, png.", "modes", "off,sync,raw,png"},
+		{"output", "Where captured frames are written.", "path"}
+	});
+	parser.process(app);
+
+	auto frames = std::max(1, parser.value("frames").toInt());
+	auto modes = parser.value("modes").split(',', Qt::SkipEmptyParts);
+	auto output = QDir(parser.isSet("output") ? parser.value("output") : QDir::temp().filePath("bench-capture"));
+
+	QDir().mkpath(output.path());
+
+	QJsonArray runs;
+
+	for(auto [width, height] : {std::pair{1920, 1080}, std::pair{3840, 2160}}) for(int samples : {0, 4}) {
+		osg_qt6::OffscreenViewer offscreen(width, height, samples);
+
+		if(!offscreen.valid()) {
+			OSG_FATAL << "bench-capture: couldn't create a " << width << "x" << height << " offscreen FBO" << std::endl;
+
+			return 1;
+		}
+
+		auto* viewer = offscreen.viewer();
+
+		viewer->setCameraManipulator(new osgGA::TrackballManipulator());
+
+		// NOTE: A scene of its own per viewer; GL objects compiled for one context ID would be stale
+		// in the next.
+		viewer->setSceneData(osg_qt6::createSphereFieldScene(static_cast<size_t>(parser.value("spheres").toULongLong())));
+
+		offscreen.frame();
+		offscreen.finish();
+
+		auto* gl = offscreen.context()->functions();
+		auto fbo = offscreen.fbo()->handle();
+
+		std::vector<std::uint8_t> pixels(static_cast<size_t>(width) * height * 4);
+
+		// The synchronous readback has to resolve a multisampled FBO first too.
+		std::unique_ptr<QOpenGLFramebufferObject> resolve;
+
+		if(samples > 0) resolve = std::make_unique<QOpenGLFramebufferObject>(width, height);
+
+		for(const auto& mode : modes) {
+			osg_qt6::FrameCapture capture;
+			osg_qt6::Samples wall;
+			QElapsedTimer clock;
+			QElapsedTimer total;
+
+			auto name = QString("%1x%2-msaa%3-%4").arg(width).arg(height).arg(samples).arg(mode);
+
+			if(mode == "raw") capture.start(output.filePath(name + ".rgba").toStdString(), osg_qt6::FrameCapture::RAW);
+
+			else if(mode == "png") capture.start(output.filePath(name).toStdString(), osg_qt6::FrameCapture::PNG);
+
+			total.start();
+
+			for(int i = 0; i < frames; i++) {
+				clock.start();
+
+				offscreen.frame();
+
+				if(mode == "sync") {
+					if(resolve) {
+						QOpenGLFramebufferObject::blitFramebuffer(resolve.get(), offscreen.fbo());
+
+						resolve->bind();
+					}
+
+					gl->glPixelStorei(GL_PACK_ALIGNMENT, 4);
+					gl->glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+				}
+
+				else if(mode != "off") {
+					capture.capture(fbo, samples, width, height);
+					capture.poll();
+				}
+
+				wall.add(clock.nsecsElapsed() / 1.0e6);
+			}
+
+			offscreen.finish();
+
+			double totalMs = total.nsecsElapsed() / 1.0e6;
+
+			capture.stop();
+
+			// Drain the ring before the context goes away.
+			while(capture.pending()) {
+				offscreen.finish();
+				capture.poll();
+			}
+
+			capture.release();
+
+			runs.append(QJsonObject{
+				{"width", width},
+				{"height", height},
+				{"samples", samples},
+				{"mode", mode},
+				{"frame_ms", wall.toJson()},
+				{"total_ms", totalMs},
+				{"captured", static_cast<qint64>(mode == "sync" ? frames : capture.framesCaptured())},
+				{"dropped", static_cast<qint64>(capture.framesDropped())}
+			});
+		}
+	}
+
+	osg_qt6::writeJson({
+		{"bench", "capture"},
+		{"frames", frames},
+		{"output", output.path()},
+		{"runs", runs},
+		{"peak_rss_kb", static_cast<qint64>(osg_qt6::peakRssKb())}
+	});
+
+	return 0;
+}
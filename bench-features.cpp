@@ -0,0 +1,207 @@
+// Drapes N random polygons (3 to 8 sides, 2 to 20km across) on the example-osgearth map, once as a
+// LocalGeometryNode per polygon (exactly what the disabled TriangleNode in
+// example-osgearth-interactive does) and once through a single DrapedFeatureLayer, then renders a
+// fixed global view and reports add time, memory and per-phase frame timings:
+//
+//   QT_QPA_PLATFORM=offscreen ./bench-features --count 50000 --frames 200
+//
+// The layer run also times recoloring every feature (the attribute-texture path, no rebuild).
+
+#include <cmath>
+#include <random>
+
+#include <QGuiApplication>
+#include <QElapsedTimer>
+#include <QCommandLineParser>
+#include <QJsonArray>
+
+#include <osgEarth/MapNode>
+#include <osgEarth/EarthManipulator>
+#include <osgEarth/ExampleResources>
+#include <osgEarth/LocalGeometryNode>
+
+#include "osg-qt6/bench.hpp"
+#include "osg-qt6/earth-scenes.hpp"
+#include "osg-qt6/feature-layer.hpp"
+#include "osg-qt6/offscreen.hpp"
+
+namespace osg_qt6 {
+
+// One random polygon: its center, and its corners as east/north offsets in meters.
+struct RandomPolygon {
+	double lon;
+	double lat;
+
+	std::vector<osg::Vec2d> offsets;
+
+	// The corners in lon/lat degrees (locally flat, which is plenty at this size).
+	std::vector<osg::Vec2d> ring() const {
+		std::vector<osg::Vec2d> r;
+
+		for(const auto& o : offsets) r.emplace_back(
+			lon + osg::RadiansToDegrees(o.x() / (osg::WGS_84_RADIUS_EQUATOR * std::cos(osg::DegreesToRadians(lat)))),
+			lat + osg::RadiansToDegrees(o.y() / osg::WGS_84_RADIUS_EQUATOR)
+		);
+
+		return r;
+	}
+};
+
+inline RandomPolygon randomPolygon(std::mt19937& rng) {
+	std::uniform_real_distribution<double> lon(-180.0, 180.0);
+	std::uniform_real_distribution<double> lat(-60.0, 60.0);
+	std::uniform_real_distribution<double> radius(1000.0, 10000.0);
+	std::uniform_int_distribution<int> sides(3, 8);
+
+	RandomPolygon p{lon(rng), lat(rng), {}};
+
+	int n = sides(rng);
+	double r = radius(rng);
+
+	for(int i = 0; i < n; i++) {
+		double a = 2.0 * osg::PI * i / n;
+
+		p.offsets.emplace_back(r * std::cos(a), r * std::sin(a));
+	}
+
+	return p;
+}
+
+// The original, one-LocalGeometryNode-per-polygon approach; kept here only as the baseline.
+inline void addLocalGeometryNode(osgEarth::MapNode* mapNode, const RandomPolygon& p, const osgEarth::Style& style) {
+	auto* geom = new osgEarth::Polygon();
+
+	for(const auto& o : p.offsets) geom->push_back(o.x(), o.y(), 0.0);
+
+	auto* node = new osgEarth::LocalGeometryNode(geom, style);
+
+	node->setPosition(osgEarth::GeoPoint(mapNode->getMapSRS(), p.lon, p.lat));
+
+	mapNode->addChild(node);
+}
+
+}
+
+QJsonObject runMode(const QString& mode, int count, int frames) {
+	osg_qt6::OffscreenViewer offscreen(1280, 720);
+
+	auto* viewer = offscreen.viewer();
+	auto* node = osg_qt6::createGridMapNode();
+	auto* manip = new osgEarth::EarthManipulator();
+
+	viewer->setCameraManipulator(manip);
+	viewer->setSceneData(node);
+
+	osgEarth::MapNodeHelper().configureView(viewer);
+
+	manip->setViewpoint(osgEarth::Viewpoint("global", 0.0, 20.0, 0.0, 0.0, -90.0, 2.0e7));
+
+	// Same seed for both modes, so both drape the exact same polygons.
+	std::mt19937 rng(1234);
+
+	osgEarth::Style style;
+
+	style.getOrCreate<osgEarth::PolygonSymbol>()->fill().mutable_value().color() = osgEarth::Color(1.0f, 0.0f, 0.0f, 0.5f);
+	style.getOrCreate<osgEarth::AltitudeSymbol>()->clamping() = osgEarth::AltitudeSymbol::CLAMP_TO_TERRAIN;
+	style.getOrCreate<osgEarth::AltitudeSymbol>()->technique() = osgEarth::AltitudeSymbol::TECHNIQUE_DRAPE;
+
+	auto rssBefore = osg_qt6::currentRssKb();
+
+	QElapsedTimer clock;
+	QJsonObject result{{"mode", mode}};
+
+	clock.start();
+
+	if(mode == "localgeometry") {
+		for(int i = 0; i < count; i++) osg_qt6::addLocalGeometryNode(node, osg_qt6::randomPolygon(rng), style);
+
+		result["add_ms"] = clock.nsecsElapsed() / 1.0e6;
+	}
+
+	else {
+		osg::ref_ptr<osg_qt6::DrapedFeatureLayer> layer = new osg_qt6::DrapedFeatureLayer();
+
+		for(int i = 0; i < count; i++) layer->add(osg_qt6::randomPolygon(rng).ring(), osg::Vec4(1.0f, 0.0f, 0.0f, 0.5f));
+
+		result["add_ms"] = clock.nsecsElapsed() / 1.0e6;
+
+		clock.restart();
+
+		layer->build();
+		layer->wait();
+
+		result["build_ms"] = clock.nsecsElapsed() / 1.0e6;
+		result["buckets"] = static_cast<qint64>(layer->buckets());
+
+		node->addChild(layer.get());
+
+		// Every other feature turns green, then back.
+		clock.restart();
+
+		for(int i = 0; i < count; i += 2) layer->setColor(static_cast<osg_qt6::DrapedFeatureLayer::id_t>(i), osg::Vec4(0.0f, 1.0f, 0.0f, 0.5f));
+		for(int i = 0; i < count; i += 2) layer->setColor(static_cast<osg_qt6::DrapedFeatureLayer::id_t>(i), osg::Vec4(1.0f, 0.0f, 0.0f, 0.5f));
+
+		result["recolor_us_per_feature"] = clock.nsecsElapsed() / 1.0e3 / std::max(count, 1);
+	}
+
+	osg_qt6::FrameStats stats;
+
+	stats.enable(viewer);
+
+	clock.restart();
+
+	offscreen.frame();
+	offscreen.finish();
+
+	result["first_frame_ms"] = clock.nsecsElapsed() / 1.0e6;
+
+	for(int i = 0; i < frames; i++) {
+		offscreen.frame();
+
+		auto frameNumber = viewer->getViewerFrameStamp()->getFrameNumber();
+
+		if(frameNumber >= osg_qt6::FrameStats::LAG) stats.collect(viewer, frameNumber - osg_qt6::FrameStats::LAG);
+	}
+
+	offscreen.finish();
+
+	stats.collectRemaining(viewer);
+
+	result["rss_delta_kb"] = static_cast<qint64>(osg_qt6::currentRssKb() - rssBefore);
+	result["phases_ms"] = stats.toJson();
+
+	return result;
+}
+
+int main(int argc, char** argv) {
+	QGuiApplication app(argc, argv);
+	QCommandLineParser parser;
+
+	parser.addHelpOption();
+	parser.addOptions({
+		{"count", "Number of polygons.", "count", "50000"},
+		{"frames", "Frames rendered per mode.", "count", "200"},
+		{"mode", "localgeometry, layer or both.", "mode", "both"}
+	});
+	parser.process(app);
+
+	osgEarth::initialize();
+
+	auto count = parser.value("count").toInt();
+	auto frames = parser.value("frames").toInt();
+	auto mode = parser.value("mode");
+
+	QJsonArray modes;
+
+	if(mode != "layer") modes.append(runMode("localgeometry", count, frames));
+	if(mode != "localgeometry") modes.append(runMode("layer", count, frames));
+
+	osg_qt6::writeJson({
+		{"bench", "features"},
+		{"count", count},
+		{"modes", modes},
+		{"peak_rss_kb", static_cast<qint64>(osg_qt6::peakRssKb())}
+	});
+
+	return 0;
+}
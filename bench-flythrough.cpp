@@ -0,0 +1,138 @@
+// Flies fast and low across the example-osgearth-interactive map (so new tiles arrive every frame)
+// once with GL compilation left inline and once per --budgets entry with an IncrementalCompileOperation
+// budget, and reports frame-time percentiles plus how many frames spiked:
+//
+//   QT_QPA_PLATFORM=offscreen ./bench-flythrough --budgets 0,2,4 --frames 1000 --pager-threads 4
+//
+// Each run gets a fresh viewer and MapNode, so no run sees another's tiles (other than through the
+// OS file cache; --budgets order is the run order).
+
+#include <cmath>
+
+#include <QGuiApplication>
+#include <QElapsedTimer>
+#include <QCommandLineParser>
+#include <QJsonArray>
+
+#include <osgEarth/EarthManipulator>
+#include <osgEarth/ExampleResources>
+
+#include "osg-qt6/bench.hpp"
+#include "osg-qt6/compile-budget.hpp"
+#include "osg-qt6/earth-scenes.hpp"
+#include "osg-qt6/offscreen.hpp"
+
+namespace osg_qt6 {
+
+// Along the equator-ish at ~300km, covering `degrees` of longitude over the run.
+inline void flyThrough(osgViewer::Viewer* viewer, double t, double degrees) {
+	auto* manip = dynamic_cast<osgEarth::Util::EarthManipulator*>(viewer->getCameraManipulator());
+
+	if(!manip) return;
+
+	manip->setViewpoint(osgEarth::Viewpoint(
+		"flythrough",
+		-90.0 + degrees * t,
+		20.0 * std::sin(4.0 * osg::PI * t),
+		0.0,
+		90.0,
+		-30.0,
+		3.0e5
+	));
+}
+
+}
+
+int main(int argc, char** argv) {
+	QGuiApplication app(argc, argv);
+	QCommandLineParser parser;
+
+	parser.addHelpOption();
+	parser.addOptions({
+		{"budgets", "Comma-separated per-frame compile budgets to run (0 compiles inline).", "ms", "0,4"},
+		{"merges-per-frame", "New terrain tiles merged per frame (0 for all).", "count", "0"},
+		{"pager-threads", "Tile loading threads (0 for the default).", "count", "0"},
+		{"frames", "Frames per run.", "count", "1000"},
+		{"degrees", "Longitude covered per run.", "degrees", "180"},
+		{"spike-ms", "Frames slower than this count as spikes.", "ms", "33.3"},
+		{"width", "Framebuffer width.", "pixels", "1280"},
+		{"height", "Framebuffer height.", "pixels", "720"}
+	});
+	parser.process(app);
+
+	auto frames = std::max(1, parser.value("frames").toInt());
+	auto degrees = parser.value("degrees").toDouble();
+	auto spikeMs = parser.value("spike-ms").toDouble();
+
+	osgEarth::initialize();
+
+	QJsonArray runs;
+
+	for(const auto& value : parser.value("budgets").split(',', Qt::SkipEmptyParts)) {
+		osg_qt6::CompileBudget budget{
+			value.toDouble(),
+			parser.value("merges-per-frame").toInt(),
+			parser.value("pager-threads").toInt()
+		};
+
+		osg_qt6::OffscreenViewer offscreen(parser.value("width").toInt(), parser.value("height").toInt());
+
+		if(!offscreen.valid()) {
+			OSG_FATAL << "bench-flythrough: couldn't create an offscreen GL context/FBO" << std::endl;
+
+			return 1;
+		}
+
+		auto* viewer = offscreen.viewer();
+		auto* node = osg_qt6::createWorldMapNode();
+
+		osg_qt6::setUpCompileBudget(node, budget);
+
+		viewer->setCameraManipulator(new osgEarth::EarthManipulator());
+
+		osg_qt6::setUpCompileBudget(viewer, budget);
+
+		viewer->setSceneData(node);
+
+		osgEarth::MapNodeHelper().configureView(viewer);
+
+		osg_qt6::Samples wall;
+		QElapsedTimer clock;
+
+		int spikes = 0;
+
+		for(int i = 0; i < frames; i++) {
+			osg_qt6::flyThrough(viewer, static_cast<double>(i) / frames, degrees);
+
+			clock.start();
+
+			offscreen.frame();
+			offscreen.finish();
+
+			auto ms = clock.nsecsElapsed() / 1.0e6;
+
+			wall.add(ms);
+
+			if(ms > spikeMs) spikes++;
+		}
+
+		runs.append(QJsonObject{
+			{"compile_budget_ms", budget.compileMs},
+			{"frame_ms", wall.toJson()},
+			{"frame_ms_variance", wall.variance()},
+			{"spikes", spikes}
+		});
+	}
+
+	osg_qt6::writeJson({
+		{"bench", "flythrough"},
+		{"frames", frames},
+		{"merges_per_frame", parser.value("merges-per-frame").toInt()},
+		{"pager_threads", parser.value("pager-threads").toInt()},
+		{"spike_ms", spikeMs},
+		{"runs", runs},
+		{"peak_rss_kb", static_cast<qint64>(osg_qt6::peakRssKb())}
+	});
+
+	return 0;
+}
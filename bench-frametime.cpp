@@ -0,0 +1,220 @@
+// Renders one of the example scenes offscreen for a fixed number of frames along a scripted camera
+// path and prints per-phase frame timings (from osg::Stats), startup time and peak RSS as JSON:
+//
+//   QT_QPA_PLATFORM=offscreen LIBGL_ALWAYS_SOFTWARE=1 ./bench-frametime --scene osgearth --frames 500
+//
+// Like the examples, run it from a build directory one level below the repository (the osgEarth
+// scenes load `../grid2.png` and `../world.tif`).
+
+#include <cmath>
+
+#include <QGuiApplication>
+#include <QElapsedTimer>
+#include <QCommandLineParser>
+
+#include <osgGA/TrackballManipulator>
+#include <osgViewer/Viewer>
+
+#include <osgEarth/MapNode>
+#include <osgEarth/EarthManipulator>
+#include <osgEarth/ExampleResources>
+
+#include "osg-qt6/bench.hpp"
+#include "osg-qt6/earth-scenes.hpp"
+#include "osg-qt6/offscreen.hpp"
+#include "osg-qt6/scenes.hpp"
+#include "osg-qt6/trace.hpp"
+
+namespace osg_qt6 {
+
+// Moves the camera as a function of t in [0, 1], so every run (and every build) sees the same views.
+class CameraPath {
+public:
+	virtual ~CameraPath() = default;
+
+	virtual void apply(osgViewer::Viewer* viewer, double t) = 0;
+};
+
+// For the plain OSG scenes: a full orbit around the origin, bobbing up and down once.
+class OrbitPath: public CameraPath {
+public:
+	OrbitPath(double radius): _radius(radius) {}
+
+	void apply(osgViewer::Viewer* viewer, double t) override {
+		double a = 2.0 * osg::PI * t;
+		osg::Vec3d eye(_radius * std::cos(a), _radius * std::sin(a), 0.5 * _radius * std::sin(a * 2.0));
+
+		viewer->getCamera()->setViewMatrixAsLookAt(eye, osg::Vec3d(), osg::Vec3d(0.0, 0.0, 1.0));
+	}
+
+private:
+	double _radius = 60.0;
+};
+
+// For the osgEarth scenes: once around the globe, diving from orbit down to ~200km and back out so
+// the pass exercises several LODs' worth of tiles.
+class GlobePath: public CameraPath {
+public:
+	void apply(osgViewer::Viewer* viewer, double t) override {
+		auto* manip = dynamic_cast<osgEarth::Util::EarthManipulator*>(viewer->getCameraManipulator());
+
+		if(!manip) return;
+
+		double dive = 0.5 - 0.5 * std::cos(2.0 * osg::PI * t);
+
+		osgEarth::Viewpoint vp(
+			"path",
+			-180.0 + 360.0 * t,
+			30.0 * std::sin(2.0 * osg::PI * t),
+			0.0,
+			0.0,
+			-60.0,
+			2.0e7 * (1.0 - dive) + 2.0e5 * dive
+		);
+
+		manip->setViewpoint(vp);
+	}
+};
+
+struct BenchScene {
+	osg::ref_ptr<osg::Node> node;
+
+	std::unique_ptr<CameraPath> path;
+};
+
+inline BenchScene createBenchScene(const QString& name, osgViewer::Viewer* viewer) {
+	BenchScene scene;
+
+	if(name == "osg") {
+		scene.node = createPointSphereScene();
+		scene.path = std::make_unique<OrbitPath>(60.0);
+
+		viewer->setSceneData(scene.node);
+
+		return scene;
+	}
+
+	osgEarth::initialize();
+
+	// NOTE: "osgearth-interactive" is the same map the interactive example builds; the click
+	// handler is left out since nothing here clicks.
+	scene.node = name == "osgearth" ? createGridMapNode() : createWorldMapNode();
+	scene.path = std::make_unique<GlobePath>();
+
+	viewer->setCameraManipulator(new osgEarth::EarthManipulator());
+	viewer->setSceneData(scene.node);
+
+	osgEarth::MapNodeHelper().configureView(viewer);
+
+	return scene;
+}
+
+}
+
+int main(int argc, char** argv) {
+	QElapsedTimer startup;
+
+	startup.start();
+
+	QGuiApplication app(argc, argv);
+	QCommandLineParser parser;
+
+	parser.addHelpOption();
+	parser.addOptions({
+		{"scene", "Scene to render: osg, osgearth, osgearth-interactive.", "name", "osg"},
+		{"frames", "Number of measured frames.", "count", "500"},
+		{"warmup", "Frames rendered (along the path) before measuring.", "count", "30"},
+		{"width", "Framebuffer width.", "pixels", "1280"},
+		{"height", "Framebuffer height.", "pixels", "720"},
+		{"samples", "MSAA samples for the FBO.", "count", "0"}
+	});
+	parser.process(app);
+
+	osg_qt6::trace::startFromEnvironment();
+	osg_qt6::trace::setThreadName("bench");
+
+	auto frames = std::max(1, parser.value("frames").toInt());
+	auto warmup = std::max(0, parser.value("warmup").toInt());
+
+	if(!QStringList{"osg", "osgearth", "osgearth-interactive"}.contains(parser.value("scene"))) {
+		OSG_FATAL << "bench-frametime: unknown scene: " << parser.value("scene").toStdString() << std::endl;
+
+		return 1;
+	}
+
+	osg_qt6::OffscreenViewer offscreen(
+		parser.value("width").toInt(),
+		parser.value("height").toInt(),
+		parser.value("samples").toInt()
+	);
+
+	if(!offscreen.valid()) {
+		OSG_FATAL << "bench-frametime: couldn't create an offscreen GL context/FBO" << std::endl;
+
+		return 1;
+	}
+
+	auto* viewer = offscreen.viewer();
+	auto contextMs = startup.nsecsElapsed() / 1.0e6;
+	auto scene = osg_qt6::createBenchScene(parser.value("scene"), viewer);
+	auto sceneMs = startup.nsecsElapsed() / 1.0e6;
+
+	if(!viewer->getCameraManipulator()) scene.path->apply(viewer, 0.0);
+
+	osg_qt6::trace::install(viewer);
+
+	osg_qt6::FrameStats stats;
+
+	stats.enable(viewer);
+
+	offscreen.frame();
+	offscreen.finish();
+
+	auto firstFrameMs = startup.nsecsElapsed() / 1.0e6;
+
+	osg_qt6::Samples wall;
+	QElapsedTimer clock;
+
+	for(int i = 0; i < warmup + frames; i++) {
+		scene.path->apply(viewer, static_cast<double>(i) / (warmup + frames));
+
+		// NOTE: The stats lag a few frames behind; this keeps the warmup's out of them too.
+		if(i == warmup) stats.setFirstFrame(viewer->getViewerFrameStamp()->getFrameNumber() + 1);
+
+		clock.start();
+
+		offscreen.frame();
+
+		if(i < warmup) continue;
+
+		wall.add(clock.nsecsElapsed() / 1.0e6);
+
+		auto frameNumber = viewer->getViewerFrameStamp()->getFrameNumber();
+
+		if(frameNumber >= osg_qt6::FrameStats::LAG) stats.collect(viewer, frameNumber - osg_qt6::FrameStats::LAG);
+	}
+
+	offscreen.finish();
+
+	stats.collectRemaining(viewer);
+
+	osg_qt6::writeJson({
+		{"bench", "frametime"},
+		{"scene", parser.value("scene")},
+		{"renderer", offscreen.renderer()},
+		{"width", offscreen.width()},
+		{"height", offscreen.height()},
+		{"frames", frames},
+		{"startup_ms", QJsonObject{
+			{"context", contextMs},
+			{"scene", sceneMs - contextMs},
+			{"first_frame", firstFrameMs - sceneMs},
+			{"total", firstFrameMs}
+		}},
+		{"frame_ms", wall.toJson()},
+		{"phases_ms", stats.toJson()},
+		{"peak_rss_kb", static_cast<qint64>(osg_qt6::peakRssKb())}
+	});
+
+	return 0;
+}
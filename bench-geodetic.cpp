@@ -0,0 +1,193 @@
+// Throughput of ECEF <-> lon/lat/alt conversion, one point at a time through osgEarth's
+// SpatialReference::transform() (what GeoPoint::fromWorld()/toWorld() come down to) vs. the batched
+// osg_qt6::ecefToGeodetic()/geodeticToEcef() with the scalar and the SIMD kernel, plus the largest
+// difference from osgEarth; exits nonzero if that's outside the documented tolerance:
+//
+//   ./bench-geodetic --count 10000000 --repeats 5
+//
+// Configure with -DOSG_QT6_NATIVE=ON on x86-64, or the "simd" run is just the scalar kernel again.
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QCommandLineParser>
+#include <QJsonArray>
+
+#include <osgEarth/SpatialReference>
+
+#include "osg-qt6/bench.hpp"
+#include "osg-qt6/geodetic.hpp"
+
+namespace osg_qt6 {
+
+// Structure-of-arrays buffers for `count` points.
+struct Points {
+	Points(size_t count):
+	a(count),
+	b(count),
+	c(count) {
+	}
+
+	std::vector<double> a;
+	std::vector<double> b;
+	std::vector<double> c;
+};
+
+}
+
+int main(int argc, char** argv) {
+	QCoreApplication app(argc, argv);
+	QCommandLineParser parser;
+
+	parser.addHelpOption();
+	parser.addOptions({
+		{"count", "Points converted per repeat.", "count", "1000000"},
+		{"repeats", "Times each kernel converts them all.", "count", "5"},
+		{"osgearth-count", "Points osgEarth converts (one at a time) for speed and the tolerance check.", "count", "200000"}
+	});
+	parser.process(app);
+
+	auto count = static_cast<size_t>(std::max(1LL, parser.value("count").toLongLong()));
+	auto repeats = std::max(1, parser.value("repeats").toInt());
+	auto checked = std::min(count, static_cast<size_t>(std::max(1LL, parser.value("osgearth-count").toLongLong())));
+
+	osg_qt6::Points geo(count);
+	osg_qt6::Points ecef(count);
+	osg_qt6::Points out(count);
+
+	std::mt19937_64 rng(20);
+	std::uniform_real_distribution<double> lon(-180.0, 180.0);
+	std::uniform_real_distribution<double> lat(-90.0, 90.0);
+	std::uniform_real_distribution<double> alt(-11000.0, 1.0e6);
+
+	for(size_t i = 0; i < count; i++) {
+		geo.a[i] = lon(rng);
+		geo.b[i] = lat(rng);
+		geo.c[i] = alt(rng);
+	}
+
+	osg::ref_ptr<const osgEarth::SpatialReference> wgs84 = osgEarth::SpatialReference::get("wgs84");
+	osg::ref_ptr<const osgEarth::SpatialReference> geocentric = wgs84->getGeocentricSRS();
+
+	// osgEarth, one point at a time; its results are the reference for the tolerance check.
+	osg_qt6::Points refEcef(checked);
+	osg_qt6::Points refGeo(checked);
+	QElapsedTimer clock;
+
+	clock.start();
+
+	for(size_t i = 0; i < checked; i++) {
+		osg::Vec3d world;
+
+		wgs84->transform(osg::Vec3d(geo.a[i], geo.b[i], geo.c[i]), geocentric.get(), world);
+
+		refEcef.a[i] = world.x();
+		refEcef.b[i] = world.y();
+		refEcef.c[i] = world.z();
+	}
+
+	double osgEarthToEcef = checked / (clock.nsecsElapsed() / 1.0e9);
+
+	clock.start();
+
+	for(size_t i = 0; i < checked; i++) {
+		osg::Vec3d gp;
+
+		geocentric->transform(osg::Vec3d(refEcef.a[i], refEcef.b[i], refEcef.c[i]), wgs84.get(), gp);
+
+		refGeo.a[i] = gp.x();
+		refGeo.b[i] = gp.y();
+		refGeo.c[i] = gp.z();
+	}
+
+	double osgEarthToGeodetic = checked / (clock.nsecsElapsed() / 1.0e9);
+
+	QJsonArray runs;
+
+	runs.append(QJsonObject{
+		{"kernel", "osgearth"},
+		{"to_ecef_mpts_per_s", osgEarthToEcef / 1.0e6},
+		{"to_geodetic_mpts_per_s", osgEarthToGeodetic / 1.0e6}
+	});
+
+	bool withinTolerance = true;
+
+	for(bool simd : {false, true}) {
+		osg_qt6::Samples toEcef;
+		osg_qt6::Samples toGeodetic;
+
+		for(int r = 0; r < repeats; r++) {
+			clock.start();
+
+			osg_qt6::geodeticToEcef(geo.a.data(), geo.b.data(), geo.c.data(), ecef.a.data(), ecef.b.data(), ecef.c.data(), count, simd);
+
+			toEcef.add(count / (clock.nsecsElapsed() / 1.0e9) / 1.0e6);
+
+			// NOTE: From osgEarth's ECEF rather than our own, so both directions are checked
+			// independently.
+			std::copy_n(refEcef.a.begin(), checked, ecef.a.begin());
+			std::copy_n(refEcef.b.begin(), checked, ecef.b.begin());
+			std::copy_n(refEcef.c.begin(), checked, ecef.c.begin());
+
+			clock.start();
+
+			osg_qt6::ecefToGeodetic(ecef.a.data(), ecef.b.data(), ecef.c.data(), out.a.data(), out.b.data(), out.c.data(), count, simd);
+
+			toGeodetic.add(count / (clock.nsecsElapsed() / 1.0e9) / 1.0e6);
+		}
+
+		// Our own ECEF again for the points the loop left osgEarth's in.
+		osg_qt6::geodeticToEcef(geo.a.data(), geo.b.data(), geo.c.data(), ecef.a.data(), ecef.b.data(), ecef.c.data(), checked, simd);
+
+		double ecefError = 0.0;
+		double degreesError = 0.0;
+		double altError = 0.0;
+
+		for(size_t i = 0; i < checked; i++) {
+			ecefError = std::max(ecefError, (
+				osg::Vec3d(ecef.a[i], ecef.b[i], ecef.c[i]) - osg::Vec3d(refEcef.a[i], refEcef.b[i], refEcef.c[i])
+			).length());
+
+			double dLon = std::abs(out.a[i] - refGeo.a[i]);
+
+			// NOTE: Longitude means nothing at the poles, and +-180 are the same meridian.
+			if(std::abs(refGeo.b[i]) > 89.9999) dLon = 0.0;
+
+			degreesError = std::max({degreesError, std::min(dLon, 360.0 - dLon), std::abs(out.b[i] - refGeo.b[i])});
+			altError = std::max(altError, std::abs(out.c[i] - refGeo.c[i]));
+		}
+
+		bool ok =
+			ecefError <= osg_qt6::GEODETIC_TOLERANCE_METERS &&
+			altError <= osg_qt6::GEODETIC_TOLERANCE_METERS &&
+			degreesError <= osg_qt6::GEODETIC_TOLERANCE_DEGREES
+		;
+
+		withinTolerance = withinTolerance && ok;
+
+		runs.append(QJsonObject{
+			{"kernel", simd ? osg_qt6::geodeticKernel() : "scalar"},
+			{"to_ecef_mpts_per_s", toEcef.toJson()},
+			{"to_geodetic_mpts_per_s", toGeodetic.toJson()},
+			{"max_ecef_error_m", ecefError},
+			{"max_lonlat_error_deg", degreesError},
+			{"max_alt_error_m", altError},
+			{"within_tolerance", ok}
+		});
+	}
+
+	osg_qt6::writeJson({
+		{"bench", "geodetic"},
+		{"count", static_cast<qint64>(count)},
+		{"osgearth_count", static_cast<qint64>(checked)},
+		{"tolerance_deg", osg_qt6::GEODETIC_TOLERANCE_DEGREES},
+		{"tolerance_m", osg_qt6::GEODETIC_TOLERANCE_METERS},
+		{"runs", runs},
+		{"peak_rss_kb", static_cast<qint64>(osg_qt6::peakRssKb())}
+	});
+
+	return withinTolerance ? 0 : 1;
+}
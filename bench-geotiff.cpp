@@ -0,0 +1,241 @@
+// Reads every tile of the first few LODs of world.tif through osgEarth's GDALImageLayer and through
+// MappedGeoTIFFLayer, from several threads at once (as the terrain's loader threads would), and
+// reports createImage() tiles/s for a cold and a warm pass. MappedGeoTIFFLayer's createTexture()
+// (what the terrain actually calls, and where its zero-copy path is) is reported separately, as
+// texture_cold_tiles_per_s/texture_warm_tiles_per_s from a fresh layer:
+//
+//   QT_QPA_PLATFORM=offscreen ./bench-geotiff --image ../world.tif --max-level 4 --threads 4
+//
+// world.tif itself is JPEG compressed, which only GDAL reads, so GDAL first writes two internally
+// tiled copies next to the results (uncompressed and LZW, 256x256 tiles, overviews 2/4/8); both
+// layers then read those too.
+//
+// NOTE: The files are small enough to stay in the page cache, so "cold" means a fresh layer, not a
+// fresh disk read.
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QJsonArray>
+
+#include <gdal.h>
+#include <gdal_utils.h>
+#include <cpl_conv.h>
+
+#include <osgEarth/GDAL>
+#include <osgEarth/Registry>
+
+#include "osg-qt6/bench.hpp"
+#include "osg-qt6/geotiff-layer.hpp"
+
+namespace osg_qt6 {
+
+// gdal_translate + gdaladdo: a tiled copy of `source` with `compress` (NONE or LZW) and internal
+// overviews, all in 256x256 tiles.
+inline bool writeTiledCopy(const std::string& source, const std::string& path, const char* compress) {
+	GDALDatasetH src = GDALOpen(source.c_str(), GA_ReadOnly);
+
+	if(!src) return false;
+
+	std::string compression = std::string("COMPRESS=") + compress;
+
+	const char* args[] = {
+		"-of", "GTiff",
+		"-co", "TILED=YES",
+		"-co", "BLOCKXSIZE=256",
+		"-co", "BLOCKYSIZE=256",
+		"-co", compression.c_str(),
+		nullptr
+	};
+
+	GDALTranslateOptions* options = GDALTranslateOptionsNew(const_cast<char**>(args), nullptr);
+	GDALDatasetH dst = GDALTranslate(path.c_str(), src, options, nullptr);
+
+	GDALTranslateOptionsFree(options);
+	GDALClose(src);
+
+	if(!dst) return false;
+
+	// NOTE: Overview tiles default to 128x128; matching the base keeps one key per tile.
+	CPLSetConfigOption("GDAL_TIFF_OVR_BLOCKSIZE", "256");
+
+	int factors[] = {2, 4, 8};
+	bool ok = GDALBuildOverviews(dst, "AVERAGE", 3, factors, 0, nullptr, nullptr, nullptr) == CE_None;
+
+	GDALClose(dst);
+
+	return ok;
+}
+
+// Every key of LODs 0 through `maxLevel`.
+inline std::vector<osgEarth::TileKey> allKeys(const osgEarth::Profile* profile, unsigned int maxLevel) {
+	std::vector<osgEarth::TileKey> keys;
+
+	for(unsigned int lod = 0; lod <= maxLevel; lod++) {
+		unsigned int wide = 0;
+		unsigned int high = 0;
+
+		profile->getNumTiles(lod, wide, high);
+
+		for(unsigned int y = 0; y < high; y++) for(unsigned int x = 0; x < wide; x++) {
+			keys.emplace_back(lod, x, y, profile);
+		}
+	}
+
+	return keys;
+}
+
+// One pass over `keys` from `threads` threads; returns tiles/s, or 0 if any key failed.
+template<typename F>
+double readAll(const std::vector<osgEarth::TileKey>& keys, int threads, F read) {
+	std::atomic<size_t> next = 0;
+	std::atomic<size_t> failed = 0;
+
+	QElapsedTimer clock;
+
+	clock.start();
+
+	std::vector<std::thread> workers;
+
+	for(int i = 0; i < threads; i++) workers.emplace_back([&]() {
+		for(size_t k = next++; k < keys.size(); k = next++) if(!read(keys[k])) failed++;
+	});
+
+	for(auto& worker : workers) worker.join();
+
+	return failed ? 0.0 : keys.size() / (clock.nsecsElapsed() / 1.0e9);
+}
+
+}
+
+QJsonObject runLayer(const QString& kind, const QString& path, unsigned int maxLevel, int threads, int decodeThreads) {
+	QJsonObject result{{"layer", kind}, {"image", path}};
+
+	auto createMapped = [&]() {
+		osg::ref_ptr<MappedGeoTIFFLayer> mapped = new MappedGeoTIFFLayer();
+
+		mapped->setPath(path.toStdString());
+		mapped->setDecodeThreads(decodeThreads);
+		mapped->setMaxTiles(1024);
+
+		return mapped;
+	};
+
+	osg::ref_ptr<osgEarth::ImageLayer> layer;
+
+	if(kind == "gdal") {
+		auto* gdal = new osgEarth::GDALImageLayer();
+
+		gdal->setURL(path.toStdString());
+
+		layer = gdal;
+	}
+
+	else layer = createMapped();
+
+	QElapsedTimer clock;
+
+	clock.start();
+
+	if(const osgEarth::Status& status = layer->open(); status.isError()) {
+		result["error"] = QString::fromStdString(status.message());
+
+		return result;
+	}
+
+	result["open_ms"] = clock.nsecsElapsed() / 1.0e6;
+
+	auto keys = osg_qt6::allKeys(layer->getProfile(), maxLevel);
+
+	auto readImage = [&](const osgEarth::TileKey& key) {
+		return layer->createImage(key).valid();
+	};
+
+	result["tiles"] = static_cast<qint64>(keys.size());
+	result["cold_tiles_per_s"] = osg_qt6::readAll(keys, threads, readImage);
+	result["warm_tiles_per_s"] = osg_qt6::readAll(keys, threads, readImage);
+
+	// NOTE: A fresh layer, so the texture pass's cold numbers aren't served from the image pass's
+	// tile cache.
+	if(kind == "mapped") {
+		auto mapped = createMapped();
+
+		if(const osgEarth::Status& status = mapped->open(); status.isError()) {
+			result["texture_error"] = QString::fromStdString(status.message());
+
+			return result;
+		}
+
+		auto readTexture = [&](const osgEarth::TileKey& key) {
+			return mapped->createTexture(key, nullptr).valid();
+		};
+
+		result["texture_cold_tiles_per_s"] = osg_qt6::readAll(keys, threads, readTexture);
+		result["texture_warm_tiles_per_s"] = osg_qt6::readAll(keys, threads, readTexture);
+		result["zero_copy_tiles"] = static_cast<qint64>(mapped->zeroCopyTiles());
+		result["decoded_tiles"] = static_cast<qint64>(mapped->decodedTiles());
+		result["assembled_keys"] = static_cast<qint64>(mapped->assembledKeys());
+	}
+
+	return result;
+}
+
+int main(int argc, char** argv) {
+	QCoreApplication app(argc, argv);
+	QCommandLineParser parser;
+
+	parser.addHelpOption();
+	parser.addOptions({
+		{"image", "The source GeoTIFF.", "path", "../world.tif"},
+		{"work-dir", "Where the tiled copies go (default: a temporary directory).", "path"},
+		{"max-level", "Deepest LOD read.", "lod", "4"},
+		{"threads", "Reader threads (default: 4, like osgEarth's loader).", "count", "4"},
+		{"decode-threads", "MappedGeoTIFFLayer's LZW decode threads.", "count", "4"}
+	});
+	parser.process(app);
+
+	osgEarth::initialize();
+
+	GDALAllRegister();
+
+	auto image = parser.value("image");
+	auto workDir = QDir(parser.isSet("work-dir") ? parser.value("work-dir") : QDir::temp().filePath("bench-geotiff"));
+	auto maxLevel = static_cast<unsigned int>(std::max(0, parser.value("max-level").toInt()));
+	auto threads = std::max(1, parser.value("threads").toInt());
+	auto decodeThreads = std::max(1, parser.value("decode-threads").toInt());
+
+	workDir.mkpath(".");
+
+	QJsonArray runs;
+
+	runs.append(runLayer("gdal", image, maxLevel, threads, decodeThreads));
+
+	for(const char* compress : {"NONE", "LZW"}) {
+		auto copy = workDir.filePath(QString("world-tiled-%1.tif").arg(QString(compress).toLower()));
+
+		if(!osg_qt6::writeTiledCopy(image.toStdString(), copy.toStdString(), compress)) {
+			runs.append(QJsonObject{{"image", copy}, {"error", "GDAL couldn't write it"}});
+
+			continue;
+		}
+
+		runs.append(runLayer("gdal", copy, maxLevel, threads, decodeThreads));
+		runs.append(runLayer("mapped", copy, maxLevel, threads, decodeThreads));
+	}
+
+	osg_qt6::writeJson({
+		{"bench", "geotiff"},
+		{"max_level", static_cast<int>(maxLevel)},
+		{"threads", threads},
+		{"decode_threads", decodeThreads},
+		{"runs", runs},
+		{"peak_rss_kb", static_cast<qint64>(osg_qt6::peakRssKb())}
+	});
+
+	return 0;
+}
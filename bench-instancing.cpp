@@ -0,0 +1,104 @@
+// Renders createSphereFieldScene() for a range of sphere counts, both as one instanced draw and the
+// original node-per-sphere way, orbiting the field, and reports build time and cull/draw/GPU
+// percentiles for each:
+//
+//   QT_QPA_PLATFORM=offscreen ./bench-instancing --counts 1000,10000,100000,1000000
+//
+// The per-node variant is skipped above --max-per-node, since it stops being usable long before 1M.
+
+#include <cmath>
+
+#include <QGuiApplication>
+#include <QElapsedTimer>
+#include <QCommandLineParser>
+#include <QJsonArray>
+
+#include "osg-qt6/bench.hpp"
+#include "osg-qt6/offscreen.hpp"
+#include "osg-qt6/scenes.hpp"
+
+QJsonObject runCount(size_t count, bool instanced, int frames) {
+	osg_qt6::OffscreenViewer offscreen(1280, 720);
+
+	auto* viewer = offscreen.viewer();
+	auto rssBefore = osg_qt6::currentRssKb();
+
+	QElapsedTimer clock;
+
+	clock.start();
+
+	osg::ref_ptr<osg::Group> root = osg_qt6::createSphereFieldScene(count, instanced);
+
+	auto buildMs = clock.nsecsElapsed() / 1.0e6;
+	auto radius = root->getBound().radius() * 1.5;
+
+	viewer->setSceneData(root);
+
+	osg_qt6::FrameStats stats;
+
+	stats.enable(viewer);
+
+	for(int i = 0; i < frames; i++) {
+		double a = 2.0 * osg::PI * i / frames;
+
+		viewer->getCamera()->setViewMatrixAsLookAt(
+			osg::Vec3d(radius * std::cos(a), radius * std::sin(a), 0.3 * radius),
+			osg::Vec3d(),
+			osg::Vec3d(0.0, 0.0, 1.0)
+		);
+
+		offscreen.frame();
+
+		auto frameNumber = viewer->getViewerFrameStamp()->getFrameNumber();
+
+		if(frameNumber >= osg_qt6::FrameStats::LAG) stats.collect(viewer, frameNumber - osg_qt6::FrameStats::LAG);
+	}
+
+	offscreen.finish();
+
+	stats.collectRemaining(viewer);
+
+	return {
+		{"count", static_cast<qint64>(count)},
+		{"mode", instanced ? "instanced" : "per-node"},
+		{"build_ms", buildMs},
+		{"rss_delta_kb", static_cast<qint64>(osg_qt6::currentRssKb() - rssBefore)},
+		{"cull_ms", stats.phase("cull").toJson()},
+		{"draw_ms", stats.phase("draw").toJson()},
+		{"gpu_ms", stats.phase("gpu").toJson()}
+	};
+}
+
+int main(int argc, char** argv) {
+	QGuiApplication app(argc, argv);
+	QCommandLineParser parser;
+
+	parser.addHelpOption();
+	parser.addOptions({
+		{"counts", "Comma-separated sphere counts.", "list", "1000,10000,100000,1000000"},
+		{"frames", "Frames rendered per count and mode.", "count", "200"},
+		{"max-per-node", "Largest count also built node-per-sphere.", "count", "100000"}
+	});
+	parser.process(app);
+
+	auto frames = std::max(1, parser.value("frames").toInt());
+	auto maxPerNode = parser.value("max-per-node").toULongLong();
+
+	QJsonArray runs;
+
+	for(const auto& value : parser.value("counts").split(',')) {
+		auto count = static_cast<size_t>(value.toULongLong());
+
+		runs.append(runCount(count, true, frames));
+
+		if(count <= maxPerNode) runs.append(runCount(count, false, frames));
+	}
+
+	osg_qt6::writeJson({
+		{"bench", "instancing"},
+		{"runs", runs},
+		{"peak_rss_kb", static_cast<qint64>(osg_qt6::peakRssKb())}
+	});
+
+	return 0;
+}
@@ -0,0 +1,165 @@
+// Labels N random points on the example-osgearth map (10k, 50k and 100k by default) and renders a
+// slowly panning global view, once through a LabelLayer (grid decluttering on its worker thread)
+// and once as PlaceNodes with osgEarth's own decluttering on, reporting add time, frame phases and,
+// for the layer, the declutter pass's time and how many labels it kept:
+//
+//   QT_QPA_PLATFORM=offscreen ./bench-labels --counts 10000,50000,100000 --frames 300
+//
+// NOTE: PlaceNodes at 100k take a long while to even create; `--modes layer` skips them.
+
+#include <random>
+
+#include <QGuiApplication>
+#include <QElapsedTimer>
+#include <QCommandLineParser>
+#include <QJsonArray>
+
+#include <osgEarth/MapNode>
+#include <osgEarth/EarthManipulator>
+#include <osgEarth/ExampleResources>
+#include <osgEarth/PlaceNode>
+#include <osgEarth/ScreenSpaceLayout>
+
+#include "osg-qt6/bench.hpp"
+#include "osg-qt6/earth-scenes.hpp"
+#include "osg-qt6/label-layer.hpp"
+#include "osg-qt6/offscreen.hpp"
+
+QJsonObject runMode(const QString& mode, int count, int frames) {
+	osg_qt6::OffscreenViewer offscreen(1280, 720);
+
+	auto* viewer = offscreen.viewer();
+	auto* node = osg_qt6::createGridMapNode();
+	auto* manip = new osgEarth::EarthManipulator();
+
+	viewer->setCameraManipulator(manip);
+	viewer->setSceneData(node);
+
+	osgEarth::MapNodeHelper().configureView(viewer);
+
+	osgEarth::ScreenSpaceLayout::setDeclutteringEnabled(mode == "placenode");
+
+	// Same seed for both modes, so both label the exact same points.
+	std::mt19937 rng(1234);
+	std::uniform_real_distribution<double> lon(-180.0, 180.0);
+	std::uniform_real_distribution<double> lat(-85.0, 85.0);
+	std::uniform_real_distribution<float> priority(0.0f, 1.0f);
+
+	auto rssBefore = osg_qt6::currentRssKb();
+
+	QElapsedTimer clock;
+
+	clock.start();
+
+	osg::ref_ptr<osg_qt6::LabelLayer> layer;
+
+	if(mode == "placenode") {
+		osgEarth::Style style;
+
+		auto* ts = style.getOrCreate<osgEarth::TextSymbol>();
+
+		ts->size() = 16.0;
+		ts->halo() = osgEarth::Color("#000000");
+		ts->fill() = osgEarth::Color::White;
+		ts->alignment() = osgEarth::TextSymbol::ALIGN_LEFT_CENTER;
+		ts->declutter() = true;
+
+		for(int i = 0; i < count; i++) {
+			osgEarth::GeoPoint gp(node->getMapSRS(), lon(rng), lat(rng), 0.0, osgEarth::ALTMODE_ABSOLUTE);
+
+			auto* place = new osgEarth::PlaceNode(gp, "label " + std::to_string(i), style);
+
+			place->setPriority(priority(rng));
+
+			node->addChild(place);
+		}
+	}
+
+	else {
+		layer = new osg_qt6::LabelLayer();
+
+		for(int i = 0; i < count; i++) {
+			osgEarth::GeoPoint gp(node->getMapSRS(), lon(rng), lat(rng), 0.0, osgEarth::ALTMODE_ABSOLUTE);
+
+			layer->add(gp, "label " + std::to_string(i), priority(rng));
+		}
+
+		node->addChild(layer.get());
+	}
+
+	auto addMs = clock.nsecsElapsed() / 1.0e6;
+
+	osg_qt6::FrameStats stats;
+	osg_qt6::Samples declutterMs;
+	osg_qt6::Samples visible;
+
+	stats.enable(viewer);
+
+	for(int i = 0; i < frames; i++) {
+		manip->setViewpoint(osgEarth::Viewpoint("pan", -180.0 + 360.0 * i / frames, 20.0, 0.0, 0.0, -90.0, 1.5e7));
+
+		offscreen.frame();
+
+		if(layer.valid()) {
+			declutterMs.add(layer->declutter().stats().ms);
+			visible.add(static_cast<double>(layer->declutter().stats().visible));
+		}
+
+		auto frameNumber = viewer->getViewerFrameStamp()->getFrameNumber();
+
+		if(frameNumber >= osg_qt6::FrameStats::LAG) stats.collect(viewer, frameNumber - osg_qt6::FrameStats::LAG);
+	}
+
+	offscreen.finish();
+
+	stats.collectRemaining(viewer);
+
+	QJsonObject result{
+		{"mode", mode},
+		{"count", count},
+		{"add_ms", addMs},
+		{"rss_delta_kb", static_cast<qint64>(osg_qt6::currentRssKb() - rssBefore)},
+		{"phases_ms", stats.toJson()}
+	};
+
+	if(layer.valid()) {
+		result["declutter_ms"] = declutterMs.toJson();
+		result["visible_labels"] = visible.toJson();
+	}
+
+	return result;
+}
+
+int main(int argc, char** argv) {
+	QGuiApplication app(argc, argv);
+	QCommandLineParser parser;
+
+	parser.addHelpOption();
+	parser.addOptions({
+		{"counts", "Comma-separated label counts.", "counts", "10000,50000,100000"},
+		{"frames", "Frames rendered per run.", "count", "300"},
+		{"modes", "Comma-separated: layer, placenode.", "modes", "layer,placenode"}
+	});
+	parser.process(app);
+
+	osgEarth::initialize();
+
+	auto frames = std::max(1, parser.value("frames").toInt());
+
+	QJsonArray runs;
+
+	for(const auto& count : parser.value("counts").split(',', Qt::SkipEmptyParts)) {
+		for(const auto& mode : parser.value("modes").split(',', Qt::SkipEmptyParts)) {
+			runs.append(runMode(mode, count.toInt(), frames));
+		}
+	}
+
+	osg_qt6::writeJson({
+		{"bench", "labels"},
+		{"frames", frames},
+		{"runs", runs},
+		{"peak_rss_kb", static_cast<qint64>(osg_qt6::peakRssKb())}
+	});
+
+	return 0;
+}
@@ -0,0 +1,165 @@
+// Replays a simulated display (a vsync every 1/hz seconds, frames of random cost with the odd spike
+// that misses one, and late, noisy swap notifications) through three ways of scheduling and timing
+// frames, and reports how evenly animation advances in each:
+//
+//   timer:      a 16ms QTimer starts frames; osgViewer is timed by the wall clock (the old default)
+//   swap-wall:  frameSwapped starts frames; still timed by the wall clock
+//   swap-paced: frameSwapped starts frames; timed by FramePacer's predicted presentation time
+//
+//   ./bench-pacing --frames 10000 --hz 60 --spike-rate 0.02
+//
+// "judder_ms" is how far each frame's animation step is from the time that actually passed on
+// screen since the previous frame; zero means motion is exactly as smooth as the display allows.
+// No GL (or display) involved.
+
+#include <cmath>
+#include <random>
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+
+#include "osg-qt6/bench.hpp"
+#include "osg-qt6/frame-pacer.hpp"
+
+namespace osg_qt6 {
+
+struct SimulatedDisplay {
+	double period = 1.0 / 60.0;
+	double costMean = 0.008;
+	double costJitter = 0.002;
+	double spikeRate = 0.02;
+	double spikeCost = 0.020;
+
+	// How late (and how unevenly) the swap notification and the next paint get to run.
+	double notifyJitter = 0.0005;
+	double dispatchJitter = 0.001;
+
+	std::mt19937 random{1};
+
+	double cost() {
+		std::normal_distribution<double> normal(costMean, costJitter);
+		std::uniform_real_distribution<double> uniform(0.0, 1.0);
+
+		return std::max(0.001, normal(random)) + (uniform(random) < spikeRate ? spikeCost : 0.0);
+	}
+
+	double jitter(double amount) {
+		return std::uniform_real_distribution<double>(0.0, amount)(random);
+	}
+
+	// The first vsync at or after `t`, but never the one `previous` was already shown on.
+	double present(double t, double previous) {
+		double v = std::ceil(t / period) * period;
+
+		return v <= previous + period * 0.5 ? previous + period : v;
+	}
+};
+
+struct PacingResult {
+	Samples animationStep;
+	Samples presentedStep;
+	Samples judder;
+
+	QJsonObject toJson() {
+		return {
+			{"animation_step_ms", animationStep.toJson()},
+			{"animation_step_variance", animationStep.variance()},
+			{"presented_step_ms", presentedStep.toJson()},
+			{"judder_ms", judder.toJson()}
+		};
+	}
+};
+
+enum class Pacing {
+	TIMER,
+	SWAP_WALL,
+	SWAP_PACED
+};
+
+inline PacingResult simulatePacing(SimulatedDisplay display, Pacing pacing, int frames) {
+	PacingResult result;
+	FramePacer pacer;
+
+	double start = 0.0;
+	double presented = 0.0;
+	double notified = 0.0;
+	double previousTime = 0.0;
+	double previousPresented = 0.0;
+
+	for(int i = 0; i < frames; i++) {
+		if(pacing == Pacing::TIMER) {
+			// NOTE: A 16ms timer can't start a frame until the last one is done rendering, and
+			// drifts against a 16.67ms display.
+			start = std::max(i * 0.016, start) + display.jitter(display.dispatchJitter);
+		}
+
+		else if(i) start = notified + display.jitter(display.dispatchJitter);
+
+		double time = pacing == Pacing::SWAP_PACED ? pacer.next(start) : start;
+
+		presented = display.present(start + display.cost(), presented);
+		notified = presented + display.jitter(display.notifyJitter);
+
+		if(pacing == Pacing::TIMER) start = std::max(start, presented);
+
+		pacer.presented(notified);
+
+		if(i) {
+			double animationStep = (time - previousTime) * 1000.0;
+			double presentedStep = (presented - previousPresented) * 1000.0;
+
+			result.animationStep.add(animationStep);
+			result.presentedStep.add(presentedStep);
+			result.judder.add(std::abs(animationStep - presentedStep));
+		}
+
+		previousTime = time;
+		previousPresented = presented;
+	}
+
+	return result;
+}
+
+}
+
+int main(int argc, char** argv) {
+	QCoreApplication app(argc, argv);
+	QCommandLineParser parser;
+
+	parser.addHelpOption();
+	parser.addOptions({
+		{"frames", "Frames simulated per mode.", "count", "10000"},
+		{"hz", "Display refresh rate.", "hz", "60"},
+		{"cost-ms", "Mean frame cost.", "ms", "8"},
+		{"spike-rate", "Fraction of frames that take an extra --spike-ms.", "fraction", "0.02"},
+		{"spike-ms", "Extra cost of a spike frame.", "ms", "20"},
+		{"seed", "Random seed.", "n", "1"}
+	});
+	parser.process(app);
+
+	osg_qt6::SimulatedDisplay display;
+
+	display.period = 1.0 / std::max(1.0, parser.value("hz").toDouble());
+	display.costMean = parser.value("cost-ms").toDouble() / 1000.0;
+	display.spikeRate = parser.value("spike-rate").toDouble();
+	display.spikeCost = parser.value("spike-ms").toDouble() / 1000.0;
+	display.random.seed(parser.value("seed").toUInt());
+
+	auto frames = std::max(2, parser.value("frames").toInt());
+
+	// NOTE: Each mode gets a copy of the same display (and random sequence).
+	auto timer = osg_qt6::simulatePacing(display, osg_qt6::Pacing::TIMER, frames);
+	auto swapWall = osg_qt6::simulatePacing(display, osg_qt6::Pacing::SWAP_WALL, frames);
+	auto swapPaced = osg_qt6::simulatePacing(display, osg_qt6::Pacing::SWAP_PACED, frames);
+
+	osg_qt6::writeJson({
+		{"bench", "pacing"},
+		{"frames", frames},
+		{"hz", 1.0 / display.period},
+		{"timer", timer.toJson()},
+		{"swap_wall", swapWall.toJson()},
+		{"swap_paced", swapPaced.toJson()}
+	});
+
+	return 0;
+}
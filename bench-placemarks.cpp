@@ -0,0 +1,158 @@
+// Adds N placemarks at random positions to the example-osgearth map, once as a PlaceNode per point
+// (exactly what ClickToLatLonHandler::addIcon used to do) and once through a single PlacemarkLayer,
+// then renders a fixed global view and reports add time, memory and per-phase frame timings:
+//
+//   QT_QPA_PLATFORM=offscreen ./bench-placemarks --count 100000 --frames 200
+
+#include <random>
+
+#include <QGuiApplication>
+#include <QElapsedTimer>
+#include <QCommandLineParser>
+#include <QJsonArray>
+
+#include <osgEarth/MapNode>
+#include <osgEarth/EarthManipulator>
+#include <osgEarth/ExampleResources>
+#include <osgEarth/PlaceNode>
+
+#include "osg-qt6/bench.hpp"
+#include "osg-qt6/earth-scenes.hpp"
+#include "osg-qt6/offscreen.hpp"
+#include "osg-qt6/placemark-layer.hpp"
+
+namespace osg_qt6 {
+
+// The original, one-PlaceNode-per-click approach; kept here only as the baseline.
+inline void addPlaceNode(osgEarth::MapNode* mapNode, const osgEarth::GeoPoint& gp) {
+	osgEarth::Style pm;
+
+	auto* is = pm.getOrCreate<osgEarth::IconSymbol>();
+	auto scale = 0.5;
+
+	is->url().mutable_value().setLiteral("../blackdot.png");
+	is->declutter() = false;
+	is->scale() = scale;
+	is->alignment() = osgEarth::IconSymbol::ALIGN_CENTER_CENTER;
+
+	auto* ts = pm.getOrCreate<osgEarth::TextSymbol>();
+
+	ts->size() = 96.0 * scale;
+	ts->halo() = osgEarth::Color("#000000");
+	ts->fill() = osgEarth::Color::White;
+	ts->alignment() = osgEarth::TextSymbol::ALIGN_LEFT_CENTER;
+
+	mapNode->addChild(new osgEarth::PlaceNode(gp, "foo", pm));
+}
+
+}
+
+QJsonObject runMode(const QString& mode, int count, int frames) {
+	osg_qt6::OffscreenViewer offscreen(1280, 720);
+
+	auto* viewer = offscreen.viewer();
+	auto* node = osg_qt6::createGridMapNode();
+	auto* manip = new osgEarth::EarthManipulator();
+
+	viewer->setCameraManipulator(manip);
+	viewer->setSceneData(node);
+
+	osgEarth::MapNodeHelper().configureView(viewer);
+
+	manip->setViewpoint(osgEarth::Viewpoint("global", 0.0, 20.0, 0.0, 0.0, -90.0, 2.0e7));
+
+	// Same seed for both modes, so both place the exact same points.
+	std::mt19937 rng(1234);
+	std::uniform_real_distribution<double> lon(-180.0, 180.0);
+	std::uniform_real_distribution<double> lat(-85.0, 85.0);
+
+	auto rssBefore = osg_qt6::currentRssKb();
+
+	QElapsedTimer clock;
+
+	clock.start();
+
+	if(mode == "placenode") {
+		for(int i = 0; i < count; i++) osg_qt6::addPlaceNode(
+			node,
+			osgEarth::GeoPoint(node->getMapSRS(), lon(rng), lat(rng), 0.0, osgEarth::ALTMODE_ABSOLUTE)
+		);
+	}
+
+	else {
+		auto* layer = new osg_qt6::PlacemarkLayer();
+
+		for(int i = 0; i < count; i++) layer->add(
+			osgEarth::GeoPoint(node->getMapSRS(), lon(rng), lat(rng), 0.0, osgEarth::ALTMODE_ABSOLUTE)
+		);
+
+		node->addChild(layer);
+	}
+
+	auto addMs = clock.nsecsElapsed() / 1.0e6;
+
+	osg_qt6::FrameStats stats;
+
+	stats.enable(viewer);
+
+	clock.restart();
+
+	offscreen.frame();
+	offscreen.finish();
+
+	auto firstFrameMs = clock.nsecsElapsed() / 1.0e6;
+
+	for(int i = 0; i < frames; i++) {
+		offscreen.frame();
+
+		auto frameNumber = viewer->getViewerFrameStamp()->getFrameNumber();
+
+		if(frameNumber >= osg_qt6::FrameStats::LAG) stats.collect(viewer, frameNumber - osg_qt6::FrameStats::LAG);
+	}
+
+	offscreen.finish();
+
+	stats.collectRemaining(viewer);
+
+	return {
+		{"mode", mode},
+		{"add_ms", addMs},
+		{"add_us_per_point", addMs * 1000.0 / std::max(count, 1)},
+		{"first_frame_ms", firstFrameMs},
+		{"rss_delta_kb", static_cast<qint64>(osg_qt6::currentRssKb() - rssBefore)},
+		{"phases_ms", stats.toJson()}
+	};
+}
+
+int main(int argc, char** argv) {
+	QGuiApplication app(argc, argv);
+	QCommandLineParser parser;
+
+	parser.addHelpOption();
+	parser.addOptions({
+		{"count", "Number of placemarks.", "count", "100000"},
+		{"frames", "Frames rendered per mode.", "count", "200"},
+		{"mode", "placenode, layer or both.", "mode", "both"}
+	});
+	parser.process(app);
+
+	osgEarth::initialize();
+
+	auto count = parser.value("count").toInt();
+	auto frames = parser.value("frames").toInt();
+	auto mode = parser.value("mode");
+
+	QJsonArray modes;
+
+	if(mode != "layer") modes.append(runMode("placenode", count, frames));
+	if(mode != "placenode") modes.append(runMode("layer", count, frames));
+
+	osg_qt6::writeJson({
+		{"bench", "placemarks"},
+		{"count", count},
+		{"modes", modes},
+		{"peak_rss_kb", static_cast<qint64>(osg_qt6::peakRssKb())}
+	});
+
+	return 0;
+}
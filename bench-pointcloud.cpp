@@ -0,0 +1,135 @@
+// Streams an .opc point cloud (see tool-pointcloud) through PointCloudNode offscreen: reports how
+// long until the first view is fully refined, then orbits and reports frame times and how many
+// points each frame actually drew under the GPU budget:
+//
+//   QT_QPA_PLATFORM=offscreen ./bench-pointcloud --file synthetic.opc --budget-mb 512
+//   QT_QPA_PLATFORM=offscreen ./bench-pointcloud --generate 20000000
+
+#include <cmath>
+
+#include <QGuiApplication>
+#include <QElapsedTimer>
+#include <QCommandLineParser>
+#include <QDir>
+
+#include "osg-qt6/bench.hpp"
+#include "osg-qt6/offscreen.hpp"
+#include "osg-qt6/point-cloud.hpp"
+
+int main(int argc, char** argv) {
+	QGuiApplication app(argc, argv);
+	QCommandLineParser parser;
+
+	parser.addHelpOption();
+	parser.addOptions({
+		{"file", "The .opc file to stream.", "path"},
+		{"generate", "Without --file, generate (and index) this many synthetic points first.", "count", "10000000"},
+		{"budget-mb", "GPU vertex data budget.", "MiB", "512"},
+		{"max-error", "Screen-space error (pixels) to refine to.", "pixels", "2.0"},
+		{"frames", "Frames rendered while orbiting.", "count", "300"}
+	});
+	parser.process(app);
+
+	QString path = parser.value("file");
+
+	if(path.isEmpty()) {
+		path = QDir::temp().filePath("bench-pointcloud.opc");
+
+		auto points = osg_qt6::createSyntheticPoints(parser.value("generate").toULongLong());
+
+		if(!osg_qt6::writePointCloud(path.toStdString(), points, osg::Vec3d())) {
+			OSG_FATAL << "bench-pointcloud: couldn't write " << path.toStdString() << std::endl;
+
+			return 1;
+		}
+	}
+
+	osg_qt6::OffscreenViewer offscreen(1280, 720);
+
+	auto* viewer = offscreen.viewer();
+
+	QElapsedTimer clock;
+
+	clock.start();
+
+	osg::ref_ptr<osg_qt6::PointCloudNode> cloud = new osg_qt6::PointCloudNode(
+		path,
+		static_cast<size_t>(parser.value("budget-mb").toULongLong()) << 20,
+		parser.value("max-error").toFloat()
+	);
+
+	if(!cloud->valid()) {
+		OSG_FATAL << "bench-pointcloud: not a valid .opc file: " << path.toStdString() << std::endl;
+
+		return 1;
+	}
+
+	auto openMs = clock.nsecsElapsed() / 1.0e6;
+
+	viewer->setSceneData(cloud);
+
+	osg::BoundingSphere bs = cloud->getBound();
+
+	auto orbit = [&](double t) {
+		double a = 2.0 * osg::PI * t;
+		double r = bs.radius() * 1.2;
+
+		viewer->getCamera()->setViewMatrixAsLookAt(
+			bs.center() + osg::Vec3d(r * std::cos(a), r * std::sin(a), 0.5 * r),
+			bs.center(),
+			osg::Vec3d(0.0, 0.0, 1.0)
+		);
+	};
+
+	orbit(0.0);
+
+	offscreen.frame();
+	offscreen.finish();
+
+	auto firstFrameMs = clock.nsecsElapsed() / 1.0e6;
+
+	// Keep rendering the same view until everything it wants is loaded and drawn.
+	int settleFrames = 0;
+
+	while(!cloud->idle() && settleFrames++ < 100000) offscreen.frame();
+
+	offscreen.finish();
+
+	auto settledMs = clock.nsecsElapsed() / 1.0e6;
+	auto frames = std::max(1, parser.value("frames").toInt());
+
+	osg_qt6::Samples wall;
+	osg_qt6::Samples drawn;
+	osg_qt6::Samples missing;
+
+	for(int i = 0; i < frames; i++) {
+		orbit(static_cast<double>(i) / frames);
+
+		clock.restart();
+
+		offscreen.frame();
+
+		wall.add(clock.nsecsElapsed() / 1.0e6);
+		drawn.add(static_cast<double>(cloud->drawnPoints()));
+		missing.add(static_cast<double>(cloud->missingNodes()));
+	}
+
+	offscreen.finish();
+
+	osg_qt6::writeJson({
+		{"bench", "pointcloud"},
+		{"file", path},
+		{"total_points", static_cast<qint64>(cloud->totalPoints())},
+		{"open_ms", openMs},
+		{"first_frame_ms", firstFrameMs},
+		{"settled_ms", settledMs},
+		{"settle_frames", settleFrames},
+		{"frame_ms", wall.toJson()},
+		{"drawn_points", drawn.toJson()},
+		{"missing_nodes", missing.toJson()},
+		{"resident_mb", static_cast<double>(cloud->residentBytes()) / (1 << 20)},
+		{"peak_rss_kb", static_cast<qint64>(osg_qt6::peakRssKb())}
+	});
+
+	return 0;
+}
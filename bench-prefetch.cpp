@@ -0,0 +1,130 @@
+// Times the example-osgearth-interactive Space fly-to (from a whole-globe view down to 5km over
+// Maryland) with and without TilePrefetcher, and reports how long after landing the terrain took to
+// stop asking for tiles over the destination (i.e., to reach full resolution):
+//
+//   QT_QPA_PLATFORM=offscreen ./bench-prefetch --modes off,on --flight-s 1
+//
+// Each run gets a fresh viewer and MapNode (so no in-memory tiles carry over), but GDAL still reads
+// world.tif through the OS file cache; --modes order is the run order, so alternate them
+// (`off,on,off,on`) for a fair comparison.
+
+#include <QGuiApplication>
+#include <QElapsedTimer>
+#include <QCommandLineParser>
+#include <QJsonArray>
+
+#include <osgEarth/EarthManipulator>
+#include <osgEarth/ExampleResources>
+
+#include "osg-qt6/bench.hpp"
+#include "osg-qt6/earth-scenes.hpp"
+#include "osg-qt6/offscreen.hpp"
+#include "osg-qt6/tile-prefetch.hpp"
+
+int main(int argc, char** argv) {
+	QGuiApplication app(argc, argv);
+	QCommandLineParser parser;
+
+	parser.addHelpOption();
+	parser.addOptions({
+		{"modes", "Comma-separated runs: off, on.", "modes", "off,on"},
+		{"flight-s", "Duration of the fly-to.", "seconds", "1"},
+		{"settle-s", "Time spent at the starting view before flying.", "seconds", "3"},
+		{"timeout-s", "Give up waiting for full resolution after this long.", "seconds", "30"},
+		{"threads", "Prefetch threads.", "count", "2"},
+		{"width", "Framebuffer width.", "pixels", "1280"},
+		{"height", "Framebuffer height.", "pixels", "720"}
+	});
+	parser.process(app);
+
+	auto flightS = parser.value("flight-s").toDouble();
+	auto settleMs = parser.value("settle-s").toDouble() * 1000.0;
+	auto timeoutMs = parser.value("timeout-s").toDouble() * 1000.0;
+
+	osgEarth::initialize();
+
+	const osgEarth::Viewpoint start("start", -100.0, 40.0, 0.0, 0.0, -90.0, 1.5e7);
+	const osgEarth::Viewpoint target = osg_qt6::FlyToHandler::target();
+
+	QJsonArray runs;
+
+	for(const auto& mode : parser.value("modes").split(',', Qt::SkipEmptyParts)) {
+		osg_qt6::OffscreenViewer offscreen(parser.value("width").toInt(), parser.value("height").toInt());
+
+		if(!offscreen.valid()) {
+			OSG_FATAL << "bench-prefetch: couldn't create an offscreen GL context/FBO" << std::endl;
+
+			return 1;
+		}
+
+		auto* viewer = offscreen.viewer();
+		auto* node = osg_qt6::createWorldMapNode("", true);
+		auto* manip = new osgEarth::EarthManipulator();
+
+		viewer->setCameraManipulator(manip);
+		viewer->setSceneData(node);
+
+		osgEarth::MapNodeHelper().configureView(viewer);
+
+		auto* layer = node->getMap()->getLayer<PrefetchImageLayer>();
+
+		osg_qt6::TilePrefetcher prefetcher(layer, static_cast<unsigned int>(std::max(1, parser.value("threads").toInt())));
+
+		QElapsedTimer clock;
+
+		manip->setViewpoint(start);
+
+		for(clock.start(); clock.elapsed() < settleMs;) offscreen.frame();
+
+		if(mode == "on") prefetcher.prefetchFlight(manip->getViewpoint(), target, viewer->getCamera());
+
+		manip->setViewpoint(target, flightS);
+
+		osg_qt6::Samples flight;
+		QElapsedTimer frame;
+
+		clock.start();
+
+		// NOTE: The first frame is what starts the manipulator's animation.
+		do {
+			frame.start();
+
+			offscreen.frame();
+			offscreen.finish();
+
+			flight.add(frame.nsecsElapsed() / 1.0e6);
+		} while(manip->isSettingViewpoint());
+
+		auto flightMs = clock.nsecsElapsed() / 1.0e6;
+
+		prefetcher.landed(manip->getViewpoint(), viewer->getCamera());
+
+		double fullResolutionMs = -1.0;
+
+		for(clock.start(); fullResolutionMs < 0.0 && clock.elapsed() < timeoutMs;) {
+			offscreen.frame();
+
+			fullResolutionMs = prefetcher.takeFullResolutionMs();
+		}
+
+		runs.append(QJsonObject{
+			{"mode", mode},
+			{"flight_ms", flightMs},
+			{"flight_frame_ms", flight.toJson()},
+			{"time_to_full_res_ms", fullResolutionMs},
+			{"tiles_queued", static_cast<qint64>(prefetcher.queued())},
+			{"tiles_prefetched", static_cast<qint64>(prefetcher.prefetched())},
+			{"layer_hits", static_cast<qint64>(layer->hits())},
+			{"layer_misses", static_cast<qint64>(layer->misses())}
+		});
+	}
+
+	osg_qt6::writeJson({
+		{"bench", "prefetch"},
+		{"flight_s", flightS},
+		{"runs", runs},
+		{"peak_rss_kb", static_cast<qint64>(osg_qt6::peakRssKb())}
+	});
+
+	return 0;
+}
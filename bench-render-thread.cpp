@@ -0,0 +1,242 @@
+// Compares how responsive the QT GUI thread stays while osgViewer chews on a heavy scene, with the
+// frame loop on the GUI thread (the way every example works) vs. on a RenderThread. Meant to be run
+// headless against Mesa:
+//
+//   QT_QPA_PLATFORM=offscreen ./bench-render-thread --spheres 4000 --seconds 5 --threading draw
+//
+// "Latency" is how late a 5ms PreciseTimer on the GUI thread fires; with paintGL() doing the whole
+// frame it's roughly the frame time, with the RenderThread it should be ~the blit.
+
+#include <cmath>
+
+#include <QOpenGLWidget>
+#include <QOpenGLFunctions>
+#include <QApplication>
+#include <QMainWindow>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QTimer>
+#include <QJsonArray>
+#include <QCommandLineParser>
+
+#include <osg/Geode>
+#include <osg/MatrixTransform>
+#include <osg/ShapeDrawable>
+#include <osgGA/TrackballManipulator>
+#include <osgViewer/Viewer>
+
+#include "osg-qt6/frame-scheduler.hpp"
+#include "osg-qt6/render-thread.hpp"
+#include "osg-qt6/bench.hpp"
+
+namespace osg_qt6 {
+
+osg::Node* createHeavyScene(int count, float detail) {
+	osg::Group* root = new osg::Group();
+	osg::TessellationHints* hints = new osg::TessellationHints();
+
+	hints->setDetailRatio(detail);
+
+	int side = std::max(1, static_cast<int>(std::cbrt(static_cast<double>(count))));
+
+	for(int i = 0; i < count; i++) {
+		osg::Vec3 pos(
+			static_cast<float>(i % side),
+			static_cast<float>((i / side) % side),
+			static_cast<float>(i / (side * side))
+		);
+
+		osg::MatrixTransform* m = new osg::MatrixTransform(osg::Matrix::translate(pos * 3.0f));
+		osg::Geode* g = new osg::Geode();
+
+		g->addDrawable(new osg::ShapeDrawable(new osg::Sphere(osg::Vec3(), 1.0f), hints));
+
+		m->addChild(g);
+		root->addChild(m);
+	}
+
+	return root;
+}
+
+}
+
+class BenchWidget: public QOpenGLWidget {
+
+Q_OBJECT
+
+public:
+	BenchWidget(
+		osg::Node* scene,
+		bool renderThread,
+		osgViewer::ViewerBase::ThreadingModel threadingModel
+	):
+	_scene(scene),
+	_useRenderThread(renderThread),
+	_threadingModel(threadingModel) {
+		_scheduler = new osg_qt6::FrameScheduler(this);
+	}
+
+	~BenchWidget() override {
+		if(!_renderThread) return;
+
+		makeCurrent();
+
+		delete _renderThread;
+
+		doneCurrent();
+	}
+
+	unsigned long long framesRendered() const {
+		return _scheduler->framesRendered();
+	}
+
+protected:
+	void initializeGL() override {
+		_viewer = new osgViewer::Viewer();
+
+		if(!_useRenderThread) _viewer->setUpViewerAsEmbeddedInWindow(0, 0, width(), height());
+
+		_viewer->setSceneData(_scene);
+		_viewer->setCameraManipulator(new osgGA::TrackballManipulator());
+
+		// Keep osgViewer asking for frames; we want the worst case, not the idle one.
+		_viewer->requestContinuousUpdate(true);
+
+		_scheduler->setViewer(_viewer);
+
+		if(!_useRenderThread) return;
+
+		_renderThread = new osg_qt6::RenderThread(this, _viewer, _threadingModel);
+
+		_renderThread->setFrameReadyCallback([this]() {
+			QMetaObject::invokeMethod(this, [this]() {
+				_scheduler->frameRendered();
+
+				update();
+			}, Qt::QueuedConnection);
+		});
+
+		_scheduler->setRenderFunction([this]() {
+			_renderThread->requestFrame();
+		});
+
+		_scheduler->setDemandFunction([this]() {
+			return _renderThread->demand();
+		});
+
+		_renderThread->start();
+	}
+
+	void resizeGL(int w, int h) override {
+		if(_renderThread) {
+			_renderThread->resize(w, h);
+
+			return;
+		}
+
+		_viewer->getCamera()->setViewport(new osg::Viewport(0, 0, w, h));
+		_viewer->getCamera()->setProjectionMatrixAsPerspective(30.0f, static_cast<double>(w) / h, 1.0, 1000.0);
+	}
+
+	void paintGL() override {
+		if(_renderThread) {
+			_renderThread->composite();
+
+			return;
+		}
+
+		_viewer->frame();
+
+		_scheduler->frameRendered();
+	}
+
+private:
+	osg::ref_ptr<osg::Node> _scene;
+	osg::ref_ptr<osgViewer::Viewer> _viewer;
+
+	osg_qt6::FrameScheduler* _scheduler = nullptr;
+	osg_qt6::RenderThread* _renderThread = nullptr;
+
+	bool _useRenderThread = false;
+
+	osgViewer::ViewerBase::ThreadingModel _threadingModel = osgViewer::ViewerBase::SingleThreaded;
+};
+
+QJsonObject runMode(osg::Node* scene, bool renderThread, osgViewer::ViewerBase::ThreadingModel tm, int seconds) {
+	constexpr int probeInterval = 5;
+
+	QMainWindow window;
+
+	auto* widget = new BenchWidget(scene, renderThread, tm);
+
+	window.setCentralWidget(widget);
+	window.resize(1280, 720);
+	window.show();
+
+	osg_qt6::Samples latency;
+	QElapsedTimer clock;
+	QTimer probe;
+	QEventLoop loop;
+
+	probe.setTimerType(Qt::PreciseTimer);
+
+	QObject::connect(&probe, &QTimer::timeout, [&]() {
+		double elapsed = static_cast<double>(clock.nsecsElapsed()) / 1.0e6;
+
+		latency.add(std::max(0.0, elapsed - probeInterval));
+
+		clock.restart();
+	});
+
+	QTimer::singleShot(seconds * 1000, &loop, &QEventLoop::quit);
+
+	clock.start();
+	probe.start(probeInterval);
+	loop.exec();
+	probe.stop();
+
+	return {
+		{"mode", renderThread ? "render-thread" : "gui-thread"},
+		{"frames", static_cast<qint64>(widget->framesRendered())},
+		{"fps", static_cast<double>(widget->framesRendered()) / seconds},
+		{"gui_latency_ms", latency.toJson()}
+	};
+}
+
+int main(int argc, char** argv) {
+	QApplication app(argc, argv);
+	QCommandLineParser parser;
+
+	parser.addHelpOption();
+	parser.addOptions({
+		{"spheres", "Number of spheres in the scene.", "count", "4000"},
+		{"detail", "osg::TessellationHints detail ratio.", "ratio", "2.0"},
+		{"seconds", "Seconds to run each mode.", "seconds", "5"},
+		{"threading", "RenderThread threading model: single, cull-draw, draw.", "model", "draw"}
+	});
+	parser.process(app);
+
+	osg::ref_ptr<osg::Node> scene = osg_qt6::createHeavyScene(
+		parser.value("spheres").toInt(),
+		parser.value("detail").toFloat()
+	);
+
+	auto seconds = std::max(1, parser.value("seconds").toInt());
+	auto tm = osg_qt6::threadingModelFromString(parser.value("threading").toStdString());
+
+	QJsonArray modes;
+
+	modes.append(runMode(scene.get(), false, osgViewer::ViewerBase::SingleThreaded, seconds));
+	modes.append(runMode(scene.get(), true, tm, seconds));
+
+	osg_qt6::writeJson({
+		{"bench", "render-thread"},
+		{"spheres", parser.value("spheres").toInt()},
+		{"threading", parser.value("threading")},
+		{"modes", modes}
+	});
+
+	return 0;
+}
+
+#include "bench-render-thread.moc"
@@ -0,0 +1,140 @@
+// Replays an input recording (made with `--record` in either interactive example) offscreen on a
+// fixed simulated clock, so the same session yields comparable frame-time traces on every build:
+//
+//   ./example-osgearth-interactive --record session.oqin
+//   QT_QPA_PLATFORM=offscreen ./bench-replay --input session.oqin --scene osgearth-interactive --per-frame
+//
+// The camera moves exactly as it did when recorded; what the osgEarth scene has paged in at any
+// given frame still depends on how fast the loader threads were, though.
+
+#include <cmath>
+
+#include <QGuiApplication>
+#include <QElapsedTimer>
+#include <QCommandLineParser>
+#include <QJsonArray>
+
+#include <osgGA/TrackballManipulator>
+
+#include <osgEarth/EarthManipulator>
+#include <osgEarth/ExampleResources>
+
+#include "osg-qt6/bench.hpp"
+#include "osg-qt6/earth-scenes.hpp"
+#include "osg-qt6/input-recording.hpp"
+#include "osg-qt6/offscreen.hpp"
+#include "osg-qt6/scenes.hpp"
+
+int main(int argc, char** argv) {
+	QGuiApplication app(argc, argv);
+	QCommandLineParser parser;
+
+	parser.addHelpOption();
+	parser.addOptions({
+		{"input", "The recording to replay.", "path"},
+		{"scene", "Scene it was recorded against: osg, osgearth-interactive.", "name", "osg"},
+		{"hz", "Simulated frame rate.", "hz", "60"},
+		{"tail-frames", "Frames rendered after the last event (to let animation settle).", "count", "60"},
+		{"per-frame", "Include every frame's time, in order, in the output."}
+	});
+	parser.process(app);
+
+	osg_qt6::InputReplay replay;
+
+	if(!replay.open(parser.value("input").toStdString())) {
+		OSG_FATAL << "bench-replay: not a readable recording: " << parser.value("input").toStdString() << std::endl;
+
+		return 1;
+	}
+
+	int width = 1280;
+	int height = 720;
+
+	replay.initialSize(width, height);
+
+	osg_qt6::OffscreenViewer offscreen(width, height);
+
+	if(!offscreen.valid()) {
+		OSG_FATAL << "bench-replay: couldn't create an offscreen GL context/FBO" << std::endl;
+
+		return 1;
+	}
+
+	auto* viewer = offscreen.viewer();
+
+	if(parser.value("scene") == "osgearth-interactive") {
+		osgEarth::initialize();
+
+		viewer->setCameraManipulator(osg_qt6::createEarthManipulator());
+		viewer->addEventHandler(new osg_qt6::FlyToHandler());
+		viewer->setSceneData(osg_qt6::createWorldMapNode());
+
+		osgEarth::MapNodeHelper().configureView(viewer);
+	}
+
+	else {
+		viewer->setCameraManipulator(new osgGA::TrackballManipulator());
+		viewer->setSceneData(osg_qt6::createPointSphereScene());
+	}
+
+	osg_qt6::FrameStats stats;
+
+	stats.enable(viewer);
+
+	double dt = 1.0 / std::max(1.0, parser.value("hz").toDouble());
+	int frames = static_cast<int>(std::ceil(replay.duration() / dt)) + std::max(0, parser.value("tail-frames").toInt());
+
+	// NOTE: The first frame only initializes the viewer; the recording starts after it.
+	offscreen.frame(0.0);
+
+	osg_qt6::Samples wall;
+	QJsonArray perFrame;
+	QElapsedTimer clock;
+
+	size_t events = 0;
+
+	for(int i = 1; i <= frames; i++) {
+		double t = i * dt;
+
+		events += replay.advance(viewer->getEventQueue(), t);
+
+		clock.start();
+
+		offscreen.frame(t);
+
+		auto ms = clock.nsecsElapsed() / 1.0e6;
+
+		wall.add(ms);
+
+		if(parser.isSet("per-frame")) perFrame.append(ms);
+
+		auto frameNumber = viewer->getViewerFrameStamp()->getFrameNumber();
+
+		if(frameNumber >= osg_qt6::FrameStats::LAG) stats.collect(viewer, frameNumber - osg_qt6::FrameStats::LAG);
+	}
+
+	offscreen.finish();
+
+	stats.collectRemaining(viewer);
+
+	QJsonObject result{
+		{"bench", "replay"},
+		{"input", parser.value("input")},
+		{"scene", parser.value("scene")},
+		{"renderer", offscreen.renderer()},
+		{"width", width},
+		{"height", height},
+		{"events", static_cast<qint64>(events)},
+		{"duration_s", replay.duration()},
+		{"frames", frames},
+		{"frame_ms", wall.toJson()},
+		{"phases_ms", stats.toJson()},
+		{"peak_rss_kb", static_cast<qint64>(osg_qt6::peakRssKb())}
+	};
+
+	if(parser.isSet("per-frame")) result["per_frame_ms"] = perFrame;
+
+	osg_qt6::writeJson(result);
+
+	return 0;
+}
@@ -0,0 +1,143 @@
+// Cold vs. warm startup for a generated scene: "cold" builds it (createSphereFieldScene()) and
+// writes the .osgb snapshot, "warm" maps that snapshot back in (and, for comparison, reads it
+// through osgDB the ordinary way). Each then renders its first frame offscreen:
+//
+//   QT_QPA_PLATFORM=offscreen ./bench-snapshot --spheres 20000
+//   QT_QPA_PLATFORM=offscreen ./bench-snapshot --spheres 200000 --instanced
+
+#include <filesystem>
+
+#include <QGuiApplication>
+#include <QElapsedTimer>
+#include <QCommandLineParser>
+#include <QDir>
+
+#include "osg-qt6/bench.hpp"
+#include "osg-qt6/offscreen.hpp"
+#include "osg-qt6/scene-snapshot.hpp"
+#include "osg-qt6/scenes.hpp"
+
+namespace osg_qt6 {
+
+// Milliseconds to render `scene`'s first frame in a fresh offscreen viewer (the GL object
+// compilation a snapshot can't save).
+inline double firstFrameMs(osg::Node* scene) {
+	OffscreenViewer offscreen(1280, 720);
+
+	if(!offscreen.valid()) return -1.0;
+
+	auto* viewer = offscreen.viewer();
+	const auto& bs = scene->getBound();
+
+	viewer->setSceneData(scene);
+	viewer->getCamera()->setViewMatrixAsLookAt(
+		bs.center() + osg::Vec3d(0.0, -3.0 * bs.radius(), 0.0),
+		bs.center(),
+		osg::Vec3d(0.0, 0.0, 1.0)
+	);
+
+	QElapsedTimer clock;
+
+	clock.start();
+
+	offscreen.frame();
+	offscreen.finish();
+
+	return clock.nsecsElapsed() / 1.0e6;
+}
+
+}
+
+int main(int argc, char** argv) {
+	QGuiApplication app(argc, argv);
+	QCommandLineParser parser;
+
+	parser.addHelpOption();
+	parser.addOptions({
+		{"spheres", "Spheres in the generated scene.", "count", "20000"},
+		{"instanced", "Build the instanced field instead of one node per sphere."},
+		{"dir", "Snapshot directory (emptied of this scene's snapshot first).", "path"}
+	});
+	parser.process(app);
+
+	auto count = static_cast<size_t>(parser.value("spheres").toULongLong());
+	bool instanced = parser.isSet("instanced");
+
+	osg_qt6::SceneSnapshot snapshot(
+		parser.isSet("dir") ? parser.value("dir").toStdString() : QDir::temp().filePath("bench-snapshot").toStdString()
+	);
+
+	auto hash = osg_qt6::contentHash({"sphere-field", std::to_string(count), instanced ? "instanced" : "per-node"});
+	auto path = snapshot.path(hash);
+
+	std::error_code ec;
+
+	std::filesystem::remove(path, ec);
+
+	QElapsedTimer clock;
+
+	// Cold: build, save, draw.
+	clock.start();
+
+	osg::ref_ptr<osg::Node> built = osg_qt6::createSphereFieldScene(count, instanced);
+
+	auto buildMs = clock.nsecsElapsed() / 1.0e6;
+
+	clock.restart();
+
+	if(!snapshot.save(hash, *built)) {
+		OSG_FATAL << "bench-snapshot: couldn't write " << path.string() << std::endl;
+
+		return 1;
+	}
+
+	auto saveMs = clock.nsecsElapsed() / 1.0e6;
+	auto coldFrameMs = osg_qt6::firstFrameMs(built.get());
+
+	built = nullptr;
+
+	// Warm: the mapped load the examples use, then an ordinary osgDB read of the same file.
+	clock.restart();
+
+	osg::ref_ptr<osg::Node> mapped = snapshot.load(hash);
+
+	auto mappedMs = clock.nsecsElapsed() / 1.0e6;
+
+	clock.restart();
+
+	osg::ref_ptr<osg::Node> read = osgDB::readRefNodeFile(path.string());
+
+	auto readMs = clock.nsecsElapsed() / 1.0e6;
+
+	if(!mapped.valid() || !read.valid()) {
+		OSG_FATAL << "bench-snapshot: couldn't read " << path.string() << " back" << std::endl;
+
+		return 1;
+	}
+
+	read = nullptr;
+
+	auto warmFrameMs = osg_qt6::firstFrameMs(mapped.get());
+
+	osg_qt6::writeJson({
+		{"bench", "snapshot"},
+		{"spheres", static_cast<qint64>(count)},
+		{"instanced", instanced},
+		{"file_bytes", static_cast<qint64>(std::filesystem::file_size(path, ec))},
+		{"cold_ms", QJsonObject{
+			{"build", buildMs},
+			{"save", saveMs},
+			{"first_frame", coldFrameMs},
+			{"total", buildMs + coldFrameMs}
+		}},
+		{"warm_ms", QJsonObject{
+			{"load_mapped", mappedMs},
+			{"load_osgdb", readMs},
+			{"first_frame", warmFrameMs},
+			{"total", mappedMs + warmFrameMs}
+		}},
+		{"peak_rss_kb", static_cast<qint64>(osg_qt6::peakRssKb())}
+	});
+
+	return 0;
+}
@@ -0,0 +1,159 @@
+// Uploads an image as MyTextureLayer does (plain RGBA, mipmaps generated by the driver) and block
+// compressed with its prebuilt mip chain (MyTextureLayer::setCompressedCache()), and reports the
+// one-off cost of transcoding, decode vs. cache-read time, GPU texture memory and upload time:
+//
+//   QT_QPA_PLATFORM=offscreen LIBGL_ALWAYS_SOFTWARE=1 ./bench-texture-compression --images ../grid2.png
+//
+// NOTE: Upload time is apply() through glFinish() on a fresh texture object each repeat, so it
+// includes the driver's mipmap generation for the RGBA texture.
+
+#include <QGuiApplication>
+#include <QElapsedTimer>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QJsonArray>
+
+#include <osg/GLExtensions>
+#include <osg/GLObjects>
+#include <osg/Group>
+#include <osg/Texture2D>
+#include <osgDB/ReadFile>
+
+#include <osgEarth/Registry>
+
+#include "osg-qt6/bench.hpp"
+#include "osg-qt6/offscreen.hpp"
+#include "osg-qt6/texture-compression.hpp"
+
+namespace osg_qt6 {
+
+// Times `repeats` uploads of `image` into new texture objects.
+inline Samples timeUploads(OffscreenViewer& offscreen, osg::Image* image, int repeats) {
+	osg::State* state = offscreen.graphicsWindow()->getState();
+
+	Samples ms;
+	QElapsedTimer clock;
+
+	for(int i = 0; i < repeats; i++) {
+		osg::ref_ptr<osg::Texture2D> texture = new osg::Texture2D(image);
+
+		texture->setFilter(osg::Texture::MIN_FILTER, osg::Texture::LINEAR_MIPMAP_LINEAR);
+		texture->setUnRefImageDataAfterApply(false);
+
+		clock.start();
+
+		texture->apply(*state);
+		offscreen.finish();
+
+		ms.add(clock.nsecsElapsed() / 1.0e6);
+
+		texture->releaseGLObjects(state);
+
+		osg::flushAllDeletedGLObjects(state->getContextID());
+	}
+
+	return ms;
+}
+
+}
+
+QJsonObject runImage(osg_qt6::OffscreenViewer& offscreen, const QString& path, const QDir& cacheDir, int repeats) {
+	QElapsedTimer clock;
+
+	clock.start();
+
+	osg::ref_ptr<osg::Image> image = osgDB::readRefImageFile(path.toStdString());
+
+	auto decodeMs = clock.nsecsElapsed() / 1.0e6;
+
+	if(!image.valid()) return {{"image", path}, {"error", "couldn't read it"}};
+
+	clock.restart();
+
+	osg::ref_ptr<osg::Image> compressed = osg_qt6::compressImage(image.get());
+
+	auto transcodeMs = clock.nsecsElapsed() / 1.0e6;
+
+	if(!compressed.valid()) return {{"image", path}, {"error", "couldn't compress it"}};
+
+	auto cachePath = osg_qt6::compressedCachePath(path.toStdString(), cacheDir.path().toStdString());
+
+	osg_qt6::writeCompressedImage(*compressed, cachePath);
+
+	clock.restart();
+
+	osg::ref_ptr<osg::Image> cached = osg_qt6::readCompressedImage(cachePath);
+
+	auto cacheReadMs = clock.nsecsElapsed() / 1.0e6;
+
+	if(!cached.valid()) return {{"image", path}, {"error", "couldn't read the DDS back"}};
+
+	// NOTE: What the RGBA texture holds once the driver has generated its mipmaps.
+	osg::ref_ptr<osg::Image> rgba = osgEarth::ImageUtils::convertToRGBA8(image.get());
+
+	auto rgbaBytes = static_cast<qint64>(rgba->s()) * rgba->t() * 4 * 4 / 3;
+	auto compressedBytes = static_cast<qint64>(cached->getTotalSizeInBytesIncludingMipmaps());
+
+	auto rgbaUpload = osg_qt6::timeUploads(offscreen, rgba.get(), repeats);
+	auto compressedUpload = osg_qt6::timeUploads(offscreen, cached.get(), repeats);
+
+	return {
+		{"image", path},
+		{"width", rgba->s()},
+		{"height", rgba->t()},
+		{"format", cached->getPixelFormat() == GL_COMPRESSED_RGBA_S3TC_DXT5_EXT ? "bc3" : "bc1"},
+		{"mip_levels", static_cast<int>(cached->getNumMipmapLevels())},
+		{"decode_ms", decodeMs},
+		{"transcode_ms", transcodeMs},
+		{"cache_read_ms", cacheReadMs},
+		{"cache_file_bytes", static_cast<qint64>(std::filesystem::file_size(cachePath))},
+		{"texture_bytes_rgba", rgbaBytes},
+		{"texture_bytes_compressed", compressedBytes},
+		{"texture_bytes_saved", rgbaBytes - compressedBytes},
+		{"upload_ms_rgba", rgbaUpload.toJson()},
+		{"upload_ms_compressed", compressedUpload.toJson()}
+	};
+}
+
+int main(int argc, char** argv) {
+	QGuiApplication app(argc, argv);
+	QCommandLineParser parser;
+
+	parser.addHelpOption();
+	parser.addOptions({
+		{"images", "Comma-separated images to upload.", "paths", "../grid2.png"},
+		{"repeats", "Uploads timed per image and format.", "count", "20"},
+		{"cache", "Directory for the DDS copies (default: a temporary one).", "path"}
+	});
+	parser.process(app);
+
+	osgEarth::initialize();
+
+	auto repeats = std::max(1, parser.value("repeats").toInt());
+	auto cacheDir = QDir(parser.isSet("cache") ? parser.value("cache") : QDir::temp().filePath("bench-texture-compression"));
+
+	osg_qt6::OffscreenViewer offscreen(64, 64);
+
+	// One (empty) frame, so the viewer is realized and its State set up.
+	offscreen.viewer()->setSceneData(new osg::Group());
+	offscreen.frame();
+
+	auto contextID = offscreen.graphicsWindow()->getState()->getContextID();
+
+	QJsonArray images;
+
+	for(const auto& path : parser.value("images").split(',', Qt::SkipEmptyParts)) {
+		images.append(runImage(offscreen, path, cacheDir, repeats));
+	}
+
+	osg_qt6::writeJson({
+		{"bench", "texture-compression"},
+		{"renderer", offscreen.renderer()},
+		{"s3tc", osg::GLExtensions::Get(contextID, true)->isTextureCompressionS3TCSupported},
+		{"repeats", repeats},
+		{"images", images},
+		{"peak_rss_kb", static_cast<qint64>(osg_qt6::peakRssKb())}
+	});
+
+	return 0;
+}
@@ -0,0 +1,191 @@
+// Drapes one image over the globe with MyTextureLayer (one full-resolution texture shared by every
+// tile) and with MyTiledTextureLayer (a small texture per tile, cut from a mip pyramid), dives the
+// camera from orbit down to the surface, and reports time-to-first-frame, texture memory and RSS:
+//
+//   QT_QPA_PLATFORM=offscreen ./bench-texture-layer --image ../world.tif --frames 300
+
+#include <atomic>
+#include <cmath>
+
+#include <QGuiApplication>
+#include <QElapsedTimer>
+#include <QCommandLineParser>
+#include <QJsonArray>
+
+#include <osgDB/ReadFile>
+
+#include <osgEarth/MapNode>
+#include <osgEarth/EarthManipulator>
+#include <osgEarth/ExampleResources>
+
+#include "osg-qt6/bench.hpp"
+#include "osg-qt6/my-texture-layer.hpp"
+#include "osg-qt6/offscreen.hpp"
+#include "osg-qt6/tiled-texture-layer.hpp"
+
+namespace osg_qt6 {
+
+// Counts createTexture() calls, so we know when the first tile of imagery has been handed over.
+template<typename T>
+class CountingLayer: public T {
+public:
+	osgEarth::TextureWindow createTexture(
+		const osgEarth::TileKey& key,
+		osgEarth::ProgressCallback* progress
+	) const override {
+		auto window = T::createTexture(key, progress);
+
+		_textures++;
+
+		return window;
+	}
+
+	size_t textures() const {
+		return _textures;
+	}
+
+private:
+	mutable std::atomic<size_t> _textures = 0;
+};
+
+}
+
+QJsonObject runMode(const QString& mode, const QString& path, int frames, int maxTiles) {
+	osg_qt6::OffscreenViewer offscreen(1280, 720);
+
+	auto* viewer = offscreen.viewer();
+	auto rssBefore = osg_qt6::currentRssKb();
+
+	QElapsedTimer clock;
+
+	clock.start();
+
+	auto* map = new osgEarth::Map();
+
+	osg::ref_ptr<osg_qt6::CountingLayer<MyTextureLayer>> whole;
+	osg::ref_ptr<osg_qt6::CountingLayer<MyTiledTextureLayer>> tiled;
+
+	if(mode == "whole") {
+		whole = new osg_qt6::CountingLayer<MyTextureLayer>();
+		whole->setPath(path.toStdString());
+
+		map->addLayer(whole.get());
+	}
+
+	else {
+		tiled = new osg_qt6::CountingLayer<MyTiledTextureLayer>();
+		tiled->setPath(path.toStdString());
+		tiled->setMaxTiles(maxTiles);
+
+		map->addLayer(tiled.get());
+	}
+
+	auto* node = new osgEarth::MapNode(map);
+	auto* manip = new osgEarth::EarthManipulator();
+
+	viewer->setCameraManipulator(manip);
+	viewer->setSceneData(node);
+
+	osgEarth::MapNodeHelper().configureView(viewer);
+
+	auto openMs = clock.nsecsElapsed() / 1.0e6;
+
+	auto textures = [&]() {
+		return whole.valid() ? whole->textures() : tiled->textures();
+	};
+
+	auto dive = [&](int i) {
+		double t = static_cast<double>(i) / std::max(frames - 1, 1);
+
+		manip->setViewpoint(osgEarth::Viewpoint("dive", 10.0 * t, 20.0, 0.0, 0.0, -90.0, 2.0e7 * std::pow(1.0e-3, t)));
+	};
+
+	dive(0);
+
+	// Until the terrain has been handed its first texture, and then one more frame to merge it.
+	int waited = 0;
+
+	while(textures() == 0 && waited++ < 10000) offscreen.frame();
+
+	offscreen.frame();
+	offscreen.finish();
+
+	auto firstFrameMs = clock.nsecsElapsed() / 1.0e6;
+
+	osg_qt6::Samples wall;
+	size_t peakBytes = 0;
+
+	for(int i = 0; i < frames; i++) {
+		dive(i);
+
+		clock.restart();
+
+		offscreen.frame();
+
+		wall.add(clock.nsecsElapsed() / 1.0e6);
+
+		if(tiled.valid()) peakBytes = std::max(peakBytes, tiled->cachedBytes());
+	}
+
+	offscreen.finish();
+
+	// NOTE: The whole-image layer keeps the full image (plus mipmaps) on the GPU for as long as it's
+	// open, no matter the view.
+	if(whole.valid()) {
+		osg::ref_ptr<osg::Image> image = osgDB::readRefImageFile(path.toStdString());
+
+		if(image.valid()) peakBytes = image->s() * image->t() * 4 * 4 / 3;
+	}
+
+	QJsonObject result = {
+		{"mode", mode},
+		{"open_ms", openMs},
+		{"first_frame_ms", firstFrameMs},
+		{"textures_created", static_cast<qint64>(textures())},
+		{"texture_bytes_peak", static_cast<qint64>(peakBytes)},
+		{"rss_delta_kb", static_cast<qint64>(osg_qt6::currentRssKb() - rssBefore)},
+		{"frame_ms", wall.toJson()}
+	};
+
+	if(tiled.valid()) {
+		result["cached_tiles"] = static_cast<qint64>(tiled->cachedTiles());
+		result["texture_bytes_cached"] = static_cast<qint64>(tiled->cachedBytes());
+	}
+
+	return result;
+}
+
+int main(int argc, char** argv) {
+	QGuiApplication app(argc, argv);
+	QCommandLineParser parser;
+
+	parser.addHelpOption();
+	parser.addOptions({
+		{"image", "Global (plate carrée) image to drape.", "path", "../world.tif"},
+		{"frames", "Frames rendered along the dive, per mode.", "count", "300"},
+		{"max-tiles", "LRU capacity of the tiled layer.", "count", "256"},
+		{"mode", "whole, tiled or both.", "mode", "both"}
+	});
+	parser.process(app);
+
+	osgEarth::initialize();
+
+	auto path = parser.value("image");
+	auto frames = std::max(1, parser.value("frames").toInt());
+	auto maxTiles = std::max(1, parser.value("max-tiles").toInt());
+	auto mode = parser.value("mode");
+
+	QJsonArray modes;
+
+	if(mode != "tiled") modes.append(runMode("whole", path, frames, maxTiles));
+	if(mode != "whole") modes.append(runMode("tiled", path, frames, maxTiles));
+
+	osg_qt6::writeJson({
+		{"bench", "texture-layer"},
+		{"image", path},
+		{"modes", modes},
+		{"peak_rss_kb", static_cast<qint64>(osg_qt6::peakRssKb())}
+	});
+
+	return 0;
+}
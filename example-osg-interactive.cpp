@@ -2,63 +2,53 @@
 #include <QOpenGLFunctions>
 #include <QApplication>
 #include <QMainWindow>
-#include <QTimer>
 #include <QMouseEvent>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
 
-#include <osg/Geode>
-#include <osg/MatrixTransform>
-#include <osg/ShapeDrawable>
-#include <osg/Point>
-#include <osg/PolygonMode>
 #include <osgGA/TrackballManipulator>
 #include <osgViewer/Viewer>
 #include <osgViewer/GraphicsWindow>
 
-namespace osg_qt6 {
-
-using vec_t = osg::Vec3::value_type;
-
-osg::ShapeDrawable* createSphere(vec_t radius, vec_t pSize) {
-	osg::ShapeDrawable* s = new osg::ShapeDrawable(new osg::Sphere(
-		osg::Vec3(0.0, 0.0, 0.0),
-		radius
-	));
-
-	s->getOrCreateStateSet()->setAttribute(
-		new osg::Point(pSize),
-		osg::StateAttribute::ON
-	);
-
-	return s;
-}
-
-osg::MatrixTransform* createSphereAt(const osg::Vec3& pos, vec_t radius, vec_t pSize) {
-	osg::MatrixTransform* m = new osg::MatrixTransform(osg::Matrix::translate(pos));
-	osg::Geode* g = new osg::Geode();
-
-	g->addDrawable(createSphere(radius, pSize));
-
-	m->addChild(g);
-
-	return m;
-}
-
-}
+#include "osg-qt6/frame-scheduler.hpp"
+#include "osg-qt6/input-coalescer.hpp"
+#include "osg-qt6/input-recording.hpp"
+#include "osg-qt6/point-cloud.hpp"
+#include "osg-qt6/render-thread.hpp"
+#include "osg-qt6/scene-snapshot.hpp"
+#include "osg-qt6/scenes.hpp"
+#include "osg-qt6/trace.hpp"
 
 class OSGWidget: public QOpenGLWidget, protected QOpenGLFunctions {
 
 Q_OBJECT
 
 public:
-	OSGWidget(QWidget* parent=nullptr):
-	QOpenGLWidget(parent) {
-		_timer = new QTimer(this);
+	// NOTE: When `renderThread` is set, osgViewer runs its frame loop on a RenderThread (using the
+	// given threading model) and this widget only composites the finished frames.
+	OSGWidget(
+		QWidget* parent=nullptr,
+		bool renderThread=false,
+		osgViewer::ViewerBase::ThreadingModel threadingModel=osgViewer::ViewerBase::SingleThreaded
+	):
+	QOpenGLWidget(parent),
+	_useRenderThread(renderThread),
+	_threadingModel(threadingModel) {
+		_scheduler = new osg_qt6::FrameScheduler(this);
+
+		connect(this, &QOpenGLWidget::frameSwapped, [this]() {
+			_swap.end("swap");
+		});
+	}
+
+	~OSGWidget() override {
+		if(!_renderThread) return;
 
-		// connect(_timer, &QTimer::timeout, this, &OSGWidget::update);
-		// connect(_timer, &QTimer::timeout, this, QOverload<>::of(&OSGWidget::repaint));
-		connect(_timer, &QTimer::timeout, this, QOverload<>::of(&OSGWidget::update));
+		makeCurrent();
 
-		_timer->start(1000 / 60);
+		delete _renderThread;
+
+		doneCurrent();
 	}
 
 	struct MouseEventData {
@@ -113,25 +103,73 @@ public:
 		unsigned int button = 0;
 	};
 
+	// Replaces the default point-sphere scene; call before the widget is shown.
+	void setScene(osg::Node* scene) {
+		_scene = scene;
+	}
+
+	// Writes all input (and resizes) from here on to `path`, for bench-replay to play back.
+	bool record(const std::string& path) {
+		if(!_recorder.open(path)) return false;
+
+		_input.setRecorder(&_recorder);
+
+		return true;
+	}
+
+	// Safe from any thread (e.g., a streaming node's loader).
+	void requestFrame() {
+		QMetaObject::invokeMethod(_scheduler, [this]() {
+			_scheduler->requestFrame();
+		});
+	}
+
 protected:
 	void initializeGL() override {
 		OSG_WARN << "initializeGL; DPR = " << devicePixelRatio() << std::endl;
 
-		osg::Group* root = new osg::Group();
-
-		root->addChild(osg_qt6::createSphereAt(osg::Vec3(), 10.0, 2.0));
-		root->getOrCreateStateSet()->setAttributeAndModes(
-			new osg::PolygonMode(osg::PolygonMode::FRONT_AND_BACK, osg::PolygonMode::POINT),
-			osg::StateAttribute::ON
-		);
+		osg::ref_ptr<osg::Node> root = _scene.valid() ? _scene.get() : osg_qt6::createPointSphereScene();
 
 		_viewer = new osgViewer::Viewer();
 
-		_viewer->setUpViewerAsEmbeddedInWindow(0, 0, width(), height());
-		_viewer->setThreadingModel(osgViewer::Viewer::SingleThreaded);
+		if(!_useRenderThread) {
+			_viewer->setUpViewerAsEmbeddedInWindow(0, 0, width(), height());
+			_viewer->setThreadingModel(osgViewer::Viewer::SingleThreaded);
+		}
+
 		_viewer->setSceneData(root);
 		_viewer->setCameraManipulator(new osgGA::TrackballManipulator());
 
+		osg_qt6::trace::install(_viewer);
+
+		_scheduler->setViewer(_viewer);
+
+		_input.setEventQueue(_viewer->getEventQueue());
+
+		if(_useRenderThread) {
+			_renderThread = new osg_qt6::RenderThread(this, _viewer, _threadingModel);
+
+			// NOTE: This fires on whichever thread osgViewer drew on; bounce back to the GUI thread.
+			_renderThread->setFrameReadyCallback([this]() {
+				QMetaObject::invokeMethod(this, [this]() {
+					_scheduler->frameRendered();
+
+					update();
+				}, Qt::QueuedConnection);
+			});
+
+			_scheduler->setRenderFunction([this]() {
+				_input.flush();
+				_renderThread->requestFrame();
+			});
+
+			_scheduler->setDemandFunction([this]() {
+				return _renderThread->demand();
+			});
+
+			_renderThread->start();
+		}
+
 		// TODO: Just letting QT6 "do its own thing" here seems to work much better. Need to
 		// investigate this for more complex setups.
 		/* osg::GraphicsContext::Traits* traits = new osg::GraphicsContext::Traits();
@@ -157,14 +195,33 @@ protected:
 	void resizeGL(int w, int h) override {
 		OSG_WARN << "resizeGL: " << w << " x " << h << std::endl;
 
+		_recorder.resize(w, h);
+
+		if(_renderThread) {
+			_renderThread->resize(w, h);
+
+			return;
+		}
+
 		_viewer->getCamera()->setViewport(new osg::Viewport(0, 0, w, h));
 		_viewer->getCamera()->setProjectionMatrixAsPerspective(30.0f, static_cast<double>(w) / h, 1.0, 1000.0);
 	}
 
 	void paintGL() override {
-		OSG_WARN << "paintGL" << std::endl;
+		OSG_QT6_TRACE_SCOPE("paintGL");
+
+		if(_renderThread) {
+			_renderThread->composite();
 
-		_viewer->frame();
+			return;
+		}
+
+		_input.flush();
+		osg_qt6::trace::frame(_viewer);
+
+		_scheduler->frameRendered();
+
+		_swap.begin();
 	}
 
 	auto _mouseEventData(QMouseEvent* event) const {
@@ -172,45 +229,50 @@ protected:
 	}
 
 	void mousePressEvent(QMouseEvent* event) override {
-		auto med = _mouseEventData(event);
+		OSG_QT6_TRACE_SCOPE("mousePressEvent");
 
-		OSG_WARN << "mousePressEvent: " << med << std::endl;
+		auto med = _mouseEventData(event);
 
-		_viewer->getEventQueue()->mouseButtonPress(med.x, med.y, med.button);
+		_input.mousePress(med.x, med.y, med.button);
 	}
 
 	void mouseMoveEvent(QMouseEvent* event) override {
-		auto med = _mouseEventData(event);
+		OSG_QT6_TRACE_SCOPE("mouseMoveEvent");
 
-		OSG_WARN << "mouseMoveEvent: " << med << std::endl;
+		auto med = _mouseEventData(event);
 
-		_viewer->getEventQueue()->mouseMotion(med.x, med.y);
+		_input.mouseMove(med.x, med.y);
 	}
 
 	void mouseReleaseEvent(QMouseEvent* event) override {
-		auto med = _mouseEventData(event);
+		OSG_QT6_TRACE_SCOPE("mouseReleaseEvent");
 
-		OSG_WARN << "mouseReleaseEvent: " << med << std::endl;
+		auto med = _mouseEventData(event);
 
-		_viewer->getEventQueue()->mouseButtonRelease(med.x, med.y, med.button);
+		_input.mouseRelease(med.x, med.y, med.button);
 	}
 
 	void wheelEvent(QWheelEvent* event) override {
-		auto delta = static_cast<float>(event->angleDelta().y()) / 120.0f;
+		OSG_QT6_TRACE_SCOPE("wheelEvent");
 
-		OSG_WARN << "wheelEvent: " << delta << std::endl;
+		auto delta = static_cast<float>(event->angleDelta().y()) / 120.0f;
 
-		_viewer->getEventQueue()->mouseScroll(
-			delta > 0.0f ?
-			osgGA::GUIEventAdapter::SCROLL_UP :
-			osgGA::GUIEventAdapter::SCROLL_DOWN
-		);
+		_input.wheel(static_cast<float>(event->angleDelta().x()) / 120.0f, delta);
 	}
 
 private:
 	osg::ref_ptr<osgViewer::Viewer> _viewer;
+	osg::ref_ptr<osg::Node> _scene;
+
+	osg_qt6::FrameScheduler* _scheduler = nullptr;
+	osg_qt6::trace::Span _swap;
+	osg_qt6::InputCoalescer _input;
+	osg_qt6::InputRecorder _recorder;
+	osg_qt6::RenderThread* _renderThread = nullptr;
 
-	QTimer* _timer = nullptr;
+	bool _useRenderThread = false;
+
+	osgViewer::ViewerBase::ThreadingModel _threadingModel = osgViewer::ViewerBase::SingleThreaded;
 };
 
 int main(int argc, char** argv) {
@@ -218,9 +280,67 @@ int main(int argc, char** argv) {
 
 	QApplication app(argc, argv);
 
+	osg_qt6::trace::startFromEnvironment();
+	osg_qt6::trace::setThreadName("gui");
+
+	QCommandLineParser parser;
+
+	parser.addHelpOption();
+	parser.addOptions({
+		{"render-thread", "Run the osgViewer frame loop on its own thread."},
+		{"threading", "osgViewer threading model: single, cull-draw, draw.", "model", "single"},
+		{"point-cloud", "Stream this .opc file (see tool-pointcloud) instead of the sphere.", "path"},
+		{"spheres", "Show a generated field of this many spheres instead of the sphere.", "count"},
+		{"per-node", "Build the --spheres field as one node per sphere rather than instanced."},
+		{"snapshot-dir", "Where built scenes are cached as .osgb (empty to always rebuild).", "path", "scene-cache"},
+		{"record", "Record all input to this file (see bench-replay).", "path"}
+	});
+	parser.process(app);
+
 	QMainWindow mainWindow;
 
-	OSGWidget* osgWidget = new OSGWidget();
+	OSGWidget* osgWidget = new OSGWidget(
+		nullptr,
+		parser.isSet("render-thread"),
+		osg_qt6::threadingModelFromString(parser.value("threading").toStdString())
+	);
+
+	if(parser.isSet("point-cloud")) {
+		auto* cloud = new osg_qt6::PointCloudNode(parser.value("point-cloud"));
+
+		cloud->setLoadedCallback([osgWidget]() {
+			osgWidget->requestFrame();
+		});
+
+		osgWidget->setScene(cloud);
+	}
+
+	else if(parser.isSet("spheres")) {
+		auto count = static_cast<size_t>(parser.value("spheres").toULongLong());
+		bool instanced = !parser.isSet("per-node");
+		bool loaded = false;
+
+		osg_qt6::SceneSnapshot snapshot(parser.value("snapshot-dir").toStdString());
+		QElapsedTimer clock;
+
+		clock.start();
+
+		auto scene = snapshot.loadOrBuild(
+			osg_qt6::contentHash({"sphere-field", std::to_string(count), instanced ? "instanced" : "per-node"}),
+			[count, instanced]() -> osg::Node* {
+				return osg_qt6::createSphereFieldScene(count, instanced);
+			},
+			&loaded
+		);
+
+		OSG_NOTICE << (loaded ? "Loaded" : "Built") << " the scene in " << clock.nsecsElapsed() / 1.0e6 << "ms" << std::endl;
+
+		osgWidget->setScene(scene.get());
+	}
+
+	if(parser.isSet("record") && !osgWidget->record(parser.value("record").toStdString())) {
+		OSG_WARN << "Couldn't record to " << parser.value("record").toStdString() << std::endl;
+	}
 
 	mainWindow.setCentralWidget(osgWidget);
 	mainWindow.resize(800, 600);
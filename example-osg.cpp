@@ -2,47 +2,14 @@
 #include <QOpenGLFunctions>
 #include <QApplication>
 #include <QMainWindow>
-#include <QTimer>
 
-#include <osg/Geode>
-#include <osg/MatrixTransform>
-#include <osg/ShapeDrawable>
-#include <osg/Point>
-#include <osg/PolygonMode>
 #include <osgGA/TrackballManipulator>
 #include <osgViewer/Viewer>
 #include <osgViewer/GraphicsWindow>
 
-namespace osg_qt6 {
-
-using vec_t = osg::Vec3::value_type;
-
-osg::ShapeDrawable* createSphere(vec_t radius, vec_t pSize) {
-	osg::ShapeDrawable* s = new osg::ShapeDrawable(new osg::Sphere(
-		osg::Vec3(0.0, 0.0, 0.0),
-		radius
-	));
-
-	s->getOrCreateStateSet()->setAttribute(
-		new osg::Point(pSize),
-		osg::StateAttribute::ON
-	);
-
-	return s;
-}
-
-osg::MatrixTransform* createSphereAt(const osg::Vec3& pos, vec_t radius, vec_t pSize) {
-	osg::MatrixTransform* m = new osg::MatrixTransform(osg::Matrix::translate(pos));
-	osg::Geode* g = new osg::Geode();
-
-	g->addDrawable(createSphere(radius, pSize));
-
-	m->addChild(g);
-
-	return m;
-}
-
-}
+#include "osg-qt6/frame-scheduler.hpp"
+#include "osg-qt6/scenes.hpp"
+#include "osg-qt6/trace.hpp"
 
 class OSGWidget: public QOpenGLWidget, protected QOpenGLFunctions {
 
@@ -51,26 +18,18 @@ Q_OBJECT
 public:
 	OSGWidget(QWidget* parent=nullptr):
 	QOpenGLWidget(parent) {
-		_timer = new QTimer(this);
-
-		// connect(_timer, &QTimer::timeout, this, &OSGWidget::update);
-		// connect(_timer, &QTimer::timeout, this, QOverload<>::of(&OSGWidget::repaint));
-		connect(_timer, &QTimer::timeout, this, QOverload<>::of(&OSGWidget::update));
+		_scheduler = new osg_qt6::FrameScheduler(this);
 
-		_timer->start(1000 / 60);
+		connect(this, &QOpenGLWidget::frameSwapped, [this]() {
+			_swap.end("swap");
+		});
 	}
 
 protected:
 	void initializeGL() override {
 		OSG_WARN << "initializeGL" << std::endl;
 
-		osg::Group* root = new osg::Group();
-
-		root->addChild(osg_qt6::createSphereAt(osg::Vec3(), 10.0, 2.0));
-		root->getOrCreateStateSet()->setAttributeAndModes(
-			new osg::PolygonMode(osg::PolygonMode::FRONT_AND_BACK, osg::PolygonMode::POINT),
-			osg::StateAttribute::ON
-		);
+		osg::Group* root = osg_qt6::createPointSphereScene();
 
 		_viewer = new osgViewer::Viewer();
 
@@ -79,6 +38,10 @@ protected:
 		_viewer->setSceneData(root);
 		_viewer->setCameraManipulator(new osgGA::TrackballManipulator());
 
+		osg_qt6::trace::install(_viewer);
+
+		_scheduler->setViewer(_viewer);
+
 		// TODO: Just letting QT6 "do its own thing" here seems to work much better. Need to
 		// investigate this for more complex setups.
 		/* osg::GraphicsContext::Traits* traits = new osg::GraphicsContext::Traits();
@@ -109,15 +72,20 @@ protected:
 	}
 
 	void paintGL() override {
-		OSG_WARN << "paintGL" << std::endl;
+		OSG_QT6_TRACE_SCOPE("paintGL");
+
+		osg_qt6::trace::frame(_viewer);
 
-		_viewer->frame();
+		_scheduler->frameRendered();
+
+		_swap.begin();
 	}
 
 private:
 	osg::ref_ptr<osgViewer::Viewer> _viewer;
 
-	QTimer* _timer = nullptr;
+	osg_qt6::FrameScheduler* _scheduler = nullptr;
+	osg_qt6::trace::Span _swap;
 };
 
 int main(int argc, char** argv) {
@@ -125,6 +93,9 @@ int main(int argc, char** argv) {
 
 	QApplication app(argc, argv);
 
+	osg_qt6::trace::startFromEnvironment();
+	osg_qt6::trace::setThreadName("gui");
+
 	QMainWindow mainWindow;
 
 	OSGWidget* osgWidget = new OSGWidget();
@@ -4,8 +4,13 @@
 #include <QOpenGLFunctions>
 #include <QApplication>
 #include <QMainWindow>
-#include <QTimer>
+#include <QKeyEvent>
 #include <QMouseEvent>
+#include <QDir>
+#include <QStatusBar>
+#include <QTimer>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
 
 #include <osgDB/ReadFile>
 
@@ -18,9 +23,23 @@
 #include <osgEarth/EarthManipulator>
 #include <osgEarth/ExampleResources>
 #include <osgEarth/LatLongFormatter>
-#include <osgEarth/PlaceNode>
 #include <osgEarth/LocalGeometryNode>
 
+#include "osg-qt6/compile-budget.hpp"
+#include "osg-qt6/depth-picker.hpp"
+#include "osg-qt6/earth-scenes.hpp"
+#include "osg-qt6/frame-capture.hpp"
+#include "osg-qt6/frame-scheduler.hpp"
+#include "osg-qt6/input-coalescer.hpp"
+#include "osg-qt6/input-recording.hpp"
+#include "osg-qt6/label-layer.hpp"
+#include "osg-qt6/map-loader.hpp"
+#include "osg-qt6/memory-ledger.hpp"
+#include "osg-qt6/placemark-layer.hpp"
+#include "osg-qt6/quality-governor.hpp"
+#include "osg-qt6/tile-prefetch.hpp"
+#include "osg-qt6/trace.hpp"
+
 #if 0
 #include <ranges>
 
@@ -56,9 +75,63 @@ public:
 };
 #endif
 
+// Qt's key codes only match osgGA's for what's typed (printable characters, Space included); the
+// keys the manipulators bind otherwise are mapped here. 0 for anything else.
+inline int osgKey(const QKeyEvent* event) {
+	switch(event->key()) {
+		case Qt::Key_Left: return osgGA::GUIEventAdapter::KEY_Left;
+		case Qt::Key_Right: return osgGA::GUIEventAdapter::KEY_Right;
+		case Qt::Key_Up: return osgGA::GUIEventAdapter::KEY_Up;
+		case Qt::Key_Down: return osgGA::GUIEventAdapter::KEY_Down;
+		case Qt::Key_Home: return osgGA::GUIEventAdapter::KEY_Home;
+		case Qt::Key_End: return osgGA::GUIEventAdapter::KEY_End;
+		case Qt::Key_PageUp: return osgGA::GUIEventAdapter::KEY_Page_Up;
+		case Qt::Key_PageDown: return osgGA::GUIEventAdapter::KEY_Page_Down;
+		case Qt::Key_Return: return osgGA::GUIEventAdapter::KEY_Return;
+		case Qt::Key_Enter: return osgGA::GUIEventAdapter::KEY_KP_Enter;
+		case Qt::Key_Escape: return osgGA::GUIEventAdapter::KEY_Escape;
+		case Qt::Key_Backspace: return osgGA::GUIEventAdapter::KEY_BackSpace;
+		case Qt::Key_Tab: return osgGA::GUIEventAdapter::KEY_Tab;
+		case Qt::Key_Delete: return osgGA::GUIEventAdapter::KEY_Delete;
+		case Qt::Key_Shift: return osgGA::GUIEventAdapter::KEY_Shift_L;
+		case Qt::Key_Control: return osgGA::GUIEventAdapter::KEY_Control_L;
+		case Qt::Key_Alt: return osgGA::GUIEventAdapter::KEY_Alt_L;
+		default: break;
+	}
+
+	if(event->key() >= Qt::Key_F1 && event->key() <= Qt::Key_F12) {
+		return osgGA::GUIEventAdapter::KEY_F1 + (event->key() - Qt::Key_F1);
+	}
+
+	return event->text().isEmpty() ? 0 : event->text().at(0).unicode();
+}
+
+inline std::string formatLatLon(const osgEarth::GeoPoint& gp) {
+	return osgEarth::Util::LatLongFormatter(
+		osgEarth::Util::LatLongFormatter::AngularFormat::FORMAT_DECIMAL_DEGREES,
+		osgEarth::Util::LatLongFormatter::Options::USE_SUFFIXES
+	).format(gp);
+}
+
+// NOTE: When given a DepthPicker (and the context can do it), clicks are resolved from the depth
+// buffer a frame or two later instead of by intersecting the terrain graph right here in the event
+// traversal; the intersector is still used otherwise. Given a PlacemarkFile, every placemark a click
+// adds is also saved there, and given a LabelLayer, labeled with its lat/lon.
 class ClickToLatLonHandler: public osgGA::GUIEventHandler {
 public:
-	ClickToLatLonHandler(osgEarth::MapNode* mapNode): _mapNode(mapNode) {}
+	ClickToLatLonHandler(
+		osgEarth::MapNode* mapNode,
+		osg_qt6::PlacemarkLayer* placemarks,
+		osg_qt6::DepthPicker* picker=nullptr,
+		const osg_qt6::PlacemarkFile* placemarkFile=nullptr,
+		osg_qt6::LabelLayer* labels=nullptr
+	):
+	_mapNode(mapNode),
+	_placemarks(placemarks),
+	_picker(picker),
+	_placemarkFile(placemarkFile),
+	_labels(labels) {
+	}
 
 	virtual bool handle(const osgGA::GUIEventAdapter& ea, osgGA::GUIActionAdapter& aa) override {
 		if(
@@ -71,20 +144,32 @@ public:
 
 		if(!view) return false;
 
+		if(_picker && _picker->supported()) {
+			osg::observer_ptr<osgViewer::View> observer(view);
+
+			float x = ea.getX();
+			float y = ea.getY();
+
+			_picker->pick(x, y, [this, observer, x, y](bool hit, const osg::Vec3d& wp) {
+				if(!hit) {
+					OE_WARN << "Failed to get LatLon for: " << x << "x" << y << std::endl;
+
+					return;
+				}
+
+				_clicked(wp);
+
+				if(osg::ref_ptr<osgViewer::View> view; observer.lock(view)) view->requestRedraw();
+			});
+
+			return true;
+		}
+
 		if(
 			osg::Vec3d wp;
 			_mapNode->getTerrain()->getWorldCoordsUnderMouse(view, ea.getX(), ea.getY(), wp)
 		) {
-			osgEarth::GeoPoint gp;
-
-			gp.fromWorld(_mapNode->getMapSRS(), wp);
-
-			OE_WARN << "LatLong: " << osgEarth::Util::LatLongFormatter(
-				osgEarth::Util::LatLongFormatter::AngularFormat::FORMAT_DECIMAL_DEGREES,
-				osgEarth::Util::LatLongFormatter::Options::USE_SUFFIXES
-			).format(gp) << std::endl;
-
-			addIcon(gp);
+			_clicked(wp);
 
 			return true;
 		}
@@ -94,31 +179,36 @@ public:
 		return false;
 	}
 
+	// NOTE: All clicked placemarks share one PlacemarkLayer (a single draw out of one vertex buffer)
+	// instead of each becoming its own PlaceNode.
 	void addIcon(const osgEarth::GeoPoint& gp) {
-		osgEarth::Style pm;
+		if(!_placemarks.valid() || !_placemarks->add(gp)) return;
 
-		auto* is = pm.getOrCreate<osgEarth::IconSymbol>();
-		auto scale = 0.5;
+		if(_labels.valid()) _labels->add(gp, formatLatLon(gp));
 
-		is->url().mutable_value().setLiteral("../blackdot.png");
-		is->declutter() = false;
-		is->scale() = scale;
-		is->alignment() = osgEarth::IconSymbol::ALIGN_CENTER_CENTER;
+		if(_placemarkFile) _placemarkFile->append(gp);
+	}
 
-		auto* ts = pm.getOrCreate<osgEarth::TextSymbol>();
+private:
+	void _clicked(const osg::Vec3d& wp) {
+		osgEarth::GeoPoint gp;
 
-		ts->size() = 96.0 * scale;
-		ts->halo() = osgEarth::Color("#000000");
-		ts->fill() = osgEarth::Color::White;
-		ts->alignment() = osgEarth::TextSymbol::ALIGN_LEFT_CENTER;
+		gp.fromWorld(_mapNode->getMapSRS(), wp);
 
-		auto* pn = new osgEarth::PlaceNode(gp, "foo", pm);
+		OE_WARN << "LatLong: " << formatLatLon(gp) << std::endl;
 
-		_mapNode->addChild(pn);
+		addIcon(gp);
 	}
 
-private:
 	osgEarth::MapNode* _mapNode;
+
+	osg::ref_ptr<osg_qt6::PlacemarkLayer> _placemarks;
+
+	osg_qt6::DepthPicker* _picker = nullptr;
+
+	const osg_qt6::PlacemarkFile* _placemarkFile = nullptr;
+
+	osg::ref_ptr<osg_qt6::LabelLayer> _labels;
 };
 
 #if 0
@@ -142,13 +232,17 @@ class OSGWidget: public QOpenGLWidget, protected QOpenGLFunctions {
 Q_OBJECT
 
 public:
-	OSGWidget(QWidget* parent=nullptr):
+	// NOTE: With a `targetMs`, a QualityGovernor renders the camera at whatever resolution scale and
+	// MSAA level keeps frames under it, and the widget's own framebuffer goes single-sampled.
+	OSGWidget(QWidget* parent=nullptr, double targetMs=0.0):
 	QOpenGLWidget(parent) {
+		if(targetMs > 0.0) _governor = std::make_unique<osg_qt6::QualityGovernor>(targetMs);
+
 		QSurfaceFormat format;
 
 		format.setRenderableType(QSurfaceFormat::OpenGL);
 		format.setProfile(QSurfaceFormat::CompatibilityProfile);
-		format.setSamples(4);
+		format.setSamples(_governor ? 0 : 4);
 
 		setMouseTracking(true);
 		setAttribute(Qt::WA_MouseTracking);
@@ -156,11 +250,71 @@ public:
 		setFocusPolicy(Qt::StrongFocus);
 		setFormat(format);
 
-		_timer = new QTimer(this);
+		_scheduler = new osg_qt6::FrameScheduler(this);
+
+		connect(this, &QOpenGLWidget::frameSwapped, [this]() {
+			_swap.end("swap");
+		});
+	}
+
+	// NOTE: Takes effect in initializeGL(), so it has to be set before the widget is first shown.
+	void setCompileBudget(const osg_qt6::CompileBudget& budget) {
+		_compileBudget = budget;
+	}
+
+	// Where F12 (or startCapture()) writes captured frames: a directory of PNGs, or one raw RGBA
+	// stream.
+	void setCaptureOutput(const std::string& output, osg_qt6::FrameCapture::Format format) {
+		_captureOutput = output;
+		_captureFormat = format;
+	}
 
-		connect(_timer, &QTimer::timeout, this, QOverload<>::of(&OSGWidget::update));
+	void startCapture() {
+		if(_capture.start(_captureOutput, _captureFormat)) OE_NOTICE << "Capturing to " << _captureOutput << std::endl;
 
-		_timer->start(1000 / 60);
+		_scheduler->requestFrame();
+	}
+
+	// Writes all input (and resizes) from here on to `path`, for bench-replay to play back.
+	bool record(const std::string& path) {
+		if(!_recorder.open(path)) return false;
+
+		_input.setRecorder(&_recorder);
+
+		return true;
+	}
+
+	// Where clicked placemarks are saved (and restored from on the next launch).
+	void setPlacemarkFile(const std::string& path) {
+		_placemarkFile = osg_qt6::PlacemarkFile(path);
+	}
+
+	// Load the tiles a Space fly-to will need as soon as it starts (see TilePrefetcher); either way,
+	// how long the terrain takes to reach full resolution after landing is logged.
+	void setPrefetch(bool enabled) {
+		_prefetch = enabled;
+	}
+
+	// Block compress the imagery (with prebuilt mipmaps) and keep the result in a DDS tile cache
+	// for the next launch; see CachedImageLayer::setCompressed().
+	void setCompressedTiles(bool enabled) {
+		_compressedTiles = enabled;
+	}
+
+	// Drive frames off frameSwapped and time them by predicted presentation (see FrameScheduler).
+	void setVsyncPacing(bool enabled) {
+		_scheduler->setVsyncPacing(enabled);
+	}
+
+	~OSGWidget() {
+		makeCurrent();
+
+		_picker.release();
+		_capture.release();
+
+		if(_governor) _governor->release();
+
+		doneCurrent();
 	}
 
 	struct MouseEventData {
@@ -217,21 +371,77 @@ public:
 		unsigned int button = 0;
 	};
 
+signals:
+	// The lat/lon under the cursor, as the depth picker resolves it (empty over the sky).
+	void hoverChanged(const QString& latLon);
+
 protected:
 	void initializeGL() override {
 		OE_WARN << "initializeGL; dpr=" << devicePixelRatio() << std::endl;
 
-		osgEarth::initialize();
+		osg_qt6::startupProfile().mark("gl_initialized");
+
+		_viewer = new osgViewer::Viewer();
+
+		_gw = _viewer->setUpViewerAsEmbeddedInWindow(0, 0, width(), height());
 
-		// NOTE: NOT SUPPOSED to use `auto*` with the Map! :) How does this work?
-		auto* map = new osgEarth::Map();
-		auto* imagery = new osgEarth::GDALImageLayer();
+		// NOTE: the setUpViewerAsEmbeddedInWindow set single-threaded for us.
+		// _viewer->setThreadingModel(osgViewer::Viewer::SingleThreaded);
+		_viewer->setCameraManipulator(osg_qt6::createEarthManipulator());
 
-		imagery->setURL("../world.tif");
+		_viewer->addEventHandler(new osg_qt6::FlyToHandler([this](const osgEarth::Viewpoint& from, const osgEarth::Viewpoint& to) {
+			if(_prefetch && _prefetcher) _prefetcher->prefetchFlight(from, to, _viewer->getCamera());
 
-		map->addLayer(imagery);
+			_flying = _prefetcher != nullptr;
+		}));
 
-		auto* node = new osgEarth::MapNode(map);
+		osg_qt6::setUpCompileBudget(_viewer, _compileBudget);
+
+		// _viewer->addEventHandler(new MouseDebugHandler());
+		_viewer->setSceneData(osg_qt6::createPlaceholderGlobe());
+
+		osg_qt6::trace::install(_viewer);
+
+		_scheduler->setViewer(_viewer);
+
+		_input.setEventQueue(_viewer->getEventQueue());
+
+		// NOTE: Written by tool-seed-cache; without one, every tile comes straight from GDAL. The
+		// compressed one is also filled in as tiles are transcoded, so it needn't exist yet.
+		auto cache = qEnvironmentVariable("OSG_QT6_TILE_CACHE", _compressedTiles ? "tile-cache-bc" : "tile-cache");
+
+		_loader.start(this, [
+			cachePath=QDir(cache).exists() || _compressedTiles ? cache.toStdString() : "",
+			compressed=_compressedTiles,
+			budget=_compileBudget
+		](osg_qt6::StartupProfile& profile) {
+			return osg_qt6::buildMapNode([&]() {
+				// NOTE: Always wrapped for prefetching, so the landing metric is there to compare against
+				// even when --prefetch isn't given.
+				auto* node = osg_qt6::createWorldMapNode(cachePath, true, compressed);
+
+				osg_qt6::setUpCompileBudget(node, budget);
+
+				return node;
+			}, profile);
+		}, [this](osgEarth::MapNode* node) {
+			_setMapNode(node);
+		});
+	}
+
+	// Swaps the map MapLoader built in for the placeholder globe.
+	void _setMapNode(osgEarth::MapNode* node) {
+		auto* placemarks = new osg_qt6::PlacemarkLayer();
+		auto* labels = new osg_qt6::LabelLayer();
+
+		node->addChild(placemarks);
+		node->addChild(labels);
+
+		if(auto count = _placemarkFile.load(placemarks, node->getMapSRS(), [labels](const osgEarth::GeoPoint& gp) {
+			labels->add(gp, formatLatLon(gp));
+		})) {
+			OE_NOTICE << "Restored " << count << " placemarks" << std::endl;
+		}
 
 #if 0
 		// ======================================
@@ -254,23 +464,26 @@ protected:
 		// =====================================
 #endif
 
-		_viewer = new osgViewer::Viewer();
-
-		_gw = _viewer->setUpViewerAsEmbeddedInWindow(0, 0, width(), height());
+		if(auto* layer = node->getMap()->getLayer<PrefetchImageLayer>()) {
+			_prefetcher = std::make_unique<osg_qt6::TilePrefetcher>(layer);
+		}
 
-		// NOTE: the setUpViewerAsEmbeddedInWindow set single-threaded for us.
-		// _viewer->setThreadingModel(osgViewer::Viewer::SingleThreaded);
-		_viewer->setCameraManipulator(new osgEarth::EarthManipulator());
-		_viewer->addEventHandler(new ClickToLatLonHandler(node));
-		// _viewer->addEventHandler(new MouseDebugHandler());
+		_viewer->addEventHandler(new ClickToLatLonHandler(node, placemarks, &_picker, &_placemarkFile, labels));
 		_viewer->setSceneData(node);
 
 		osgEarth::MapNodeHelper().configureView(_viewer);
+
+		osg_qt6::startupProfile().mark("scene_swapped");
+
+		_mapReady = true;
+		_scheduler->requestFrame();
 	}
 
 	void resizeGL(int w, int h) override {
 		OE_WARN << "resizeGL: " << w << " x " << h << std::endl;
 
+		_recorder.resize(w, h);
+
 		_viewer->getCamera()->setViewport(new osg::Viewport(0, 0, w, h));
 		_viewer->getCamera()->setProjectionMatrixAsPerspective(30.0f, static_cast<double>(w) / h, 1.0, 1000.0);
 		_viewer->getEventQueue()->windowResize(0, 0, w, h);
@@ -279,10 +492,60 @@ protected:
 	}
 
 	void paintGL() override {
-		// OE_WARN << "paintGL" << std::endl;
+		OSG_QT6_TRACE_SCOPE("paintGL");
+
+		auto dpr = devicePixelRatio();
+		int w = static_cast<int>(width() * dpr);
+		int h = static_cast<int>(height() * dpr);
+
+		if(_governor) _governor->begin(_viewer, w, h);
+
+		else _viewer->getCamera()->getGraphicsContext()->setDefaultFboId(defaultFramebufferObject());
+
+		_input.flush();
+
+		// NOTE: Between frames, like the callbacks it runs expect.
+		osg_qt6::memoryLedger().enforce();
+
+		QElapsedTimer cpu;
+
+		cpu.start();
+
+		osg_qt6::trace::frame(_viewer, _scheduler->frameTime());
+
+		if(_governor) {
+			auto scale = _governor->viewportScale(dpr);
+			auto changes = _governor->history().size();
+
+			_picker.readback(_governor->fbo(), _governor->samples(), _viewer->getCamera(), scale, scale);
+			_governor->end(defaultFramebufferObject(), w, h, _viewer, cpu.nsecsElapsed() / 1.0e6);
+
+			if(_governor->history().size() != changes) OE_NOTICE << "Quality: scale="
+				<< _governor->scale() << ", samples="
+				<< _governor->samples() << std::endl
+			;
+		}
+
+		else _picker.readback(defaultFramebufferObject(), format().samples(), _viewer->getCamera(), dpr);
+
+		_picker.poll();
+
+		// NOTE: After the governor's upscale, so frames are captured at the widget's own size.
+		_capture.capture(defaultFramebufferObject(), format().samples(), w, h);
+		_capture.poll();
+
+		auto& profile = osg_qt6::startupProfile();
+
+		profile.markOnce("first_frame");
 
-		_viewer->getCamera()->getGraphicsContext()->setDefaultFboId(defaultFramebufferObject());
-		_viewer->frame();
+		if(_mapReady && profile.markOnce("first_map_frame")) OE_NOTICE << "Startup: " << profile.toString() << std::endl;
+
+		if(_flying) _checkLanded();
+
+		_scheduler->frameRendered();
+		_schedulePoll();
+
+		_swap.begin();
 	}
 
 	auto _mouseEventData(QMouseEvent* event) const {
@@ -290,67 +553,145 @@ protected:
 	}
 
 	void keyPressEvent(QKeyEvent* event) override {
-		if(event->key() == Qt::Key_Space) {
-			OE_WARN << "keyPressEvent: " << event->key() << std::endl;
+		OSG_QT6_TRACE_SCOPE("keyPressEvent");
+
+		// NOTE: Every key goes to the viewer (and any recording) through _input, the ones handled
+		// right here included; the Space fly-to is FlyToHandler's.
+		if(auto key = osgKey(event)) _input.keyPress(key);
+
+		if(event->key() == Qt::Key_F11) {
+			auto path = QDir::current().filePath("memory.json");
 
-			double zoom = 500.0 + (4.0 * std::pow(2, (22 - std::clamp(static_cast<int>(15), 0, 22))));
+			if(!osg_qt6::memoryLedger().dump(path)) OE_WARN << "Couldn't write " << path.toStdString() << std::endl;
 
-			osgEarth::Viewpoint vp(
-				"Target", // Name (optional, used for reference)
-				-76.0,
-				39.0,
-				0.0, // Altitude
-				0.0, // Heading (azimuth, degrees, 0 = north)
-				-90.0, // Pitch (tilt, degrees, -90 = straight down)
-				5000 // Range from target in meters (eye-to-ground distance)
-			);
+			else OE_NOTICE << "Memory: " << QJsonDocument(
+				osg_qt6::memoryLedger().toJson()["totals"].toObject()
+			).toJson(QJsonDocument::Compact).toStdString() << " (" << path.toStdString() << ")" << std::endl;
 
-			auto* manip = dynamic_cast<osgEarth::Util::EarthManipulator*>(_viewer->getCameraManipulator());
+			return;
+		}
 
-			if(!manip) return;
+		if(event->key() == Qt::Key_F12) {
+			if(!_capture.capturing()) startCapture();
 
-			OE_WARN << "setViewpoint" << std::endl;
+			else {
+				_capture.stop();
 
-			manip->setViewpoint(vp, 1.0);
+				OE_NOTICE << "Captured " << _capture.framesCaptured() << " frames ("
+					<< _capture.framesDropped() << " dropped)" << std::endl
+				;
+			}
 
-			// _viewer->getEventQueue()->keyPress(key, event->key());
+			return;
 		}
 	}
 
+	void keyReleaseEvent(QKeyEvent* event) override {
+		OSG_QT6_TRACE_SCOPE("keyReleaseEvent");
+
+		if(auto key = osgKey(event)) _input.keyRelease(key);
+	}
+
 	void mousePressEvent(QMouseEvent* event) override {
-		auto med = _mouseEventData(event);
+		OSG_QT6_TRACE_SCOPE("mousePressEvent");
 
-		OE_WARN << "mousePressEvent: " << med << std::endl;
+		auto med = _mouseEventData(event);
 
-		_viewer->getEventQueue()->mouseButtonPress(med.x, med.y, med.button);
+		_input.mousePress(med.x, med.y, med.button);
 	}
 
 	void mouseMoveEvent(QMouseEvent* event) override {
+		OSG_QT6_TRACE_SCOPE("mouseMoveEvent");
+
 		auto med = _mouseEventData(event);
 
-		OE_WARN << "mouseMoveEvent: " << med << std::endl;
+		_input.mouseMove(med.x, med.y);
+
+		// NOTE: Read back with whichever frame this move triggers; only the newest hover is kept.
+		_picker.pick(med.x, med.y, [this](bool hit, const osg::Vec3d& wp) {
+			osg::ref_ptr<osgEarth::MapNode> mapNode = osgEarth::MapNode::get(_viewer->getSceneData());
+
+			if(!hit || !mapNode.valid()) {
+				emit hoverChanged(QString());
+
+				return;
+			}
+
+			osgEarth::GeoPoint gp;
+
+			gp.fromWorld(mapNode->getMapSRS(), wp);
 
-		_viewer->getEventQueue()->mouseMotion(med.x, med.y);
+			emit hoverChanged(QString::fromStdString(formatLatLon(gp)));
+		}, true);
 	}
 
 	void mouseReleaseEvent(QMouseEvent* event) override {
-		auto med = _mouseEventData(event);
+		OSG_QT6_TRACE_SCOPE("mouseReleaseEvent");
 
-		OE_WARN << "mouseReleaseEvent: " << med << std::endl;
+		auto med = _mouseEventData(event);
 
-		_viewer->getEventQueue()->mouseButtonRelease(med.x, med.y, med.button);
+		_input.mouseRelease(med.x, med.y, med.button);
 	}
 
 	void wheelEvent(QWheelEvent* event) override {
+		OSG_QT6_TRACE_SCOPE("wheelEvent");
+
 		auto delta = static_cast<float>(event->angleDelta().y()) / 120.0f;
 
-		OE_WARN << "wheelEvent: " << delta << std::endl;
+		_input.wheel(static_cast<float>(event->angleDelta().x()) / 120.0f, delta);
+	}
 
-		_viewer->getEventQueue()->mouseScroll(
-			delta > 0.0f ?
-			osgGA::GUIEventAdapter::SCROLL_UP :
-			osgGA::GUIEventAdapter::SCROLL_DOWN
-		);
+	// Readbacks still in flight are collected without rendering another frame just for them.
+	void _schedulePoll() {
+		if(_pollQueued || !(_picker.pending() || _capture.pending())) return;
+
+		_pollQueued = true;
+
+		QTimer::singleShot(4, this, [this]() {
+			_pollQueued = false;
+
+			makeCurrent();
+
+			_picker.poll();
+			_capture.poll();
+
+			doneCurrent();
+
+			_schedulePoll();
+		});
+	}
+
+	void _checkLanded() {
+		auto* manip = dynamic_cast<osgEarth::Util::EarthManipulator*>(_viewer->getCameraManipulator());
+
+		if(!manip || manip->isSettingViewpoint()) return;
+
+		_flying = false;
+
+		_prefetcher->landed(manip->getViewpoint(), _viewer->getCamera());
+
+		_waitForFullResolution();
+	}
+
+	// NOTE: Tiles keep arriving whether or not frames are being rendered, so this is polled on a
+	// timer instead of from paintGL().
+	void _waitForFullResolution() {
+		QTimer::singleShot(100, this, [this]() {
+			if(!_prefetcher || !_prefetcher->watching()) return;
+
+			auto ms = _prefetcher->takeFullResolutionMs();
+
+			if(ms < 0.0) {
+				_waitForFullResolution();
+
+				return;
+			}
+
+			OE_NOTICE << "Full resolution " << ms << " ms after landing (prefetch "
+				<< (_prefetch ? "on" : "off") << ", "
+				<< _prefetcher->prefetched() << " tiles prefetched)" << std::endl
+			;
+		});
 	}
 
 private:
@@ -358,16 +699,110 @@ private:
 
 	osgViewer::GraphicsWindowEmbedded* _gw;
 
-	QTimer* _timer = nullptr;
+	osg_qt6::FrameScheduler* _scheduler = nullptr;
+
+	osg_qt6::CompileBudget _compileBudget;
+	osg_qt6::MapLoader _loader;
+	osg_qt6::PlacemarkFile _placemarkFile;
+
+	bool _mapReady = false;
+	bool _prefetch = false;
+	bool _compressedTiles = false;
+	bool _flying = false;
+
+	osg_qt6::trace::Span _swap;
+	osg_qt6::InputCoalescer _input;
+	osg_qt6::InputRecorder _recorder;
+	osg_qt6::DepthPicker _picker;
+	osg_qt6::FrameCapture _capture;
+
+	std::string _captureOutput = "capture";
+
+	osg_qt6::FrameCapture::Format _captureFormat = osg_qt6::FrameCapture::PNG;
+
+	std::unique_ptr<osg_qt6::QualityGovernor> _governor;
+	std::unique_ptr<osg_qt6::TilePrefetcher> _prefetcher;
+
+	bool _pollQueued = false;
 };
 
 int main(int argc, char** argv) {
+	osg_qt6::startupProfile().mark("main");
+
 	// QCoreApplication::setAttribute(Qt::AA_UseDesktopOpenGL);
 
 	QApplication app(argc, argv);
+
+	osg_qt6::trace::startFromEnvironment();
+	osg_qt6::trace::setThreadName("gui");
+
+	QCommandLineParser parser;
+
+	parser.addHelpOption();
+	parser.addOptions({
+		{"governor", "Scale render resolution/MSAA to hold --target-fps."},
+		{"target-fps", "Frame rate the quality governor aims for.", "fps", "60"},
+		{"vsync-pacing", "Pace frames by buffer swaps and animate by predicted presentation time."},
+		{"compile-budget-ms", "Per-frame GL compile budget for new tiles (0 compiles inline).", "ms", "4"},
+		{"merges-per-frame", "New terrain tiles merged per frame (0 for all).", "count", "0"},
+		{"pager-threads", "Tile loading threads (0 for the default).", "count", "0"},
+		{"placemarks", "File clicked placemarks are saved to and restored from (empty to disable).", "path", "placemarks.txt"},
+		{"prefetch", "Prefetch the tiles a Space fly-to will need as it starts."},
+		{"compressed", "Upload imagery block compressed, through a DDS tile cache."},
+		{"memory-budget", "Per-layer memory budgets, e.g. PrefetchImageLayer=256 (F11 dumps memory.json).", "name=MB,..."},
+		{"record", "Record all input to this file (see bench-replay).", "path"},
+		{"capture", "Start capturing frames right away (F12 toggles it at any time)."},
+		{"capture-output", "PNG directory, or raw RGBA file with --capture-format raw.", "path", "capture"},
+		{"capture-format", "Capture format: png, raw.", "format", "png"}
+	});
+	parser.process(app);
+
+	for(const auto& budget : parser.value("memory-budget").split(',', Qt::SkipEmptyParts)) {
+		auto pair = budget.split('=');
+
+		if(pair.size() != 2) {
+			OE_WARN << "Ignoring memory budget " << budget.toStdString() << std::endl;
+
+			continue;
+		}
+
+		osg_qt6::memoryLedger().setBudget(
+			pair[0].trimmed().toStdString(),
+			static_cast<int64_t>(pair[1].toDouble() * 1024.0 * 1024.0)
+		);
+	}
+
 	QMainWindow mainWindow;
 
-	auto* osgWidget = new OSGWidget();
+	auto* osgWidget = new OSGWidget(
+		nullptr,
+		parser.isSet("governor") ? 1000.0 / std::max(1.0, parser.value("target-fps").toDouble()) : 0.0
+	);
+
+	osgWidget->setVsyncPacing(parser.isSet("vsync-pacing"));
+	osgWidget->setPrefetch(parser.isSet("prefetch"));
+	osgWidget->setCompressedTiles(parser.isSet("compressed"));
+	osgWidget->setPlacemarkFile(parser.value("placemarks").toStdString());
+	osgWidget->setCompileBudget({
+		parser.value("compile-budget-ms").toDouble(),
+		parser.value("merges-per-frame").toInt(),
+		parser.value("pager-threads").toInt()
+	});
+
+	QObject::connect(osgWidget, &OSGWidget::hoverChanged, mainWindow.statusBar(), [&mainWindow](const QString& latLon) {
+		mainWindow.statusBar()->showMessage(latLon);
+	});
+
+	if(parser.isSet("record") && !osgWidget->record(parser.value("record").toStdString())) {
+		OE_WARN << "Couldn't record to " << parser.value("record").toStdString() << std::endl;
+	}
+
+	osgWidget->setCaptureOutput(
+		parser.value("capture-output").toStdString(),
+		parser.value("capture-format") == "raw" ? osg_qt6::FrameCapture::RAW : osg_qt6::FrameCapture::PNG
+	);
+
+	if(parser.isSet("capture")) osgWidget->startCapture();
 
 	mainWindow.setCentralWidget(osgWidget);
 	mainWindow.resize(800, 600);
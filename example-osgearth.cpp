@@ -2,9 +2,6 @@
 #include <QOpenGLFunctions>
 #include <QApplication>
 #include <QMainWindow>
-#include <QTimer>
-
-#include <osgDB/ReadFile>
 
 #include <osgViewer/Viewer>
 #include <osgViewer/GraphicsWindow>
@@ -15,43 +12,10 @@
 #include <osgEarth/EarthManipulator>
 #include <osgEarth/ExampleResources>
 
-class MyTextureLayer: public osgEarth::ImageLayer {
-public:
-	META_Layer(osgEarth, MyTextureLayer, Options, ImageLayer, mytexturelayer);
-
-	void setPath(const std::string& path) {
-		_path = path.c_str();
-	}
-
-	virtual osgEarth::Status openImplementation() {
-		osg::ref_ptr<osg::Image> image = osgDB::readRefImageFile(_path);
-
-		if(image.valid()) _tex = new osg::Texture2D(image.get());
-
-		else return osgEarth::Status(osgEarth::Status::ConfigurationError, "no path");
-
-		setProfile(osgEarth::Profile::create(osgEarth::Profile::GLOBAL_GEODETIC));
-		setUseCreateTexture();
-		addDataExtent(osgEarth::DataExtent(getProfile()->getExtent(), 0, 0));
-
-		return osgEarth::Status::OK();
-	}
-
-	virtual osgEarth::TextureWindow createTexture(
-		const osgEarth::TileKey& key,
-		osgEarth::ProgressCallback* progress
-	) const {
-		osg::Matrixf textureMatrix;
-
-		key.getExtent().createScaleBias(getProfile()->getExtent(), textureMatrix);
-
-		return osgEarth::TextureWindow(_tex.get(), textureMatrix);
-	}
-
-protected:
-	std::string _path;
-	osg::ref_ptr<osg::Texture2D> _tex;
-};
+#include "osg-qt6/earth-scenes.hpp"
+#include "osg-qt6/frame-scheduler.hpp"
+#include "osg-qt6/map-loader.hpp"
+#include "osg-qt6/trace.hpp"
 
 class OSGWidget: public QOpenGLWidget, protected QOpenGLFunctions {
 
@@ -60,45 +24,44 @@ Q_OBJECT
 public:
 	OSGWidget(QWidget* parent=nullptr):
 	QOpenGLWidget(parent) {
-		_timer = new QTimer(this);
-
-		// connect(_timer, &QTimer::timeout, this, &OSGWidget::update);
-		// connect(_timer, &QTimer::timeout, this, QOverload<>::of(&OSGWidget::repaint));
-		connect(_timer, &QTimer::timeout, this, QOverload<>::of(&OSGWidget::update));
+		_scheduler = new osg_qt6::FrameScheduler(this);
 
-		_timer->start(1000 / 60);
+		connect(this, &QOpenGLWidget::frameSwapped, [this]() {
+			_swap.end("swap");
+		});
 	}
 
 protected:
 	void initializeGL() override {
 		OSG_WARN << "initializeGL" << std::endl;
 
-		osgEarth::initialize();
-
-		osgEarth::Map* map = new osgEarth::Map();
-
-		/* osgEarth::GDALImageLayer* imagery = new osgEarth::GDALImageLayer();
+		osg_qt6::startupProfile().mark("gl_initialized");
 
-		imagery->setURL("../world.tif");
-
-		map->addLayer(imagery); */
+		// NOTE: The window shows a placeholder globe right away; the map (osgEarth::initialize(),
+		// layers, terrain engine) is built on the MapLoader's thread and swapped in when it's done.
+		_viewer = new osgViewer::Viewer();
+		_viewer->setUpViewerAsEmbeddedInWindow(0, 0, width(), height());
+		_viewer->setThreadingModel(osgViewer::Viewer::SingleThreaded);
+		_viewer->setCameraManipulator(new osgEarth::EarthManipulator());
+		_viewer->setSceneData(osg_qt6::createPlaceholderGlobe());
 
-		auto texLayer = new MyTextureLayer();
+		osg_qt6::trace::install(_viewer);
 
-		texLayer->setPath("../grid2.png");
-		texLayer->setOpacity(0.5f);
+		_scheduler->setViewer(_viewer);
 
-		map->addLayer(texLayer);
+		_loader.start(this, [](osg_qt6::StartupProfile& profile) {
+			// NOTE: Swap in `osg_qt6::createWorldMapNode()` for the GDAL world.tif imagery instead.
+			return osg_qt6::buildMapNode(osg_qt6::createGridMapNode, profile);
+		}, [this](osgEarth::MapNode* node) {
+			_viewer->setSceneData(node);
 
-		osgEarth::MapNode* node = new osgEarth::MapNode(map);
+			osgEarth::MapNodeHelper().configureView(_viewer);
 
-		_viewer = new osgViewer::Viewer();
-		_viewer->setUpViewerAsEmbeddedInWindow(0, 0, width(), height());
-		_viewer->setThreadingModel(osgViewer::Viewer::SingleThreaded);
-		_viewer->setCameraManipulator(new osgEarth::EarthManipulator());
-		_viewer->setSceneData(node);
+			osg_qt6::startupProfile().mark("scene_swapped");
 
-		osgEarth::MapNodeHelper().configureView(_viewer);
+			_mapReady = true;
+			_scheduler->requestFrame();
+		});
 	}
 
 	void resizeGL(int w, int h) override {
@@ -109,26 +72,49 @@ protected:
 	}
 
 	void paintGL() override {
-		OSG_WARN << "paintGL" << std::endl;
+		OSG_QT6_TRACE_SCOPE("paintGL");
 
 		// TODO: This is important! I'm still investigating what value is actually being implied by
 		// `defaultFramebufferObject()` here; however, this simple example SEEMS to work without it.
 		// I imagine anything but the most trivial osgEarth examples will need to address this.
 		// _viewer->getCamera()->getGraphicsContext()->setDefaultFboId(defaultFramebufferObject());
-		_viewer->frame();
+		osg_qt6::trace::frame(_viewer);
+
+		_markStartup();
+
+		_scheduler->frameRendered();
+
+		_swap.begin();
+	}
+
+	void _markStartup() {
+		auto& profile = osg_qt6::startupProfile();
+
+		profile.markOnce("first_frame");
+
+		if(_mapReady && profile.markOnce("first_map_frame")) OSG_NOTICE << "Startup: " << profile.toString() << std::endl;
 	}
 
 private:
 	osg::ref_ptr<osgViewer::Viewer> _viewer;
 
-	QTimer* _timer = nullptr;
+	osg_qt6::FrameScheduler* _scheduler = nullptr;
+	osg_qt6::trace::Span _swap;
+	osg_qt6::MapLoader _loader;
+
+	bool _mapReady = false;
 };
 
 int main(int argc, char** argv) {
+	osg_qt6::startupProfile().mark("main");
+
 	QCoreApplication::setAttribute(Qt::AA_UseDesktopOpenGL);
 
 	QApplication app(argc, argv);
 
+	osg_qt6::trace::startFromEnvironment();
+	osg_qt6::trace::setThreadName("gui");
+
 	QMainWindow mainWindow;
 
 	OSGWidget* osgWidget = new OSGWidget();
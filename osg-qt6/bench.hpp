@@ -0,0 +1,214 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <vector>
+
+#include <cstdio>
+#include <string>
+
+#ifdef __unix__
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+#include <QJsonObject>
+#include <QJsonDocument>
+#include <QTextStream>
+
+#include <osg/Stats>
+#include <osgViewer/Viewer>
+
+namespace osg_qt6 {
+
+// A bag of timing samples (milliseconds, unless the caller says otherwise) that knows how to turn
+// itself into the percentile summary every bench-* target reports.
+class Samples {
+public:
+	void add(double value) {
+		_values.push_back(value);
+		_sorted = false;
+	}
+
+	size_t size() const {
+		return _values.size();
+	}
+
+	bool empty() const {
+		return _values.empty();
+	}
+
+	double percentile(double p) {
+		if(_values.empty()) return 0.0;
+
+		_sort();
+
+		auto i = static_cast<size_t>(p / 100.0 * static_cast<double>(_values.size() - 1) + 0.5);
+
+		return _values[std::min(i, _values.size() - 1)];
+	}
+
+	double mean() const {
+		if(_values.empty()) return 0.0;
+
+		double sum = 0.0;
+
+		for(auto v : _values) sum += v;
+
+		return sum / static_cast<double>(_values.size());
+	}
+
+	double variance() const {
+		if(_values.size() < 2) return 0.0;
+
+		double m = mean();
+		double sum = 0.0;
+
+		for(auto v : _values) sum += (v - m) * (v - m);
+
+		return sum / static_cast<double>(_values.size() - 1);
+	}
+
+	double max() {
+		if(_values.empty()) return 0.0;
+
+		_sort();
+
+		return _values.back();
+	}
+
+	QJsonObject toJson() {
+		return {
+			{"count", static_cast<qint64>(_values.size())},
+			{"mean", mean()},
+			{"p50", percentile(50.0)},
+			{"p90", percentile(90.0)},
+			{"p95", percentile(95.0)},
+			{"p99", percentile(99.0)},
+			{"max", max()}
+		};
+	}
+
+private:
+	void _sort() {
+		if(_sorted) return;
+
+		std::sort(_values.begin(), _values.end());
+
+		_sorted = true;
+	}
+
+	std::vector<double> _values;
+
+	bool _sorted = true;
+};
+
+// Per-phase frame timings, as osgViewer itself measures them (the same numbers the StatsHandler
+// overlay shows). GPU times come from timer queries and lag a few frames behind, so collect()
+// should be handed a frame number at least that old.
+class FrameStats {
+public:
+	static constexpr unsigned int LAG = 4;
+
+	void enable(osgViewer::Viewer* viewer) {
+		viewer->getViewerStats()->collectStats("event", true);
+		viewer->getViewerStats()->collectStats("update", true);
+		viewer->getCamera()->getStats()->collectStats("rendering", true);
+		viewer->getCamera()->getStats()->collectStats("gpu", true);
+	}
+
+	// Frames before `frameNumber` (warmup, say) are never collected.
+	void setFirstFrame(unsigned int frameNumber) {
+		_first = frameNumber;
+	}
+
+	void collect(osgViewer::Viewer* viewer, unsigned int frameNumber) {
+		if(frameNumber < _first) return;
+
+		auto* viewerStats = viewer->getViewerStats();
+		auto* cameraStats = viewer->getCamera()->getStats();
+
+		for(auto& phase : _phases) {
+			auto* stats = phase.camera ? cameraStats : viewerStats;
+			double seconds = 0.0;
+
+			if(stats && stats->getAttribute(frameNumber, phase.attribute, seconds)) phase.samples.add(seconds * 1000.0);
+		}
+	}
+
+	// For the frames newer than LAG at the end of a run.
+	void collectRemaining(osgViewer::Viewer* viewer) {
+		auto latest = viewer->getViewerFrameStamp()->getFrameNumber();
+
+		for(unsigned int i = LAG; i > 0; i--) if(latest >= i) collect(viewer, latest - i + 1);
+	}
+
+	QJsonObject toJson() {
+		QJsonObject obj;
+
+		for(auto& phase : _phases) obj[phase.name] = phase.samples.toJson();
+
+		return obj;
+	}
+
+	Samples& phase(const char* name) {
+		for(auto& phase : _phases) if(std::string(phase.name) == name) return phase.samples;
+
+		return _phases.front().samples;
+	}
+
+private:
+	struct Phase {
+		const char* name;
+		const char* attribute;
+
+		bool camera;
+
+		Samples samples;
+	};
+
+	std::array<Phase, 5> _phases = {{
+		{"event", "Event traversal time taken", false, {}},
+		{"update", "Update traversal time taken", false, {}},
+		{"cull", "Cull traversal time taken", true, {}},
+		{"draw", "Draw traversal time taken", true, {}},
+		{"gpu", "GPU draw time taken", true, {}}
+	}};
+
+	unsigned int _first = 0;
+};
+
+// Peak resident set size of this process, in KiB (0 where we don't know how to ask).
+inline long peakRssKb() {
+#ifdef __unix__
+	struct rusage usage;
+
+	if(getrusage(RUSAGE_SELF, &usage) == 0) return usage.ru_maxrss;
+#endif
+
+	return 0;
+}
+
+// Current resident set size of this process, in KiB (Linux only; 0 elsewhere).
+inline long currentRssKb() {
+	long pages = 0;
+	long resident = 0;
+
+	if(FILE* f = std::fopen("/proc/self/statm", "r")) {
+		if(std::fscanf(f, "%ld %ld", &pages, &resident) != 2) resident = 0;
+
+		std::fclose(f);
+	}
+
+#ifdef __unix__
+	return resident * (sysconf(_SC_PAGESIZE) / 1024);
+#else
+	return 0;
+#endif
+}
+
+inline void writeJson(const QJsonObject& obj) {
+	QTextStream(stdout) << QJsonDocument(obj).toJson(QJsonDocument::Indented);
+}
+
+}
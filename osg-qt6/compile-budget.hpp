@@ -0,0 +1,70 @@
+#pragma once
+
+#include <limits>
+
+#include <osgDB/DatabasePager>
+#include <osgUtil/IncrementalCompileOperation>
+#include <osgViewer/Viewer>
+
+#include <osgEarth/MapNode>
+
+namespace osg_qt6 {
+
+// How much of each frame the (single-threaded, embedded) viewer may spend bringing newly loaded
+// data in: GL compilation/uploads and merging into the scene graph. Without this, everything the
+// pager or osgEarth's terrain loader finished since the last frame is compiled lazily by the first
+// draw that touches it, so flying fast across the globe turns into frame-time spikes.
+struct CompileBudget {
+	// Per-frame milliseconds for the IncrementalCompileOperation; 0 leaves compilation inline.
+	double compileMs = 4.0;
+
+	// New terrain tiles merged into the scene per frame (0 is osgEarth's default, "all of them").
+	int mergesPerFrame = 0;
+
+	// DatabasePager/terrain loader threads (0 leaves the defaults).
+	int pagerThreads = 0;
+};
+
+// Installs an IncrementalCompileOperation on `viewer` (which must already have its graphics
+// context, i.e. after setUpViewerAsEmbeddedInWindow()) and sizes the DatabasePager's thread pool.
+// The ICO runs from the context's operation queue during renderingTraversals(), so it works in the
+// examples' SingleThreaded mode too; the pager (and osgEarth's terrain merger) hands it new
+// subgraphs and only merges them once they're compiled.
+inline osgUtil::IncrementalCompileOperation* setUpCompileBudget(osgViewer::Viewer* viewer, const CompileBudget& budget) {
+	if(budget.pagerThreads > 0) {
+		// NOTE: One of them is kept for HTTP requests, same as the pager's own default split.
+		viewer->getDatabasePager()->setUpThreads(budget.pagerThreads + 1, 1);
+	}
+
+	if(budget.compileMs <= 0.0) {
+		viewer->setIncrementalCompileOperation(nullptr);
+
+		return nullptr;
+	}
+
+	auto* ico = new osgUtil::IncrementalCompileOperation();
+
+	// NOTE: The ICO gives itself whatever is left of a 1/targetFrameRate frame (halved, to be
+	// conservative) but never less than the minimum; with the target at the budget itself, the
+	// minimum always wins and each frame gets exactly `compileMs`, split between deleting
+	// orphaned GL objects and compiling new ones.
+	ico->setTargetFrameRate(1000.0 / budget.compileMs);
+	ico->setMinimumTimeAvailableForGLCompileAndDeletePerFrame(budget.compileMs / 1000.0);
+	ico->setMaximumNumOfObjectsToCompilePerFrame(std::numeric_limits<unsigned int>::max());
+
+	viewer->setIncrementalCompileOperation(ico);
+
+	return ico;
+}
+
+// The terrain half of the budget; call it before the MapNode's first frame (the terrain engine
+// reads its options when it's created).
+inline void setUpCompileBudget(osgEarth::MapNode* mapNode, const CompileBudget& budget) {
+	auto terrain = mapNode->getTerrainOptions();
+
+	if(budget.mergesPerFrame > 0) terrain.setMergesPerFrame(budget.mergesPerFrame);
+
+	if(budget.pagerThreads > 0) terrain.setConcurrency(static_cast<unsigned int>(budget.pagerThreads));
+}
+
+}
@@ -0,0 +1,252 @@
+#pragma once
+
+#include <array>
+#include <deque>
+#include <functional>
+#include <optional>
+
+#include <QOpenGLContext>
+#include <QOpenGLExtraFunctions>
+
+#include <osg/Camera>
+
+namespace osg_qt6 {
+
+// Picks by reading back the depth buffer under the cursor instead of intersecting rays against
+// the scene graph. The read goes into a pixel buffer object and is only mapped once its fence has
+// signaled (typically a frame or two later), so neither the CPU nor the GPU ever waits on it; the
+// depth is then unprojected with the matrices of the frame it came from and handed to the callback.
+//
+// Per frame, with the widget's context current and right after `_viewer->frame()`:
+//
+//   _picker.readback(defaultFramebufferObject(), format().samples(), _viewer->getCamera(), devicePixelRatio());
+//   _picker.poll();
+class DepthPicker {
+public:
+	// `hit` is false when there was nothing under the cursor (i.e., the far plane/sky).
+	using Callback = std::function<void(bool hit, const osg::Vec3d& world)>;
+
+	static constexpr size_t SLOTS = 4;
+
+	~DepthPicker() {
+		release();
+	}
+
+	// (x, y) are window coordinates in the OSG convention (origin at the bottom left), exactly as
+	// they're handed to the EventQueue. Hover picks replace any hover pick that hasn't been read
+	// yet (only the latest position matters); other picks are queued in order.
+	void pick(float x, float y, Callback callback, bool hover=false) {
+		if(hover) {
+			for(auto& r : _requests) if(r.hover) {
+				r = {x, y, std::move(callback), true};
+
+				return;
+			}
+		}
+
+		_requests.push_back({x, y, std::move(callback), hover});
+	}
+
+	// Whether this context can do it at all (PBOs + fences); if not, use the intersector instead.
+	bool supported() const {
+		auto* ctx = QOpenGLContext::currentContext();
+
+		return ctx && ctx->format().version() >= qMakePair(3, 0);
+	}
+
+	// `dpr` maps pick coordinates to pixels in `fbo`; `viewportScale` maps them to the camera's
+	// viewport (which is in logical pixels, unless something like QualityGovernor resized it).
+	void readback(GLuint fbo, int samples, const osg::Camera* camera, qreal dpr=1.0, double viewportScale=1.0) {
+		if(_requests.empty() || !_init()) return;
+
+		const osg::Viewport* vp = camera->getViewport();
+
+		if(!vp) return;
+
+		osg::Matrixd inverse = osg::Matrixd::inverse(
+			camera->getViewMatrix() *
+			camera->getProjectionMatrix() *
+			vp->computeWindowMatrix()
+		);
+
+		while(!_requests.empty()) {
+			auto* slot = _freeSlot();
+
+			if(!slot) break;
+
+			auto request = std::move(_requests.front());
+
+			_requests.pop_front();
+
+			auto px = static_cast<GLint>(request.x * dpr);
+			auto py = static_cast<GLint>(request.y * dpr);
+
+			_gl->glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
+
+			// NOTE: Depth can't be read straight out of a multisampled framebuffer; resolve the one
+			// pixel we care about into our own single-sample FBO first.
+			if(samples > 0) {
+				_gl->glBindFramebuffer(GL_DRAW_FRAMEBUFFER, _resolveFbo);
+				_gl->glBlitFramebuffer(px, py, px + 1, py + 1, 0, 0, 1, 1, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+				_gl->glBindFramebuffer(GL_READ_FRAMEBUFFER, _resolveFbo);
+
+				px = 0;
+				py = 0;
+			}
+
+			_gl->glBindBuffer(GL_PIXEL_PACK_BUFFER, slot->pbo);
+			_gl->glReadPixels(px, py, 1, 1, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+			_gl->glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+			slot->fence = _gl->glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+			slot->request = std::move(request);
+			slot->inverse = inverse;
+			slot->viewportScale = viewportScale;
+			slot->sequence = _sequence++;
+		}
+
+		_gl->glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+	}
+
+	// Delivers every pick whose readback has completed, oldest first; never blocks.
+	void poll() {
+		if(!_gl) return;
+
+		while(auto* slot = _oldestSlot()) {
+			GLenum status = _gl->glClientWaitSync(slot->fence, 0, 0);
+
+			if(status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) break;
+
+			float depth = 1.0f;
+
+			_gl->glBindBuffer(GL_PIXEL_PACK_BUFFER, slot->pbo);
+
+			if(void* p = _gl->glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, sizeof(float), GL_MAP_READ_BIT)) {
+				depth = *static_cast<float*>(p);
+
+				_gl->glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+			}
+
+			_gl->glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+			_gl->glDeleteSync(slot->fence);
+
+			slot->fence = nullptr;
+
+			auto request = std::move(*slot->request);
+
+			slot->request.reset();
+
+			bool hit = depth < 1.0f;
+			osg::Vec3d world = osg::Vec3d(
+				request.x * slot->viewportScale,
+				request.y * slot->viewportScale,
+				depth
+			) * slot->inverse;
+
+			if(request.callback) request.callback(hit, world);
+		}
+	}
+
+	size_t pending() const {
+		size_t n = _requests.size();
+
+		for(const auto& slot : _slots) if(slot.request) n++;
+
+		return n;
+	}
+
+	// Context must be current.
+	void release() {
+		if(!_gl || QOpenGLContext::currentContext() != _context) return;
+
+		for(auto& slot : _slots) {
+			if(slot.fence) _gl->glDeleteSync(slot.fence);
+
+			_gl->glDeleteBuffers(1, &slot.pbo);
+
+			slot = {};
+		}
+
+		_gl->glDeleteFramebuffers(1, &_resolveFbo);
+		_gl->glDeleteRenderbuffers(1, &_resolveDepth);
+
+		_gl = nullptr;
+	}
+
+private:
+	struct Request {
+		float x = 0.0f;
+		float y = 0.0f;
+
+		Callback callback;
+
+		bool hover = false;
+	};
+
+	struct Slot {
+		GLuint pbo = 0;
+		GLsync fence = nullptr;
+
+		std::optional<Request> request;
+
+		osg::Matrixd inverse;
+
+		double viewportScale = 1.0;
+
+		unsigned long long sequence = 0;
+	};
+
+	bool _init() {
+		if(_gl) return true;
+
+		if(!supported()) return false;
+
+		_context = QOpenGLContext::currentContext();
+		_gl = _context->extraFunctions();
+
+		for(auto& slot : _slots) {
+			_gl->glGenBuffers(1, &slot.pbo);
+			_gl->glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+			_gl->glBufferData(GL_PIXEL_PACK_BUFFER, sizeof(float), nullptr, GL_STREAM_READ);
+		}
+
+		_gl->glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+		// NOTE: Must match QOpenGLWidget's packed depth/stencil format for the resolve blit.
+		_gl->glGenRenderbuffers(1, &_resolveDepth);
+		_gl->glBindRenderbuffer(GL_RENDERBUFFER, _resolveDepth);
+		_gl->glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, 1, 1);
+		_gl->glGenFramebuffers(1, &_resolveFbo);
+		_gl->glBindFramebuffer(GL_FRAMEBUFFER, _resolveFbo);
+		_gl->glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, _resolveDepth);
+
+		return true;
+	}
+
+	Slot* _freeSlot() {
+		for(auto& slot : _slots) if(!slot.request) return &slot;
+
+		return nullptr;
+	}
+
+	Slot* _oldestSlot() {
+		Slot* oldest = nullptr;
+
+		for(auto& slot : _slots) if(slot.request && (!oldest || slot.sequence < oldest->sequence)) oldest = &slot;
+
+		return oldest;
+	}
+
+	QOpenGLContext* _context = nullptr;
+	QOpenGLExtraFunctions* _gl = nullptr;
+
+	std::deque<Request> _requests;
+	std::array<Slot, SLOTS> _slots;
+
+	GLuint _resolveFbo = 0;
+	GLuint _resolveDepth = 0;
+
+	unsigned long long _sequence = 0;
+};
+
+}
@@ -0,0 +1,160 @@
+#pragma once
+
+#include <functional>
+
+#include <osg/CoordinateSystemNode>
+#include <osg/Geode>
+#include <osg/ShapeDrawable>
+#include <osgGA/GUIEventHandler>
+#include <osgViewer/View>
+
+#include <osgEarth/MapNode>
+#include <osgEarth/ImageLayer>
+#include <osgEarth/GDAL>
+#include <osgEarth/EarthManipulator>
+
+#include "osg-qt6/my-texture-layer.hpp"
+#include "osg-qt6/tile-cache.hpp"
+#include "osg-qt6/tile-prefetch.hpp"
+
+namespace osg_qt6 {
+
+// NOTE: Both of these expect `osgEarth::initialize()` to have been called already, and (like the
+// examples) resolve their data relative to a build directory one level below the repository.
+
+// The map from example-osgearth: grid2.png draped over the whole globe at 50% opacity. Given a
+// `compressedCache` directory, it's uploaded block compressed from there (see
+// MyTextureLayer::setCompressedCache()).
+inline osgEarth::MapNode* createGridMapNode(const std::string& compressedCache="") {
+	osgEarth::Map* map = new osgEarth::Map();
+
+	auto texLayer = new MyTextureLayer();
+
+	texLayer->setPath("../grid2.png");
+	texLayer->setCompressedCache(compressedCache);
+	texLayer->setOpacity(0.5f);
+
+	map->addLayer(texLayer);
+
+	return new osgEarth::MapNode(map);
+}
+
+inline osgEarth::GDALImageLayer* createWorldImageLayer() {
+	auto* imagery = new osgEarth::GDALImageLayer();
+
+	imagery->setURL("../world.tif");
+
+	return imagery;
+}
+
+// The map from example-osgearth-interactive: world.tif through GDAL. Given a `cachePath` (as
+// written by tool-seed-cache), tiles are read from there first and GDAL is only used for misses.
+// With `prefetch`, the imagery is wrapped in a PrefetchImageLayer (find it with
+// `map->getLayer<PrefetchImageLayer>()`) for a TilePrefetcher to fill. With `compressed`, tiles
+// are block compressed and the cache is one of DDS tiles, which then fills itself as tiles are
+// transcoded.
+inline osgEarth::MapNode* createWorldMapNode(const std::string& cachePath="", bool prefetch=false, bool compressed=false) {
+	auto* map = new osgEarth::Map();
+
+	osgEarth::ImageLayer* imagery = createWorldImageLayer();
+
+	if(!cachePath.empty() || compressed) {
+		auto* cached = new CachedImageLayer();
+
+		cached->setSource(imagery);
+		cached->setCompressed(compressed);
+		cached->setCachePath(cachePath);
+		cached->setWriteMisses(compressed);
+
+		imagery = cached;
+	}
+
+	if(prefetch) {
+		auto* prefetched = new PrefetchImageLayer();
+
+		prefetched->setSource(imagery);
+
+		imagery = prefetched;
+	}
+
+	map->addLayer(imagery);
+
+	return new osgEarth::MapNode(map);
+}
+
+// What the osgEarth examples show while MapLoader is still building the real map: a plain,
+// unlit WGS84-sized sphere, so the window has something globe-shaped (at the right scale for the
+// EarthManipulator) from the very first frame.
+inline osg::Node* createPlaceholderGlobe() {
+	auto* sphere = new osg::ShapeDrawable(new osg::Sphere(osg::Vec3(), osg::WGS_84_RADIUS_EQUATOR));
+	auto* geode = new osg::Geode();
+
+	sphere->setColor(osg::Vec4(0.1f, 0.15f, 0.3f, 1.0f));
+
+	geode->addDrawable(sphere);
+	geode->getOrCreateStateSet()->setMode(GL_LIGHTING, osg::StateAttribute::OFF);
+
+	return geode;
+}
+
+// An EarthManipulator for the osgEarth examples, with Space (its "home" key by default) left to
+// FlyToHandler.
+inline osgEarth::Util::EarthManipulator* createEarthManipulator() {
+	auto* manip = new osgEarth::Util::EarthManipulator();
+
+	manip->getSettings()->bindKey(osgEarth::Util::EarthManipulator::ACTION_NULL, osgGA::GUIEventAdapter::KEY_Space);
+
+	return manip;
+}
+
+// Space flies the EarthManipulator down to a point over Maryland (example-osgearth-interactive's
+// fly-to). It's an event handler rather than a Qt key handler so recorded sessions replay it too.
+// `started`, if given, is called with where the flight starts and where it's going, right before
+// it does.
+class FlyToHandler: public osgGA::GUIEventHandler {
+public:
+	using StartedCallback = std::function<void(const osgEarth::Viewpoint& from, const osgEarth::Viewpoint& to)>;
+
+	FlyToHandler(StartedCallback started=nullptr):
+	_started(std::move(started)) {
+	}
+
+	static osgEarth::Viewpoint target() {
+		return osgEarth::Viewpoint(
+			"Target",
+			-76.0,
+			39.0,
+			0.0, // Altitude
+			0.0, // Heading (azimuth, degrees, 0 = north)
+			-90.0, // Pitch (tilt, degrees, -90 = straight down)
+			5000 // Range from target in meters (eye-to-ground distance)
+		);
+	}
+
+	bool handle(const osgGA::GUIEventAdapter& ea, osgGA::GUIActionAdapter& aa) override {
+		if(
+			ea.getEventType() != osgGA::GUIEventAdapter::KEYDOWN ||
+			ea.getKey() != osgGA::GUIEventAdapter::KEY_Space
+		) return false;
+
+		auto* view = dynamic_cast<osgViewer::View*>(aa.asView());
+		auto* manip = view ? dynamic_cast<osgEarth::Util::EarthManipulator*>(view->getCameraManipulator()) : nullptr;
+
+		if(!manip) return false;
+
+		auto to = target();
+
+		if(_started) _started(manip->getViewpoint(), to);
+
+		manip->setViewpoint(to, 1.0);
+
+		aa.requestRedraw();
+
+		return true;
+	}
+
+private:
+	StartedCallback _started;
+};
+
+}
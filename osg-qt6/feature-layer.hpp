@@ -0,0 +1,530 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <osg/Geometry>
+#include <osg/MatrixTransform>
+#include <osg/Program>
+#include <osg/Texture2D>
+#include <osgUtil/CullVisitor>
+#include <osgViewer/View>
+
+#include <osgEarth/DrapeableNode>
+
+#include "osg-qt6/geodetic.hpp"
+#include "osg-qt6/memory-ledger.hpp"
+
+namespace osg_qt6 {
+
+// Ear-clips a simple polygon (lon/lat degrees, either winding, closed or not) into triangles,
+// appended to `triangles` as indices into `ring`; false if it's degenerate. Self-intersecting
+// rings come out as a fan rather than not at all.
+inline bool triangulate(const std::vector<osg::Vec2d>& ring, std::vector<unsigned int>& triangles) {
+	size_t n = ring.size();
+
+	if(n > 1 && ring.front() == ring.back()) n--;
+
+	if(n < 3) return false;
+
+	auto cross = [&ring](unsigned int a, unsigned int b, unsigned int c) {
+		osg::Vec2d ab = ring[b] - ring[a];
+		osg::Vec2d ac = ring[c] - ring[a];
+
+		return ab.x() * ac.y() - ab.y() * ac.x();
+	};
+
+	double area = 0.0;
+
+	for(size_t i = 0, j = n - 1; i < n; j = i++) area += ring[j].x() * ring[i].y() - ring[i].x() * ring[j].y();
+
+	if(area == 0.0) return false;
+
+	// Counter-clockwise from here on.
+	std::vector<unsigned int> v(n);
+
+	for(size_t i = 0; i < n; i++) v[i] = static_cast<unsigned int>(area > 0.0 ? i : n - 1 - i);
+
+	size_t misses = 0;
+
+	for(size_t i = 0; v.size() > 3;) {
+		size_t m = v.size();
+
+		unsigned int a = v[(i + m - 1) % m];
+		unsigned int b = v[i];
+		unsigned int c = v[(i + 1) % m];
+
+		bool ear = cross(a, b, c) > 0.0;
+
+		for(size_t k = 0; ear && k < m; k++) {
+			unsigned int p = v[k];
+
+			if(p == a || p == b || p == c) continue;
+
+			if(cross(a, b, p) >= 0.0 && cross(b, c, p) >= 0.0 && cross(c, a, p) >= 0.0) ear = false;
+		}
+
+		if(ear) {
+			triangles.insert(triangles.end(), {a, b, c});
+
+			v.erase(v.begin() + static_cast<std::ptrdiff_t>(i));
+
+			misses = 0;
+		}
+
+		else if(++misses > m) {
+			for(size_t k = 1; k + 1 < m; k++) triangles.insert(triangles.end(), {v[0], v[k], v[k + 1]});
+
+			return true;
+		}
+
+		else i++;
+
+		if(i >= v.size()) i = 0;
+	}
+
+	triangles.insert(triangles.end(), {v[0], v[1], v[2]});
+
+	return true;
+}
+
+// Any number of polygons (zones, areas of interest) draped on the terrain through ONE osgEarth
+// DrapeableNode, instead of a LocalGeometryNode (node, style, drape setup and draw) per polygon.
+// Polygons are tessellated on worker threads and merged into one vertex buffer per style per
+// CELL_DEGREES grid cell (by centroid), so cells off-screen still cull. Each vertex carries its
+// feature's id, which the shader looks up in a color texture: setColor() and setVisible() rewrite
+// one texel and never touch the geometry.
+//
+// The update callback that swaps built geometry in is only installed while a build() is
+// outstanding, so the layer doesn't keep checkNeedToDoFrame() true (and the viewer from going idle)
+// the rest of the time; the last worker to finish asks the view for a redraw.
+//
+//   auto* zones = new DrapedFeatureLayer();
+//
+//   auto id = zones->add({{-77.1, 38.8}, {-76.9, 38.8}, {-77.0, 39.0}}, osg::Vec4(1.0f, 0.0f, 0.0f, 0.5f));
+//
+//   zones->build();
+//   mapNode->addChild(zones);
+//
+// NOTE: Edges are straight lines in ECEF, which only matters for polygons hundreds of kilometers
+// across (the drape projects them onto the terrain regardless). No holes.
+class DrapedFeatureLayer: public osgEarth::DrapeableNode {
+public:
+	using id_t = std::uint32_t;
+
+	static constexpr unsigned int FEATURE_ATTRIBUTE = 7;
+
+	// Level 5 of the global-geodetic profile (64x32 cells).
+	static constexpr double CELL_DEGREES = 5.625;
+
+	// Texels per row of the color texture.
+	static constexpr unsigned int COLOR_WIDTH = 1024;
+
+	DrapedFeatureLayer() {
+		_colors = new osg::Image();
+		_colors->allocateImage(COLOR_WIDTH, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE);
+
+		std::memset(_colors->data(), 0, _colors->getTotalSizeInBytes());
+
+		_colorTexture = new osg::Texture2D(_colors.get());
+		_colorTexture->setFilter(osg::Texture::MIN_FILTER, osg::Texture::NEAREST);
+		_colorTexture->setFilter(osg::Texture::MAG_FILTER, osg::Texture::NEAREST);
+		_colorTexture->setWrap(osg::Texture::WRAP_S, osg::Texture::CLAMP_TO_EDGE);
+		_colorTexture->setWrap(osg::Texture::WRAP_T, osg::Texture::CLAMP_TO_EDGE);
+		_colorTexture->setResizeNonPowerOfTwoHint(false);
+
+		_colorSize = new osg::Uniform("osg_qt6_feature_colors_size", osg::Vec2(COLOR_WIDTH, 1.0f));
+
+		_createStateSet();
+
+		_swapCallback = new SwapCallback();
+
+		_account = memoryLedger().open("DrapedFeatureLayer");
+		_account->setMeasure([this]() {
+			return MemoryVisitor::measure(*this);
+		});
+	}
+
+	~DrapedFeatureLayer() {
+		wait();
+	}
+
+	// The group every `name` bucket goes under; its StateSet is the style's (blending is already on
+	// for the whole layer).
+	osg::Group* style(const std::string& name) {
+		auto& group = _styles[name];
+
+		if(!group.valid()) {
+			group = new osg::Group();
+
+			addChild(group.get());
+		}
+
+		return group.get();
+	}
+
+	// Queues a polygon for the next build(); its color (and visibility) can change at any time.
+	id_t add(std::vector<osg::Vec2d> ring, const osg::Vec4& color, const std::string& style="") {
+		id_t id = static_cast<id_t>(_features.size());
+
+		osg::Vec2d centroid;
+
+		for(const auto& p : ring) centroid += p;
+
+		if(!ring.empty()) centroid /= static_cast<double>(ring.size());
+
+		auto& bucket = _buckets[{style, _cell(centroid)}];
+
+		bucket.ids.push_back(id);
+		bucket.dirty = true;
+
+		_features.push_back({std::move(ring), color, true});
+
+		_writeColor(id);
+
+		return id;
+	}
+
+	bool setColor(id_t id, const osg::Vec4& color) {
+		if(id >= _features.size()) return false;
+
+		_features[id].color = color;
+
+		_writeColor(id);
+
+		return true;
+	}
+
+	bool setVisible(id_t id, bool visible) {
+		if(id >= _features.size()) return false;
+
+		_features[id].visible = visible;
+
+		_writeColor(id);
+
+		return true;
+	}
+
+	size_t size() const {
+		return _features.size();
+	}
+
+	size_t buckets() const {
+		return _buckets.size();
+	}
+
+	// Tessellates every bucket that has gained features since the last build() on `threads` worker
+	// threads (0 for one per core). The results replace the buckets' old geometry on the next update
+	// traversal; until then, what was there keeps drawing.
+	void build(unsigned int threads=0) {
+		wait();
+
+		// NOTE: Anything the last build() made that never got swapped in is just made again.
+		for(const auto& job : _jobs) _buckets[job.key].dirty = true;
+
+		_jobs.clear();
+
+		setUpdateCallback(nullptr);
+
+		for(auto& [key, bucket] : _buckets) {
+			if(!bucket.dirty) continue;
+
+			Job job{key, {}, nullptr};
+
+			for(auto id : bucket.ids) job.features.emplace_back(id, _features[id].ring);
+
+			_jobs.push_back(std::move(job));
+
+			bucket.dirty = false;
+		}
+
+		if(_jobs.empty()) return;
+
+		if(!threads) threads = std::max(1u, std::thread::hardware_concurrency());
+
+		threads = std::min(threads, static_cast<unsigned int>(_jobs.size()));
+
+		_next = 0;
+		_running = threads;
+
+		for(unsigned int i = 0; i < threads; i++) _workers.emplace_back([this]() {
+			for(size_t j; (j = _next++) < _jobs.size();) _jobs[j].node = _tessellate(_jobs[j].features);
+
+			if(--_running) return;
+
+			std::lock_guard lock(_viewMutex);
+
+			if(osg::ref_ptr<osgViewer::View> view; _view.lock(view)) view->requestRedraw();
+		});
+
+		setUpdateCallback(_swapCallback.get());
+	}
+
+	// Blocks until build()'s workers are done (their geometry still goes in on the next update).
+	void wait() {
+		for(auto& worker : _workers) worker.join();
+
+		_workers.clear();
+	}
+
+	// Whether there's built geometry not yet in the scene graph (or still being built).
+	bool building() const {
+		return !_jobs.empty();
+	}
+
+	void traverse(osg::NodeVisitor& nv) override {
+		if(nv.getVisitorType() == osg::NodeVisitor::CULL_VISITOR) _setView(static_cast<osgUtil::CullVisitor&>(nv));
+
+		osgEarth::DrapeableNode::traverse(nv);
+	}
+
+protected:
+	using Key = std::pair<std::string, int>;
+
+	struct Feature {
+		std::vector<osg::Vec2d> ring;
+
+		osg::Vec4 color;
+
+		bool visible;
+	};
+
+	struct Bucket {
+		std::vector<id_t> ids;
+
+		osg::ref_ptr<osg::Node> node;
+
+		bool dirty = false;
+	};
+
+	struct Job {
+		Key key;
+
+		// NOTE: Copies, so add() is free to grow `_features` while the workers run.
+		std::vector<std::pair<id_t, std::vector<osg::Vec2d>>> features;
+
+		osg::ref_ptr<osg::Node> node;
+	};
+
+	struct SwapCallback: public osg::NodeCallback {
+		void operator()(osg::Node* node, osg::NodeVisitor* nv) override {
+			static_cast<DrapedFeatureLayer*>(node)->_swapBuilt();
+
+			traverse(node, nv);
+		}
+	};
+
+	// The view to ask for a redraw once a build() is done; the first one that culls us.
+	void _setView(osgUtil::CullVisitor& cv) {
+		auto* camera = cv.getCurrentCamera();
+		auto* view = camera ? dynamic_cast<osgViewer::View*>(camera->getView()) : nullptr;
+
+		if(!view) return;
+
+		std::lock_guard lock(_viewMutex);
+
+		if(!_view.valid()) _view = view;
+	}
+
+	static int _cell(const osg::Vec2d& lonLat) {
+		int columns = static_cast<int>(std::lround(360.0 / CELL_DEGREES));
+		int rows = columns / 2;
+
+		int x = std::clamp(static_cast<int>(std::floor((lonLat.x() + 180.0) / CELL_DEGREES)), 0, columns - 1);
+		int y = std::clamp(static_cast<int>(std::floor((lonLat.y() + 90.0) / CELL_DEGREES)), 0, rows - 1);
+
+		return y * columns + x;
+	}
+
+	// Worker threads only: one merged, relative-to-center geometry for a bucket.
+	static osg::Node* _tessellate(const std::vector<std::pair<id_t, std::vector<osg::Vec2d>>>& features) {
+		std::vector<double> lon;
+		std::vector<double> lat;
+		std::vector<unsigned int> triangles;
+
+		auto* ids = new osg::FloatArray();
+		auto* elements = new osg::DrawElementsUInt(GL_TRIANGLES);
+
+		for(const auto& [id, ring] : features) {
+			triangles.clear();
+
+			if(!triangulate(ring, triangles)) continue;
+
+			auto base = static_cast<unsigned int>(lon.size());
+
+			for(const auto& p : ring) {
+				lon.push_back(p.x());
+				lat.push_back(p.y());
+
+				// NOTE: Exact for ids up to 2^24.
+				ids->push_back(static_cast<float>(id));
+			}
+
+			for(auto t : triangles) elements->push_back(base + t);
+		}
+
+		if(lon.empty()) return nullptr;
+
+		std::vector<double> x(lon.size());
+		std::vector<double> y(lon.size());
+		std::vector<double> z(lon.size());
+
+		// The drape flattens everything onto the terrain anyway, so altitude doesn't matter.
+		std::vector<double> alt(lon.size(), 0.0);
+
+		geodeticToEcef(lon.data(), lat.data(), alt.data(), x.data(), y.data(), z.data(), lon.size());
+
+		osg::Vec3d origin(x[0], y[0], z[0]);
+
+		auto* vertices = new osg::Vec3Array();
+
+		vertices->reserve(x.size());
+
+		for(size_t i = 0; i < x.size(); i++) vertices->push_back(osg::Vec3(osg::Vec3d(x[i], y[i], z[i]) - origin));
+
+		auto* geometry = new osg::Geometry();
+
+		geometry->setUseDisplayList(false);
+		geometry->setUseVertexBufferObjects(true);
+		geometry->setVertexArray(vertices);
+		geometry->setVertexAttribArray(FEATURE_ATTRIBUTE, ids, osg::Array::BIND_PER_VERTEX);
+		geometry->addPrimitiveSet(elements);
+
+		auto* transform = new osg::MatrixTransform(osg::Matrix::translate(origin));
+
+		transform->addChild(geometry);
+
+		return transform;
+	}
+
+	// Update traversal: swaps finished buckets in once every worker is done.
+	void _swapBuilt() {
+		if(_jobs.empty() || _running) return;
+
+		wait();
+
+		for(auto& job : _jobs) {
+			auto& bucket = _buckets[job.key];
+			auto* group = style(job.key.first);
+
+			if(bucket.node.valid()) group->removeChild(bucket.node.get());
+
+			bucket.node = job.node;
+
+			if(bucket.node.valid()) group->addChild(bucket.node.get());
+		}
+
+		_jobs.clear();
+
+		// NOTE: SwapCallback is what's running this; `_swapCallback` keeps it alive.
+		setUpdateCallback(nullptr);
+	}
+
+	void _writeColor(id_t id) {
+		unsigned int rows = id / COLOR_WIDTH + 1;
+
+		if(rows > static_cast<unsigned int>(_colors->t())) _growColors(rows);
+
+		const auto& f = _features[id];
+		auto* texel = _colors->data(id % COLOR_WIDTH, id / COLOR_WIDTH);
+
+		for(int i = 0; i < 4; i++) {
+			float c = i == 3 && !f.visible ? 0.0f : f.color[i];
+
+			texel[i] = static_cast<unsigned char>(std::clamp(c, 0.0f, 1.0f) * 255.0f + 0.5f);
+		}
+
+		_colors->dirty();
+	}
+
+	// Doubles the rows (at least), keeping what's there.
+	void _growColors(unsigned int rows) {
+		rows = std::max(rows, 2u * static_cast<unsigned int>(_colors->t()));
+
+		osg::ref_ptr<osg::Image> colors = new osg::Image();
+
+		colors->allocateImage(COLOR_WIDTH, static_cast<int>(rows), 1, GL_RGBA, GL_UNSIGNED_BYTE);
+
+		std::memset(colors->data(), 0, colors->getTotalSizeInBytes());
+		std::memcpy(colors->data(), _colors->data(), _colors->getTotalSizeInBytes());
+
+		_colors = colors;
+		_colorTexture->setImage(_colors.get());
+		_colorSize->set(osg::Vec2(COLOR_WIDTH, static_cast<float>(rows)));
+	}
+
+	void _createStateSet() {
+		static const char* vertexSource =
+			"#version 120\n"
+			"attribute float osg_qt6_feature;\n"
+			"uniform sampler2D osg_qt6_feature_colors;\n"
+			"uniform vec2 osg_qt6_feature_colors_size;\n"
+			"varying vec4 vColor;\n"
+			"void main() {\n"
+			"	float row = floor(osg_qt6_feature / osg_qt6_feature_colors_size.x);\n"
+			"	vec2 uv = (vec2(osg_qt6_feature - row * osg_qt6_feature_colors_size.x, row) + 0.5) / osg_qt6_feature_colors_size;\n"
+			"	vColor = texture2DLod(osg_qt6_feature_colors, uv, 0.0);\n"
+			"	gl_Position = gl_ModelViewProjectionMatrix * gl_Vertex;\n"
+			"}\n"
+		;
+
+		static const char* fragmentSource =
+			"#version 120\n"
+			"varying vec4 vColor;\n"
+			"void main() {\n"
+			"	if(vColor.a <= 0.0) discard;\n"
+			"	gl_FragColor = vColor;\n"
+			"}\n"
+		;
+
+		osg::Program* program = new osg::Program();
+
+		program->addShader(new osg::Shader(osg::Shader::VERTEX, vertexSource));
+		program->addShader(new osg::Shader(osg::Shader::FRAGMENT, fragmentSource));
+		program->addBindAttribLocation("osg_qt6_feature", FEATURE_ATTRIBUTE);
+
+		osg::StateSet* ss = getOrCreateStateSet();
+
+		ss->setAttributeAndModes(program, osg::StateAttribute::ON);
+		ss->setTextureAttributeAndModes(0, _colorTexture.get(), osg::StateAttribute::ON);
+		ss->addUniform(new osg::Uniform("osg_qt6_feature_colors", 0));
+		ss->addUniform(_colorSize.get());
+		ss->setMode(GL_BLEND, osg::StateAttribute::ON);
+		ss->setMode(GL_LIGHTING, osg::StateAttribute::OFF | osg::StateAttribute::PROTECTED);
+		ss->setMode(GL_CULL_FACE, osg::StateAttribute::OFF);
+	}
+
+	std::vector<Feature> _features;
+	std::map<Key, Bucket> _buckets;
+	std::map<std::string, osg::ref_ptr<osg::Group>> _styles;
+
+	osg::ref_ptr<osg::Image> _colors;
+	osg::ref_ptr<osg::Texture2D> _colorTexture;
+	osg::ref_ptr<osg::Uniform> _colorSize;
+
+	// Shared with the workers: they only read `_jobs[j].features` and write `_jobs[j].node`.
+	std::vector<Job> _jobs;
+	std::vector<std::thread> _workers;
+
+	std::atomic<size_t> _next = 0;
+	std::atomic<unsigned int> _running = 0;
+
+	osg::ref_ptr<SwapCallback> _swapCallback;
+
+	std::mutex _viewMutex;
+	osg::observer_ptr<osgViewer::View> _view;
+
+	std::shared_ptr<MemoryAccount> _account;
+};
+
+}
@@ -0,0 +1,475 @@
+#pragma once
+
+#include <array>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <QImage>
+#include <QOpenGLContext>
+#include <QOpenGLExtraFunctions>
+
+namespace osg_qt6 {
+
+// Captures rendered frames without stalling: each frame is read into one of a ring of pixel buffer
+// objects, mapped only once its fence has signaled (a frame or two later), and handed to a worker
+// thread that encodes it as a numbered PNG or appends it to one raw RGBA video stream
+// (`ffmpeg -f rawvideo -pix_fmt rgba -s WxH -i capture.rgba ...`). Capture can be started and
+// stopped at any time; while stopped it costs nothing beyond draining what's still in flight.
+//
+// Per frame, with the widget's context current and after everything has been drawn into it:
+//
+//   _capture.capture(defaultFramebufferObject(), format().samples(), w, h);
+//   _capture.poll();
+//
+// NOTE: If every PBO is still in flight (the GPU is that far behind) or the encoder has fallen
+// MAX_QUEUED frames behind, the frame is dropped and counted rather than waited for.
+class FrameCapture {
+public:
+	enum Format {
+		PNG,
+		RAW
+	};
+
+	static constexpr size_t SLOTS = 3;
+	static constexpr size_t MAX_QUEUED = 8;
+
+	FrameCapture() {
+		_worker = std::thread([this]() {
+			_encodeLoop();
+		});
+	}
+
+	~FrameCapture() {
+		release();
+
+		{
+			std::lock_guard lock(_mutex);
+
+			_quit = true;
+		}
+
+		_wake.notify_all();
+		_worker.join();
+
+		_closeRaw();
+	}
+
+	// PNG writes `<output>/<frame>.png`; RAW appends to the file `output`. With `frames`, capture
+	// stops by itself after that many (e.g. 1, for a thumbnail).
+	bool start(const std::string& output, Format format=PNG, unsigned long long frames=0) {
+		std::lock_guard lock(_mutex);
+
+		std::error_code ec;
+
+		if(format == PNG) std::filesystem::create_directories(output, ec);
+
+		if(ec) return false;
+
+		_output = output;
+		_format = format;
+		_remaining = frames;
+		_capturing = true;
+		_stopped = false;
+		_reopenRaw = format == RAW;
+		_session++;
+
+		return true;
+	}
+
+	void stop() {
+		std::lock_guard lock(_mutex);
+
+		_capturing = false;
+		_stopped = true;
+	}
+
+	bool capturing() const {
+		std::lock_guard lock(_mutex);
+
+		return _capturing;
+	}
+
+	// Whether there's still anything in flight on the GPU side (i.e., poll() has more to do).
+	bool pending() const {
+		for(const auto& slot : _slots) if(slot.fence) return true;
+
+		return false;
+	}
+
+	unsigned long long framesCaptured() const {
+		return _framesCaptured;
+	}
+
+	unsigned long long framesDropped() const {
+		return _framesDropped;
+	}
+
+	unsigned long long framesEncoded() const {
+		std::lock_guard lock(_mutex);
+
+		return _framesEncoded;
+	}
+
+	// Starts the readback of `fbo` (width x height pixels); a no-op unless capturing.
+	void capture(GLuint fbo, int samples, int width, int height) {
+		if(!capturing() || !_init()) return;
+
+		Slot* slot = nullptr;
+
+		for(auto& s : _slots) if(!s.fence) slot = &s;
+
+		if(!slot) {
+			_framesDropped++;
+
+			return;
+		}
+
+		{
+			std::lock_guard lock(_mutex);
+
+			if(!_capturing) return;
+
+			// NOTE: Only counted against start()'s `frames` once it has a slot, and it carries its
+			// session's settings, so frames still queued when another session starts go where and
+			// how they were meant to.
+			slot->counted = _remaining != 0;
+
+			if(_remaining && !--_remaining) _capturing = false;
+
+			slot->session = _session;
+			slot->output = _output;
+			slot->format = _format;
+			slot->reopen = _reopenRaw;
+
+			_reopenRaw = false;
+		}
+
+		size_t bytes = static_cast<size_t>(width) * height * 4;
+
+		// NOTE: Color can't be read straight out of a multisampled framebuffer either; resolve the
+		// whole frame into our own single-sample FBO first. (Sized before `fbo` is bound for
+		// reading, since (re)creating it rebinds GL_FRAMEBUFFER.)
+		if(samples > 0) _resizeResolve(width, height);
+
+		_gl->glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
+
+		if(samples > 0) {
+			_gl->glBindFramebuffer(GL_DRAW_FRAMEBUFFER, _resolveFbo);
+			_gl->glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+			_gl->glBindFramebuffer(GL_READ_FRAMEBUFFER, _resolveFbo);
+		}
+
+		_gl->glBindBuffer(GL_PIXEL_PACK_BUFFER, slot->pbo);
+
+		if(slot->bytes != bytes) {
+			_gl->glBufferData(GL_PIXEL_PACK_BUFFER, static_cast<GLsizeiptr>(bytes), nullptr, GL_STREAM_READ);
+
+			slot->bytes = bytes;
+		}
+
+		_gl->glPixelStorei(GL_PACK_ALIGNMENT, 4);
+		_gl->glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+		_gl->glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+		_gl->glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+
+		slot->fence = _gl->glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		slot->width = width;
+		slot->height = height;
+		slot->sequence = _sequence++;
+
+		_framesCaptured++;
+	}
+
+	// Hands every completed readback to the encoder, oldest first; never blocks on the GPU.
+	void poll() {
+		if(!_gl) return;
+
+		while(auto* slot = _oldestSlot()) {
+			GLenum status = _gl->glClientWaitSync(slot->fence, 0, 0);
+
+			if(status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) break;
+
+			_gl->glDeleteSync(slot->fence);
+
+			slot->fence = nullptr;
+
+			Frame frame;
+
+			{
+				std::lock_guard lock(_mutex);
+
+				if(_queue.size() >= MAX_QUEUED) {
+					_framesDropped++;
+
+					// NOTE: A dropped frame doesn't count against its session (if that's still the
+					// current one), and a RAW session's first frame still has to truncate the file.
+					if(slot->session == _session) {
+						if(slot->counted && !_stopped) {
+							_remaining++;
+							_capturing = true;
+						}
+
+						_reopenRaw = _reopenRaw || slot->reopen;
+					}
+
+					continue;
+				}
+
+				// PNG numbering starts over with each session.
+				if(slot->session != _indexSession) {
+					_indexSession = slot->session;
+					_nextIndex = 0;
+				}
+
+				frame.index = _nextIndex++;
+
+				// NOTE: Buffers go back and forth between here and the encoder instead of being
+				// reallocated every frame.
+				if(!_free.empty()) {
+					frame.pixels = std::move(_free.back());
+
+					_free.pop_back();
+				}
+			}
+
+			frame.width = slot->width;
+			frame.height = slot->height;
+			frame.output = std::move(slot->output);
+			frame.format = slot->format;
+			frame.reopen = slot->reopen;
+			frame.pixels.resize(slot->bytes);
+
+			_gl->glBindBuffer(GL_PIXEL_PACK_BUFFER, slot->pbo);
+
+			if(void* p = _gl->glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, static_cast<GLsizeiptr>(slot->bytes), GL_MAP_READ_BIT)) {
+				std::memcpy(frame.pixels.data(), p, slot->bytes);
+
+				_gl->glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+			}
+
+			_gl->glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+			{
+				std::lock_guard lock(_mutex);
+
+				_queue.push_back(std::move(frame));
+			}
+
+			_wake.notify_one();
+		}
+	}
+
+	// Context must be current.
+	void release() {
+		if(!_gl || QOpenGLContext::currentContext() != _context) return;
+
+		for(auto& slot : _slots) {
+			if(slot.fence) _gl->glDeleteSync(slot.fence);
+
+			_gl->glDeleteBuffers(1, &slot.pbo);
+
+			slot = {};
+		}
+
+		_gl->glDeleteFramebuffers(1, &_resolveFbo);
+		_gl->glDeleteRenderbuffers(1, &_resolveColor);
+
+		_resolveFbo = 0;
+		_resolveColor = 0;
+		_resolveWidth = 0;
+		_resolveHeight = 0;
+
+		_gl = nullptr;
+	}
+
+private:
+	struct Slot {
+		GLuint pbo = 0;
+		GLsync fence = nullptr;
+
+		size_t bytes = 0;
+
+		int width = 0;
+		int height = 0;
+
+		unsigned long long sequence = 0;
+
+		// The start() it was captured under, and that session's settings.
+		unsigned long long session = 0;
+
+		std::string output;
+
+		Format format = PNG;
+
+		bool reopen = false;
+		bool counted = false;
+	};
+
+	struct Frame {
+		unsigned long long index = 0;
+
+		int width = 0;
+		int height = 0;
+
+		std::string output;
+
+		Format format = PNG;
+
+		// The first frame of a RAW session; (re)creates the file.
+		bool reopen = false;
+
+		std::vector<std::uint8_t> pixels;
+	};
+
+	bool _init() {
+		if(_gl) return true;
+
+		auto* ctx = QOpenGLContext::currentContext();
+
+		if(!ctx || ctx->format().version() < qMakePair(3, 0)) return false;
+
+		_context = ctx;
+		_gl = _context->extraFunctions();
+
+		for(auto& slot : _slots) _gl->glGenBuffers(1, &slot.pbo);
+
+		return true;
+	}
+
+	void _resizeResolve(int width, int height) {
+		if(_resolveFbo && _resolveWidth == width && _resolveHeight == height) return;
+
+		if(!_resolveFbo) {
+			_gl->glGenRenderbuffers(1, &_resolveColor);
+			_gl->glGenFramebuffers(1, &_resolveFbo);
+		}
+
+		_gl->glBindRenderbuffer(GL_RENDERBUFFER, _resolveColor);
+		_gl->glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+		_gl->glBindFramebuffer(GL_FRAMEBUFFER, _resolveFbo);
+		_gl->glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, _resolveColor);
+
+		_resolveWidth = width;
+		_resolveHeight = height;
+	}
+
+	Slot* _oldestSlot() {
+		Slot* oldest = nullptr;
+
+		for(auto& slot : _slots) if(slot.fence && (!oldest || slot.sequence < oldest->sequence)) oldest = &slot;
+
+		return oldest;
+	}
+
+	void _encodeLoop() {
+		std::unique_lock lock(_mutex);
+
+		while(true) {
+			_wake.wait(lock, [this]() {
+				return _quit || !_queue.empty();
+			});
+
+			if(_queue.empty()) return;
+
+			auto frame = std::move(_queue.front());
+
+			_queue.pop_front();
+
+			lock.unlock();
+
+			_encode(frame);
+
+			lock.lock();
+
+			_framesEncoded++;
+			_free.push_back(std::move(frame.pixels));
+		}
+	}
+
+	// Worker thread only.
+	void _encode(const Frame& frame) {
+		size_t stride = static_cast<size_t>(frame.width) * 4;
+
+		if(frame.format == PNG) {
+			char name[32];
+
+			std::snprintf(name, sizeof(name), "%06llu.png", frame.index);
+
+			// NOTE: GL rows are bottom-up.
+			QImage(frame.pixels.data(), frame.width, frame.height, static_cast<qsizetype>(stride), QImage::Format_RGBA8888)
+				.mirrored()
+				.save(QString::fromStdString((std::filesystem::path(frame.output) / name).string()))
+			;
+
+			return;
+		}
+
+		if(frame.reopen || !_raw) {
+			_closeRaw();
+
+			_raw = std::fopen(frame.output.c_str(), "wb");
+		}
+
+		if(!_raw) return;
+
+		for(int y = frame.height - 1; y >= 0; y--) std::fwrite(frame.pixels.data() + y * stride, 1, stride, _raw);
+	}
+
+	void _closeRaw() {
+		if(_raw) std::fclose(_raw);
+
+		_raw = nullptr;
+	}
+
+	QOpenGLContext* _context = nullptr;
+	QOpenGLExtraFunctions* _gl = nullptr;
+
+	std::array<Slot, SLOTS> _slots;
+
+	GLuint _resolveFbo = 0;
+	GLuint _resolveColor = 0;
+
+	int _resolveWidth = 0;
+	int _resolveHeight = 0;
+
+	unsigned long long _sequence = 0;
+	unsigned long long _framesCaptured = 0;
+	unsigned long long _framesDropped = 0;
+
+	// Everything below is shared with the encoder thread (under `_mutex`), except `_raw`, which
+	// only it touches.
+	mutable std::mutex _mutex;
+
+	std::condition_variable _wake;
+	std::thread _worker;
+
+	std::deque<Frame> _queue;
+	std::vector<std::vector<std::uint8_t>> _free;
+
+	std::string _output;
+
+	Format _format = PNG;
+
+	unsigned long long _session = 0;
+	unsigned long long _indexSession = 0;
+	unsigned long long _remaining = 0;
+	unsigned long long _nextIndex = 0;
+	unsigned long long _framesEncoded = 0;
+
+	bool _capturing = false;
+	bool _stopped = false;
+	bool _reopenRaw = false;
+	bool _quit = false;
+
+	std::FILE* _raw = nullptr;
+};
+
+}
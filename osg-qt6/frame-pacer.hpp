@@ -0,0 +1,91 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+namespace osg_qt6 {
+
+// Learns the display's real presentation interval from swap timestamps (QOpenGLWidget::frameSwapped,
+// or a simulated clock) and predicts when the frame about to be rendered will actually reach the
+// screen. Feeding that prediction to osgViewer as the frame time, instead of "whenever paintGL
+// happened to run", means animation advances in whole refresh intervals: steady steps while frames
+// make every vsync, and exactly N intervals when N-1 were missed.
+//
+// Times are in seconds, on any clock, as long as it's the same one throughout.
+class FramePacer {
+public:
+	static constexpr size_t WINDOW = 32;
+
+	FramePacer(double defaultPeriod=1.0 / 60.0):
+	_defaultPeriod(defaultPeriod) {
+	}
+
+	// Records that a frame reached the screen at `t`.
+	void presented(double t) {
+		if(_presentedCount) {
+			_intervals[_next] = t - _lastPresent;
+			_next = (_next + 1) % WINDOW;
+			_intervalCount = std::min(_intervalCount + 1, WINDOW);
+		}
+
+		_lastPresent = t;
+		_presentedCount++;
+	}
+
+	// The refresh interval: the median of recent swap intervals, which ignores the odd missed (double
+	// length) or late one as long as most frames make their vsync.
+	double period() const {
+		if(_intervalCount < 4) return _defaultPeriod;
+
+		std::array<double, WINDOW> sorted = _intervals;
+
+		auto middle = sorted.begin() + _intervalCount / 2;
+
+		std::nth_element(sorted.begin(), middle, sorted.begin() + _intervalCount);
+
+		return *middle > 0.0 ? *middle : _defaultPeriod;
+	}
+
+	// When the frame starting to render at `now` should be presented: the first vsync after `now`,
+	// on the grid established by the last presentation, and never less than one interval after the
+	// previous prediction.
+	double next(double now) {
+		double p = period();
+
+		double t = now;
+
+		if(_presentedCount) {
+			t = _lastPresent + p * std::max(1.0, std::ceil((now - _lastPresent) / p));
+		}
+
+		// NOTE: Without the half-interval slack, a swap timestamp landing a hair early would make
+		// two frames predict the same vsync.
+		if(_predictedCount && t < _lastPredicted + p * 0.5) t = _lastPredicted + p;
+
+		_lastPredicted = t;
+		_predictedCount++;
+
+		return t;
+	}
+
+	unsigned long long presentedCount() const {
+		return _presentedCount;
+	}
+
+private:
+	double _defaultPeriod = 1.0 / 60.0;
+
+	std::array<double, WINDOW> _intervals = {};
+
+	size_t _next = 0;
+	size_t _intervalCount = 0;
+
+	double _lastPresent = 0.0;
+	double _lastPredicted = 0.0;
+
+	unsigned long long _presentedCount = 0;
+	unsigned long long _predictedCount = 0;
+};
+
+}
@@ -0,0 +1,281 @@
+#pragma once
+
+#include <functional>
+
+#include <QOpenGLWidget>
+#include <QTimer>
+#include <QEvent>
+#include <QWindow>
+
+#include <osg/Timer>
+#include <osg/observer_ptr>
+#include <osgDB/DatabasePager>
+#include <osgViewer/Viewer>
+
+#include "frame-pacer.hpp"
+
+namespace osg_qt6 {
+
+// Replaces the "call update() every 16ms, no matter what" QTimer the examples started out with.
+// A tick only schedules a repaint when something actually needs a new frame: Qt input, an explicit
+// requestFrame(), or osgViewer itself (manipulator animations, pending DatabasePager merges, update
+// callbacks, queued events) via `checkNeedToDoFrame()`. Nothing is scheduled while the widget is
+// hidden, minimized or its window isn't exposed.
+//
+// The timer only runs while there's something to poll for: it stops on the first tick that finds
+// nothing to do (unless the DatabasePager still has requests in flight, whose results nothing else
+// would notice), and input, requestFrame() or the next paint start it again.
+//
+// With setVsyncPacing(true), frames are driven by QOpenGLWidget::frameSwapped instead (the swap
+// blocks on vsync, so the next frame starts right after the last one was presented) and frameTime()
+// hands osgViewer the FramePacer's predicted presentation time. The timer is stopped for as long as
+// swaps keep the loop going (so no frame starts at some other phase), and only wakes it back up
+// after it went idle.
+class FrameScheduler: public QObject {
+public:
+	// What the viewer wants next: a frame, nothing yet but keep polling (pager requests in flight),
+	// or nothing at all.
+	enum Demand {
+		IDLE,
+		LOADING,
+		FRAME
+	};
+
+	// NOTE: Reads the viewer's event queues, update state and pager; only call it from the thread
+	// that runs the viewer's frames, between them.
+	static Demand demand(osgViewer::Viewer* viewer) {
+		if(viewer->checkNeedToDoFrame()) return FRAME;
+
+		osgDB::DatabasePager* pager = viewer->getDatabasePager();
+
+		return pager && pager->getRequestsInProgress() ? LOADING : IDLE;
+	}
+
+	FrameScheduler(QOpenGLWidget* widget, int interval=1000 / 60):
+	QObject(widget),
+	_widget(widget),
+	_interval(interval) {
+		_timer = new QTimer(this);
+
+		_timer->setTimerType(Qt::PreciseTimer);
+
+		connect(_timer, &QTimer::timeout, this, &FrameScheduler::_tick);
+
+		_widget->installEventFilter(this);
+	}
+
+	void setViewer(osgViewer::Viewer* viewer) {
+		_viewer = viewer;
+
+		requestFrame();
+	}
+
+	// By default a "render" is just `QWidget::update()`; the RenderThread mode replaces this with a
+	// request to its own frame loop.
+	void setRenderFunction(std::function<void()> render) {
+		_render = std::move(render);
+	}
+
+	// By default a tick asks the viewer itself, which is only safe while it renders on the GUI
+	// thread too; the RenderThread mode replaces this with what the render thread published after
+	// its last frame (RenderThread::demand()).
+	void setDemandFunction(std::function<Demand()> demand) {
+		_demand = std::move(demand);
+	}
+
+	// NOTE: Only meaningful when the widget itself renders; a RenderThread swaps on its own.
+	void setVsyncPacing(bool enabled) {
+		if(enabled == static_cast<bool>(_swapped)) return;
+
+		if(enabled) _swapped = connect(_widget, &QOpenGLWidget::frameSwapped, this, &FrameScheduler::_presented);
+
+		else {
+			disconnect(_swapped);
+
+			_swapped = {};
+			_swapDriven = false;
+
+			requestFrame();
+		}
+	}
+
+	bool vsyncPacing() const {
+		return static_cast<bool>(_swapped);
+	}
+
+	const FramePacer& pacer() const {
+		return _pacer;
+	}
+
+	// The time to pass to `frame()` (or trace::frame()) for the frame paintGL() is about to render:
+	// the predicted presentation time, in the viewer's reference-time base, when pacing; otherwise
+	// USE_REFERENCE_TIME (i.e. "now").
+	double frameTime() {
+		osg::ref_ptr<osgViewer::Viewer> viewer;
+
+		if(!vsyncPacing() || !_viewer.lock(viewer)) return USE_REFERENCE_TIME;
+
+		return _pacer.next(_viewerTime(viewer));
+	}
+
+	// For "explicit" scene changes the viewer has no way of knowing about (adding nodes, swapping
+	// scene data, etc.).
+	void requestFrame() {
+		_dirty = true;
+
+		// NOTE: The next frameSwapped picks it up.
+		if(_swapDriven) return;
+
+		if(_widget->isVisible() && !_timer->isActive()) _timer->start(_interval);
+	}
+
+	// NOTE: This should be called at the end of paintGL(), whether the paint was one we scheduled or
+	// one QT decided it needed (expose, resize, etc.).
+	void frameRendered() {
+		_dirty = false;
+		_framesRendered++;
+
+		// One more tick, to see whether the viewer wants the frame after this one too (unless the
+		// swap will ask).
+		if(!_swapDriven && _widget->isVisible() && !_timer->isActive()) _timer->start(_interval);
+	}
+
+	bool isVisible() const {
+		if(!_widget->isVisible() || _widget->visibleRegion().isEmpty()) return false;
+
+		const QWidget* top = _widget->window();
+
+		if(top->isMinimized()) return false;
+
+		const QWindow* handle = top->windowHandle();
+
+		return !handle || handle->isExposed();
+	}
+
+	unsigned long long framesRendered() const {
+		return _framesRendered;
+	}
+
+	// Frames something asked for while nothing could be seen.
+	unsigned long long framesSkipped() const {
+		return _framesSkipped;
+	}
+
+	// Ticks that found nothing to do (the last one before the timer stops, or any while loading).
+	unsigned long long idleTicks() const {
+		return _idleTicks;
+	}
+
+protected:
+	bool eventFilter(QObject* obj, QEvent* event) override {
+		if(obj != _widget) return QObject::eventFilter(obj, event);
+
+		switch(event->type()) {
+			case QEvent::MouseButtonPress:
+			case QEvent::MouseButtonRelease:
+			case QEvent::MouseButtonDblClick:
+			case QEvent::MouseMove:
+			case QEvent::Wheel:
+			case QEvent::KeyPress:
+			case QEvent::KeyRelease:
+			case QEvent::Resize:
+			case QEvent::Show:
+				requestFrame();
+
+				break;
+
+			case QEvent::Hide:
+				_timer->stop();
+
+				_swapDriven = false;
+
+				break;
+
+			default:
+				break;
+		}
+
+		return QObject::eventFilter(obj, event);
+	}
+
+	void _tick() {
+		osg::ref_ptr<osgViewer::Viewer> viewer;
+
+		// NOTE: Until initializeGL() has handed us a viewer there's nothing to ask; QT will paint
+		// the first frame on its own once the widget is exposed, and frameRendered() restarts us.
+		if(!_viewer.lock(viewer)) {
+			_timer->stop();
+
+			return;
+		}
+
+		Demand demand = _dirty ? FRAME : _demand ? _demand() : FrameScheduler::demand(viewer.get());
+		bool needed = demand == FRAME;
+
+		if(needed && isVisible()) {
+			if(_render) _render();
+
+			else _widget->update();
+
+			if(vsyncPacing()) {
+				_swapDriven = true;
+
+				_timer->stop();
+			}
+
+			return;
+		}
+
+		_swapDriven = false;
+
+		if(needed) _framesSkipped++;
+
+		else _idleTicks++;
+
+		// NOTE: After a swap-driven frame the timer isn't running; loading needs it back.
+		if(demand != LOADING) _timer->stop();
+
+		else if(!_timer->isActive()) _timer->start(_interval);
+	}
+
+	void _presented() {
+		osg::ref_ptr<osgViewer::Viewer> viewer;
+
+		if(!_viewer.lock(viewer)) return;
+
+		_pacer.presented(_viewerTime(viewer));
+
+		// Chain straight into the next frame (if one's needed) rather than waiting for the timer,
+		// which would land at some arbitrary phase relative to vsync.
+		_tick();
+	}
+
+	static double _viewerTime(const osgViewer::Viewer* viewer) {
+		const osg::Timer* timer = osg::Timer::instance();
+
+		return timer->delta_s(viewer->getStartTick(), timer->tick());
+	}
+
+private:
+	QOpenGLWidget* _widget = nullptr;
+	QTimer* _timer = nullptr;
+
+	osg::observer_ptr<osgViewer::Viewer> _viewer;
+
+	std::function<void()> _render;
+	std::function<Demand()> _demand;
+
+	FramePacer _pacer;
+
+	QMetaObject::Connection _swapped;
+
+	int _interval = 1000 / 60;
+	bool _dirty = true;
+	bool _swapDriven = false;
+
+	unsigned long long _framesRendered = 0;
+	unsigned long long _framesSkipped = 0;
+	unsigned long long _idleTicks = 0;
+};
+
+}
@@ -0,0 +1,398 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <initializer_list>
+
+#if defined(__AVX2__) && defined(__FMA__)
+#include <immintrin.h>
+
+#define OSG_QT6_GEODETIC_AVX2
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+
+#define OSG_QT6_GEODETIC_NEON
+#endif
+
+// Batched WGS84 conversions between ECEF (geocentric meters, what GeoPoint::toWorld() gives on a
+// geocentric map) and lon/lat/alt (degrees, degrees, meters above the ellipsoid), on
+// structure-of-arrays buffers:
+//
+//   osg_qt6::ecefToGeodetic(x, y, z, lon, lat, alt, count);
+//   osg_qt6::geodeticToEcef(lon, lat, alt, x, y, z, count);
+//
+// Outputs may alias inputs element for element (e.g. converting in place). The kernels are 4-wide
+// AVX2+FMA when compiled for it (-mavx2 -mfma, or -DOSG_QT6_NATIVE=ON), 2-wide NEON on AArch64, and
+// scalar otherwise; every one of them is branch-free, with its own sin/cos/atan polynomials (libm
+// doesn't vectorize), and ECEF-to-geodetic uses a fixed number of Bowring iterations.
+//
+// NOTE: Against osgEarth's SpatialReference::transform(), for altitudes from -11km to 1000km:
+// lon/lat within GEODETIC_TOLERANCE_DEGREES, alt and ECEF within GEODETIC_TOLERANCE_METERS (which
+// bench-geodetic checks). The remaining difference is mostly osgEarth's own single Bowring step.
+namespace osg_qt6 {
+
+constexpr double GEODETIC_TOLERANCE_DEGREES = 1.0e-8;
+constexpr double GEODETIC_TOLERANCE_METERS = 1.0e-3;
+
+namespace geodetic {
+
+constexpr double A = 6378137.0;
+constexpr double F = 1.0 / 298.257223563;
+constexpr double B = A * (1.0 - F);
+constexpr double E2 = F * (2.0 - F);
+constexpr double EP2 = E2 / (1.0 - E2);
+
+constexpr double PI = 3.14159265358979323846;
+constexpr double DEGREES = 180.0 / PI;
+constexpr double RADIANS = PI / 180.0;
+
+// Refinements after Bowring's first step; one already converges to double precision from below
+// the geoid out past geostationary altitude.
+constexpr int ITERATIONS = 1;
+
+// One lane per element: the fallback, and the tail of every SIMD loop.
+struct ScalarLanes {
+	using V = double;
+	using M = bool;
+
+	static constexpr size_t WIDTH = 1;
+
+	static V load(const double* p) { return *p; }
+	static void store(double* p, V v) { *p = v; }
+	static V set(double d) { return d; }
+
+	static V add(V a, V b) { return a + b; }
+	static V sub(V a, V b) { return a - b; }
+	static V mul(V a, V b) { return a * b; }
+	static V div(V a, V b) { return a / b; }
+	static V fma(V a, V b, V c) { return a * b + c; }
+	static V sqrt(V a) { return std::sqrt(a); }
+	static V abs(V a) { return std::abs(a); }
+	static V max(V a, V b) { return a > b ? a : b; }
+	static V min(V a, V b) { return a < b ? a : b; }
+	static V round(V a) { return std::nearbyint(a); }
+
+	static M lt(V a, V b) { return a < b; }
+	static M gt(V a, V b) { return a > b; }
+	static M both(M a, M b) { return a && b; }
+	static M either(M a, M b) { return a || b; }
+
+	static V select(M m, V a, V b) { return m ? a : b; }
+};
+
+#if defined(OSG_QT6_GEODETIC_AVX2)
+struct SimdLanes {
+	using V = __m256d;
+	using M = __m256d;
+
+	static constexpr size_t WIDTH = 4;
+
+	static V load(const double* p) { return _mm256_loadu_pd(p); }
+	static void store(double* p, V v) { _mm256_storeu_pd(p, v); }
+	static V set(double d) { return _mm256_set1_pd(d); }
+
+	static V add(V a, V b) { return _mm256_add_pd(a, b); }
+	static V sub(V a, V b) { return _mm256_sub_pd(a, b); }
+	static V mul(V a, V b) { return _mm256_mul_pd(a, b); }
+	static V div(V a, V b) { return _mm256_div_pd(a, b); }
+	static V fma(V a, V b, V c) { return _mm256_fmadd_pd(a, b, c); }
+	static V sqrt(V a) { return _mm256_sqrt_pd(a); }
+	static V abs(V a) { return _mm256_andnot_pd(_mm256_set1_pd(-0.0), a); }
+	static V max(V a, V b) { return _mm256_max_pd(a, b); }
+	static V min(V a, V b) { return _mm256_min_pd(a, b); }
+	static V round(V a) { return _mm256_round_pd(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+
+	static M lt(V a, V b) { return _mm256_cmp_pd(a, b, _CMP_LT_OQ); }
+	static M gt(V a, V b) { return _mm256_cmp_pd(a, b, _CMP_GT_OQ); }
+	static M both(M a, M b) { return _mm256_and_pd(a, b); }
+	static M either(M a, M b) { return _mm256_or_pd(a, b); }
+
+	static V select(M m, V a, V b) { return _mm256_blendv_pd(b, a, m); }
+};
+#elif defined(OSG_QT6_GEODETIC_NEON)
+struct SimdLanes {
+	using V = float64x2_t;
+	using M = uint64x2_t;
+
+	static constexpr size_t WIDTH = 2;
+
+	static V load(const double* p) { return vld1q_f64(p); }
+	static void store(double* p, V v) { vst1q_f64(p, v); }
+	static V set(double d) { return vdupq_n_f64(d); }
+
+	static V add(V a, V b) { return vaddq_f64(a, b); }
+	static V sub(V a, V b) { return vsubq_f64(a, b); }
+	static V mul(V a, V b) { return vmulq_f64(a, b); }
+	static V div(V a, V b) { return vdivq_f64(a, b); }
+	static V fma(V a, V b, V c) { return vfmaq_f64(c, a, b); }
+	static V sqrt(V a) { return vsqrtq_f64(a); }
+	static V abs(V a) { return vabsq_f64(a); }
+	static V max(V a, V b) { return vmaxq_f64(a, b); }
+	static V min(V a, V b) { return vminq_f64(a, b); }
+	static V round(V a) { return vrndnq_f64(a); }
+
+	static M lt(V a, V b) { return vcltq_f64(a, b); }
+	static M gt(V a, V b) { return vcgtq_f64(a, b); }
+	static M both(M a, M b) { return vandq_u64(a, b); }
+	static M either(M a, M b) { return vorrq_u64(a, b); }
+
+	static V select(M m, V a, V b) { return vbslq_f64(m, a, b); }
+};
+#endif
+
+template<typename L>
+inline typename L::V poly(typename L::V x, std::initializer_list<double> c) {
+	auto i = c.begin();
+	auto r = L::set(*i++);
+
+	for(; i != c.end(); i++) r = L::fma(r, x, L::set(*i));
+
+	return r;
+}
+
+// Sine and cosine of `deg` degrees. Reduced by quarter turns in degrees first (exactly, since 90k
+// is), then Cephes' minimax polynomials on [-pi/4, pi/4].
+template<typename L>
+inline void sincosDegrees(typename L::V deg, typename L::V& s, typename L::V& c) {
+	using V = typename L::V;
+
+	V k = L::round(L::mul(deg, L::set(1.0 / 90.0)));
+	V x = L::mul(L::fma(k, L::set(-90.0), deg), L::set(RADIANS));
+	V z = L::mul(x, x);
+
+	V sx = L::fma(L::mul(x, z), poly<L>(z, {
+		1.58962301576546568060e-10,
+		-2.50507477628578072866e-8,
+		2.75573136213857245213e-6,
+		-1.98412698295895385996e-4,
+		8.33333333332211858878e-3,
+		-1.66666666666666307295e-1
+	}), x);
+
+	V cx = L::fma(L::mul(z, z), poly<L>(z, {
+		-1.13585365213876817300e-11,
+		2.08757008419747316778e-9,
+		-2.75573141792967388112e-7,
+		2.48015872888517045348e-5,
+		-1.38888888888730564116e-3,
+		4.16666666666665929218e-2
+	}), L::fma(z, L::set(-0.5), L::set(1.0)));
+
+	// The quadrant, as -2..2 (where -2 and 2 are the same one).
+	V q = L::fma(L::round(L::mul(k, L::set(0.25))), L::set(-4.0), k);
+	V aq = L::abs(q);
+
+	auto swap = L::both(L::gt(aq, L::set(0.5)), L::lt(aq, L::set(1.5)));
+	auto negS = L::either(L::lt(q, L::set(-0.5)), L::gt(q, L::set(1.5)));
+	auto negC = L::either(L::gt(q, L::set(0.5)), L::lt(q, L::set(-1.5)));
+
+	V zero = L::set(0.0);
+	V bs = L::select(swap, cx, sx);
+	V bc = L::select(swap, sx, cx);
+
+	s = L::select(negS, L::sub(zero, bs), bs);
+	c = L::select(negC, L::sub(zero, bc), bc);
+}
+
+// atan2(y, x) in degrees: Cephes' atan on min/max(|x|, |y|) (always in [0, 1]), then unfolded.
+template<typename L>
+inline typename L::V atan2Degrees(typename L::V y, typename L::V x) {
+	using V = typename L::V;
+
+	constexpr double MOREBITS = 6.123233995736765886130e-17;
+
+	V ax = L::abs(x);
+	V ay = L::abs(y);
+	V hi = L::max(ax, ay);
+	V lo = L::min(ax, ay);
+	V zero = L::set(0.0);
+	V one = L::set(1.0);
+
+	V t = L::div(lo, L::select(L::gt(hi, zero), hi, one));
+
+	auto mid = L::gt(t, L::set(0.66));
+
+	V r = L::select(mid, L::div(L::sub(t, one), L::add(t, one)), t);
+	V z = L::mul(r, r);
+
+	V p = poly<L>(z, {
+		-8.750608600031904122785e-1,
+		-1.615753718733365076637e1,
+		-7.500855792314704667340e1,
+		-1.228866684490136173410e2,
+		-6.485021904942025371773e1
+	});
+
+	V q = poly<L>(z, {
+		1.0,
+		2.485846490142306297962e1,
+		1.650270098316988542046e2,
+		4.328810604912902668951e2,
+		4.853903996359136964868e2,
+		1.945506571482613964425e2
+	});
+
+	V a = L::fma(L::mul(r, z), L::div(p, q), r);
+
+	a = L::add(a, L::select(mid, L::set(PI / 4.0 + 0.5 * MOREBITS), zero));
+	a = L::select(L::gt(ay, ax), L::sub(L::set(PI / 2.0 + MOREBITS), a), a);
+	a = L::select(L::lt(x, zero), L::sub(L::set(PI + 2.0 * MOREBITS), a), a);
+	a = L::select(L::lt(y, zero), L::sub(zero, a), a);
+
+	return L::mul(a, L::set(DEGREES));
+}
+
+template<typename L>
+inline void toGeodetic(
+	const double* px,
+	const double* py,
+	const double* pz,
+	double* plon,
+	double* plat,
+	double* palt,
+	size_t begin,
+	size_t end
+) {
+	using V = typename L::V;
+
+	V tiny = L::set(1.0e-300);
+
+	for(size_t i = begin; i + L::WIDTH <= end; i += L::WIDTH) {
+		V x = L::load(px + i);
+		V y = L::load(py + i);
+		V z = L::load(pz + i);
+
+		V p = L::sqrt(L::fma(x, x, L::mul(y, y)));
+
+		// The parametric latitude and the geodetic one as unnormalized (sin, cos) pairs; no tan, so
+		// the poles (p = 0) need no special case.
+		V sb = L::mul(z, L::set(A));
+		V cb = L::mul(p, L::set(B));
+		V sn, cn;
+
+		for(int n = 0; n <= ITERATIONS; n++) {
+			V r = L::max(L::sqrt(L::fma(sb, sb, L::mul(cb, cb))), tiny);
+
+			sb = L::div(sb, r);
+			cb = L::div(cb, r);
+
+			sn = L::fma(L::mul(L::mul(sb, sb), sb), L::set(EP2 * B), z);
+			cn = L::fma(L::mul(L::mul(cb, cb), cb), L::set(-E2 * A), p);
+
+			sb = L::mul(sn, L::set(B));
+			cb = L::mul(cn, L::set(A));
+		}
+
+		V r = L::max(L::sqrt(L::fma(sn, sn, L::mul(cn, cn))), tiny);
+		V s = L::div(sn, r);
+		V c = L::div(cn, r);
+
+		V h = L::sub(
+			L::fma(p, c, L::mul(z, s)),
+			L::mul(L::set(A), L::sqrt(L::fma(L::mul(s, s), L::set(-E2), L::set(1.0))))
+		);
+
+		L::store(plon + i, atan2Degrees<L>(y, x));
+		L::store(plat + i, atan2Degrees<L>(sn, cn));
+		L::store(palt + i, h);
+	}
+}
+
+template<typename L>
+inline void toEcef(
+	const double* plon,
+	const double* plat,
+	const double* palt,
+	double* px,
+	double* py,
+	double* pz,
+	size_t begin,
+	size_t end
+) {
+	using V = typename L::V;
+
+	for(size_t i = begin; i + L::WIDTH <= end; i += L::WIDTH) {
+		V h = L::load(palt + i);
+		V sl, cl, sp, cp;
+
+		sincosDegrees<L>(L::load(plon + i), sl, cl);
+		sincosDegrees<L>(L::load(plat + i), sp, cp);
+
+		V n = L::div(L::set(A), L::sqrt(L::fma(L::mul(sp, sp), L::set(-E2), L::set(1.0))));
+		V nh = L::mul(L::add(n, h), cp);
+
+		L::store(px + i, L::mul(nh, cl));
+		L::store(py + i, L::mul(nh, sl));
+		L::store(pz + i, L::mul(L::fma(n, L::set(1.0 - E2), h), sp));
+	}
+}
+
+}
+
+// Which kernel `simd=true` gets in this build: "avx2", "neon" or "scalar".
+inline const char* geodeticKernel() {
+#if defined(OSG_QT6_GEODETIC_AVX2)
+	return "avx2";
+#elif defined(OSG_QT6_GEODETIC_NEON)
+	return "neon";
+#else
+	return "scalar";
+#endif
+}
+
+// With `simd=false`, the scalar kernel does every element (for comparison).
+inline void ecefToGeodetic(
+	const double* x,
+	const double* y,
+	const double* z,
+	double* lon,
+	double* lat,
+	double* alt,
+	size_t count,
+	bool simd=true
+) {
+	size_t done = 0;
+
+#if defined(OSG_QT6_GEODETIC_AVX2) || defined(OSG_QT6_GEODETIC_NEON)
+	using L = geodetic::SimdLanes;
+
+	if(simd) {
+		done = count - count % L::WIDTH;
+
+		geodetic::toGeodetic<L>(x, y, z, lon, lat, alt, 0, done);
+	}
+#else
+	(void)simd;
+#endif
+
+	geodetic::toGeodetic<geodetic::ScalarLanes>(x, y, z, lon, lat, alt, done, count);
+}
+
+inline void geodeticToEcef(
+	const double* lon,
+	const double* lat,
+	const double* alt,
+	double* x,
+	double* y,
+	double* z,
+	size_t count,
+	bool simd=true
+) {
+	size_t done = 0;
+
+#if defined(OSG_QT6_GEODETIC_AVX2) || defined(OSG_QT6_GEODETIC_NEON)
+	using L = geodetic::SimdLanes;
+
+	if(simd) {
+		done = count - count % L::WIDTH;
+
+		geodetic::toEcef<L>(lon, lat, alt, x, y, z, 0, done);
+	}
+#else
+	(void)simd;
+#endif
+
+	geodetic::toEcef<geodetic::ScalarLanes>(lon, lat, alt, x, y, z, done, count);
+}
+
+}
@@ -0,0 +1,931 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <QFile>
+
+#include <osg/Texture2D>
+
+#include <osgEarth/ImageLayer>
+
+#include "osg-qt6/memory-ledger.hpp"
+
+namespace osg_qt6 {
+
+// Just enough of TIFF 6.0 and GeoTIFF to read internally tiled, 8-bit, chunky (RGB, RGBA or
+// gray) images, uncompressed or LZW, plus their reduced-resolution IFDs (what `gdaladdo` writes).
+// Everything works on the raw bytes of the file, so a mapping can be parsed in place.
+namespace tiff {
+
+constexpr uint16_t COMPRESSION_NONE = 1;
+constexpr uint16_t COMPRESSION_LZW = 5;
+
+constexpr uint16_t PREDICTOR_HORIZONTAL = 2;
+
+// One image of the file: the full-resolution one or an overview.
+struct Level {
+	uint32_t width = 0;
+	uint32_t height = 0;
+	uint32_t tileWidth = 0;
+	uint32_t tileHeight = 0;
+
+	uint16_t samples = 0;
+	uint16_t compression = COMPRESSION_NONE;
+	uint16_t predictor = 1;
+
+	std::vector<uint64_t> offsets;
+	std::vector<uint64_t> byteCounts;
+
+	uint32_t tilesAcross() const {
+		return (width + tileWidth - 1) / tileWidth;
+	}
+
+	uint32_t tilesDown() const {
+		return (height + tileHeight - 1) / tileHeight;
+	}
+
+	// Every tile is stored full size, even along the right and bottom edges.
+	size_t tileBytes() const {
+		return static_cast<size_t>(tileWidth) * tileHeight * samples;
+	}
+};
+
+struct File {
+	// NOTE: Finest first.
+	std::vector<Level> levels;
+
+	// Model-space coordinates of the image's outer edges (PixelIsArea).
+	double west = 0.0;
+	double south = 0.0;
+	double east = 0.0;
+	double north = 0.0;
+
+	bool georeferenced = false;
+
+	// ProjectedCSTypeGeoKey, or else GeographicTypeGeoKey; 0 if neither is set.
+	int epsg = 0;
+
+	// Why parse() failed; empty if it didn't.
+	std::string error;
+};
+
+// Reads the IFD chain of the `size` bytes at `data`. Transparency masks are skipped, and every
+// level has to be tiled, 8 bits per sample, chunky, and either uncompressed or LZW.
+inline File parse(const unsigned char* data, size_t size) {
+	File file;
+
+	auto fail = [&](const std::string& error) {
+		file.levels.clear();
+		file.error = error;
+
+		return file;
+	};
+
+	if(size < 8 || !((data[0] == 'I' && data[1] == 'I') || (data[0] == 'M' && data[1] == 'M'))) {
+		return fail("not a TIFF");
+	}
+
+	bool little = data[0] == 'I';
+
+	auto read = [&](uint64_t at, int bytes) -> uint64_t {
+		uint64_t v = 0;
+
+		for(int i = 0; i < bytes; i++) {
+			uint64_t b = data[at + i];
+
+			v |= little ? b << (i * 8) : b << ((bytes - 1 - i) * 8);
+		}
+
+		return v;
+	};
+
+	if(read(2, 2) == 43) return fail("BigTIFF isn't supported");
+
+	if(read(2, 2) != 42) return fail("not a TIFF");
+
+	// Bytes per value of each TIFF field type; 0 for the ones nothing here uses.
+	auto typeSize = [](uint64_t type) -> int {
+		switch(type) {
+			case 1: case 2: case 6: case 7: return 1;
+			case 3: case 8: return 2;
+			case 4: case 9: case 11: return 4;
+			case 5: case 10: case 12: case 16: return 8;
+			default: return 0;
+		}
+	};
+
+	struct Entry {
+		uint64_t type = 0;
+		uint64_t count = 0;
+		uint64_t at = 0;
+	};
+
+	std::vector<uint64_t> visited;
+
+	for(uint64_t ifd = read(4, 4); ifd; ) {
+		// NOTE: A malformed file could point back into its own chain.
+		if(ifd + 2 > size || std::find(visited.begin(), visited.end(), ifd) != visited.end()) {
+			return fail("bad IFD offset");
+		}
+
+		visited.push_back(ifd);
+
+		auto count = read(ifd, 2);
+
+		if(ifd + 2 + count * 12 + 4 > size) return fail("truncated IFD");
+
+		std::unordered_map<uint16_t, Entry> entries;
+
+		for(uint64_t i = 0; i < count; i++) {
+			uint64_t e = ifd + 2 + i * 12;
+			Entry entry{read(e + 2, 2), read(e + 4, 4), e + 8};
+			auto bytes = typeSize(entry.type) * entry.count;
+
+			if(bytes > 4) entry.at = read(e + 8, 4);
+
+			if(typeSize(entry.type) && entry.at + bytes <= size) entries[static_cast<uint16_t>(read(e, 2))] = entry;
+		}
+
+		ifd = read(ifd + 2 + count * 12, 4);
+
+		auto value = [&](uint16_t tag, uint64_t i=0, uint64_t fallback=0) -> uint64_t {
+			auto e = entries.find(tag);
+
+			if(e == entries.end() || i >= e->second.count) return fallback;
+
+			return read(e->second.at + i * typeSize(e->second.type), typeSize(e->second.type));
+		};
+
+		auto real = [&](uint16_t tag, uint64_t i) -> double {
+			uint64_t bits = value(tag, i);
+			double d;
+
+			std::memcpy(&d, &bits, sizeof(d));
+
+			return d;
+		};
+
+		auto subfileType = value(254);
+
+		// Transparency masks.
+		if(subfileType & 4) continue;
+
+		Level level;
+
+		level.width = static_cast<uint32_t>(value(256));
+		level.height = static_cast<uint32_t>(value(257));
+		level.tileWidth = static_cast<uint32_t>(value(322));
+		level.tileHeight = static_cast<uint32_t>(value(323));
+		level.samples = static_cast<uint16_t>(value(277, 0, 1));
+		level.compression = static_cast<uint16_t>(value(259, 0, COMPRESSION_NONE));
+		level.predictor = static_cast<uint16_t>(value(317, 0, 1));
+
+		if(!level.width || !level.height) return fail("missing image size");
+
+		if(!level.tileWidth || !level.tileHeight) return fail("not internally tiled (use gdal_translate -co TILED=YES)");
+
+		if(level.samples != 1 && level.samples != 3 && level.samples != 4) return fail("only gray, RGB and RGBA are supported");
+
+		for(uint16_t s = 0; s < level.samples; s++) {
+			if(value(258, s, 1) != 8) return fail("only 8 bits per sample are supported");
+		}
+
+		if(value(284, 0, 1) != 1) return fail("only chunky (pixel-interleaved) images are supported");
+
+		if(value(262, 0, 2) == 3) return fail("palette images aren't supported");
+
+		if(level.compression != COMPRESSION_NONE && level.compression != COMPRESSION_LZW) {
+			return fail("compression " + std::to_string(level.compression) + " isn't supported (only none and LZW)");
+		}
+
+		size_t tiles = static_cast<size_t>(level.tilesAcross()) * level.tilesDown();
+
+		for(size_t t = 0; t < tiles; t++) {
+			level.offsets.push_back(value(324, t));
+			level.byteCounts.push_back(value(325, t));
+
+			if(level.offsets.back() + level.byteCounts.back() > size) return fail("tile outside the file");
+		}
+
+		// NOTE: Georeferencing comes from the full-resolution image only.
+		if(file.levels.empty()) {
+			if(entries.count(33550) && entries.count(33922)) {
+				double sx = real(33550, 0);
+				double sy = real(33550, 1);
+
+				file.west = real(33922, 3) - real(33922, 0) * sx;
+				file.north = real(33922, 4) + real(33922, 1) * sy;
+				file.east = file.west + level.width * sx;
+				file.south = file.north - level.height * sy;
+				file.georeferenced = true;
+			}
+
+			// GeoKeyDirectory: a header of 4 shorts, then 4 per key (id, location, count, value).
+			for(uint64_t k = 1; k <= value(34735, 3); k++) {
+				auto id = value(34735, k * 4);
+				auto v = static_cast<int>(value(34735, k * 4 + 3));
+
+				if(id == 3072) file.epsg = v;
+
+				else if(id == 2048 && !file.epsg) file.epsg = v;
+			}
+		}
+
+		else if(level.samples != file.levels.front().samples) return fail("overviews differ in samples per pixel");
+
+		file.levels.push_back(std::move(level));
+	}
+
+	if(file.levels.empty()) return fail("no images");
+
+	std::stable_sort(file.levels.begin(), file.levels.end(), [](const Level& a, const Level& b) {
+		return a.width > b.width;
+	});
+
+	return file;
+}
+
+// Decodes TIFF's flavor of LZW (MSB-first codes of 9 to 12 bits, widening one code early) into at
+// most `outSize` bytes, returning how many were written.
+inline size_t decodeLzw(const unsigned char* in, size_t inSize, unsigned char* out, size_t outSize) {
+	constexpr int CLEAR = 256;
+	constexpr int END = 257;
+	constexpr int MAX_CODES = 4096;
+
+	// Each code is its prefix's string plus one byte.
+	uint16_t prefix[MAX_CODES];
+	unsigned char suffix[MAX_CODES];
+	unsigned char first[MAX_CODES];
+	uint16_t length[MAX_CODES];
+
+	for(int i = 0; i < 256; i++) {
+		prefix[i] = 0;
+		suffix[i] = first[i] = static_cast<unsigned char>(i);
+		length[i] = 1;
+	}
+
+	size_t bit = 0;
+	size_t written = 0;
+	int width = 9;
+	int next = 258;
+	int previous = -1;
+
+	// Writes code's string at `written`; strings are only walkable backwards, so it's filled in
+	// from its end.
+	auto emit = [&](int code) {
+		size_t n = length[code];
+		size_t end = std::min(written + n, outSize);
+
+		for(size_t i = written + n; i-- > written; code = prefix[code]) {
+			if(i < end) out[i] = suffix[code];
+		}
+
+		written = end;
+	};
+
+	while(written < outSize && bit + width <= inSize * 8) {
+		int code = 0;
+
+		for(int i = 0; i < width; i++, bit++) code = (code << 1) | ((in[bit >> 3] >> (7 - (bit & 7))) & 1);
+
+		if(code == END) break;
+
+		if(code == CLEAR) {
+			width = 9;
+			next = 258;
+			previous = -1;
+
+			continue;
+		}
+
+		if(previous < 0) {
+			if(code > 255) break;
+
+			emit(code);
+
+			previous = code;
+
+			continue;
+		}
+
+		// NOTE: The one code that can be used before it's defined (the KwKwK case) is `next`.
+		if(code > next || next >= MAX_CODES) break;
+
+		prefix[next] = static_cast<uint16_t>(previous);
+		suffix[next] = first[code == next ? previous : code];
+		first[next] = first[previous];
+		length[next] = static_cast<uint16_t>(length[previous] + 1);
+
+		emit(code);
+
+		if(++next >= (1 << width) - 1 && width < 12) width++;
+
+		previous = code;
+	}
+
+	return written;
+}
+
+// Undoes horizontal differencing (Predictor=2) in a decoded tile.
+inline void undoPredictor(unsigned char* tile, const Level& level) {
+	size_t row = static_cast<size_t>(level.tileWidth) * level.samples;
+
+	for(uint32_t y = 0; y < level.tileHeight; y++) {
+		unsigned char* p = tile + y * row;
+
+		for(size_t i = level.samples; i < row; i++) p[i] = static_cast<unsigned char>(p[i] + p[i - level.samples]);
+	}
+}
+
+}
+
+// A plain fixed-size pool; queued jobs still run before it shuts down. With no threads at all,
+// submit() runs the job right away instead.
+class ThreadPool {
+public:
+	ThreadPool(unsigned int threads) {
+		for(unsigned int i = 0; i < threads; i++) _threads.emplace_back([this]() {
+			_run();
+		});
+	}
+
+	~ThreadPool() {
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+
+			_quit = true;
+		}
+
+		_cv.notify_all();
+
+		for(auto& thread : _threads) thread.join();
+	}
+
+	template<typename F>
+	std::future<decltype(std::declval<F>()())> submit(F&& f) {
+		using R = decltype(std::declval<F>()());
+
+		auto task = std::make_shared<std::packaged_task<R()>>(std::forward<F>(f));
+		auto future = task->get_future();
+
+		if(_threads.empty()) (*task)();
+
+		else {
+			{
+				std::lock_guard<std::mutex> lock(_mutex);
+
+				_jobs.emplace_back([task]() {
+					(*task)();
+				});
+			}
+
+			_cv.notify_one();
+		}
+
+		return future;
+	}
+
+	size_t threads() const {
+		return _threads.size();
+	}
+
+private:
+	void _run() {
+		while(true) {
+			std::function<void()> job;
+
+			{
+				std::unique_lock<std::mutex> lock(_mutex);
+
+				_cv.wait(lock, [this]() {
+					return _quit || !_jobs.empty();
+				});
+
+				if(_jobs.empty()) return;
+
+				job = std::move(_jobs.front());
+
+				_jobs.pop_front();
+			}
+
+			job();
+		}
+	}
+
+	std::vector<std::thread> _threads;
+	std::deque<std::function<void()>> _jobs;
+	std::mutex _mutex;
+	std::condition_variable _cv;
+
+	bool _quit = false;
+};
+
+// The mapping every zero-copy tile image points into. Those images keep it alive (as their user
+// data), so the file stays mapped for as long as any texture could still upload from it.
+struct MappedFile: public osg::Referenced {
+	QFile file;
+
+	const unsigned char* data = nullptr;
+	size_t size = 0;
+};
+
+}
+
+// Reads an internally tiled GeoTIFF (uncompressed or LZW, with or without overviews) straight
+// from a memory mapping instead of through GDAL. Each TileKey is served by the file tile (of the
+// overview whose resolution fits) that contains it, through a texture matrix, like MyTextureLayer
+// does with its one texture; uncompressed tiles are wrapped in place, so their texels go from the
+// page cache to glTexImage2D without a single copy. LZW tiles are decoded on a thread pool. The
+// most recent `maxTiles` file tiles are kept as textures, shared by every key inside them (fewer,
+// if its MemoryAccount has a budget; mapped tiles only count once they're textures).
+//
+// NOTE: Keys that straddle file tiles (only ever coarser than the coarsest overview, for files
+// aligned to the profile the way gdal_translate writes world.tif) get an assembled, nearest-
+// sampled copy instead. So does createImage(), for callers like CachedImageLayer that want a
+// plain GeoImage.
+class MappedGeoTIFFLayer: public osgEarth::ImageLayer {
+public:
+	META_Layer(osgEarth, MappedGeoTIFFLayer, Options, ImageLayer, mappedgeotifflayer);
+
+	void setPath(const std::string& path) {
+		_path = path.c_str();
+	}
+
+	void setMaxTiles(size_t maxTiles) {
+		_maxTiles = std::max<size_t>(maxTiles, 1);
+	}
+
+	// Threads that decode LZW tiles.
+	void setDecodeThreads(unsigned int threads) {
+		_decodeThreads = std::max(threads, 1u);
+	}
+
+	virtual osgEarth::Status openImplementation() {
+		_mapping = new osg_qt6::MappedFile();
+		_mapping->file.setFileName(QString::fromStdString(_path));
+
+		if(!_mapping->file.open(QIODevice::ReadOnly)) {
+			return osgEarth::Status(osgEarth::Status::ResourceUnavailable, "can't open " + _path);
+		}
+
+		_mapping->size = static_cast<size_t>(_mapping->file.size());
+		_mapping->data = _mapping->file.map(0, _mapping->file.size());
+
+		if(!_mapping->data) return osgEarth::Status(osgEarth::Status::ResourceUnavailable, "can't map " + _path);
+
+		_tiff = osg_qt6::tiff::parse(_mapping->data, _mapping->size);
+
+		if(!_tiff.error.empty()) return osgEarth::Status(osgEarth::Status::ConfigurationError, _path + ": " + _tiff.error);
+
+		if(!_tiff.georeferenced) return osgEarth::Status(osgEarth::Status::ConfigurationError, _path + ": not georeferenced");
+
+		osg::ref_ptr<const osgEarth::SpatialReference> srs = osgEarth::SpatialReference::get(
+			_tiff.epsg ? "epsg:" + std::to_string(_tiff.epsg) : "wgs84"
+		);
+
+		if(!srs.valid()) return osgEarth::Status(osgEarth::Status::ConfigurationError, _path + ": unknown SRS");
+
+		// NOTE: A whole-world geographic file gets the standard profile, so its tiles line up with
+		// the map's and each key falls inside a single file tile.
+		bool global =
+			srs->isGeographic() &&
+			std::abs(_tiff.west + 180.0) < 1e-6 && std::abs(_tiff.east - 180.0) < 1e-6 &&
+			std::abs(_tiff.south + 90.0) < 1e-6 && std::abs(_tiff.north - 90.0) < 1e-6
+		;
+
+		setProfile(global ?
+			osgEarth::Profile::create(osgEarth::Profile::GLOBAL_GEODETIC) :
+			osgEarth::Profile::create(srs.get(), _tiff.west, _tiff.south, _tiff.east, _tiff.north)
+		);
+
+		setUseCreateTexture();
+
+		// The deepest LOD whose tiles are still no finer than the file; the terrain stretches
+		// those for anything below.
+		const auto& base = _tiff.levels.front();
+		double pixel = (_tiff.east - _tiff.west) / base.width;
+		unsigned int maxLevel = 0;
+
+		for(unsigned int tileSize = getTileSize(); maxLevel < 30; maxLevel++) {
+			osgEarth::TileKey key(maxLevel + 1, 0, 0, getProfile());
+
+			if(key.getExtent().width() / tileSize < pixel * 0.99) break;
+		}
+
+		addDataExtent(osgEarth::DataExtent(
+			osgEarth::GeoExtent(getProfile()->getSRS(), _tiff.west, _tiff.south, _tiff.east, _tiff.north),
+			0,
+			maxLevel
+		));
+
+		_pool = std::make_unique<osg_qt6::ThreadPool>(_decodeThreads);
+
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		_account = osg_qt6::memoryLedger().open(getName().empty() ? "MappedGeoTIFFLayer" : getName());
+
+		return osgEarth::Status::OK();
+	}
+
+	virtual osgEarth::TextureWindow createTexture(
+		const osgEarth::TileKey& key,
+		osgEarth::ProgressCallback* progress
+	) const {
+		Window w = _window(key);
+
+		if(w.tx0 != w.tx1 || w.ty0 != w.ty1) {
+			osg::ref_ptr<osg::Image> image = _assemble(w);
+
+			if(!image.valid()) return osgEarth::TextureWindow();
+
+			_assembled++;
+
+			return osgEarth::TextureWindow(_createTexture(image.get()), osg::Matrixf());
+		}
+
+		osg::ref_ptr<osg::Texture2D> texture = _tileTexture(w.level, w.tx0, w.ty0);
+
+		if(!texture.valid()) return osgEarth::TextureWindow();
+
+		const auto& level = _tiff.levels[w.level];
+
+		// The key's window in the tile's texture coordinates. The tile's rows are stored top first,
+		// so t runs from its north edge down, and the terrain's (south-up) v is flipped into it.
+		double s0 = w.u0 / level.tileWidth - w.tx0;
+		double s1 = (w.u0 + w.du) / level.tileWidth - w.tx0;
+		double t0 = w.v0 / level.tileHeight - w.ty0;
+		double t1 = (w.v0 + w.dv) / level.tileHeight - w.ty0;
+
+		osg::Matrixf textureMatrix =
+			osg::Matrixf::scale(s1 - s0, t0 - t1, 1.0) *
+			osg::Matrixf::translate(s0, t1, 0.0)
+		;
+
+		return osgEarth::TextureWindow(texture.get(), textureMatrix);
+	}
+
+	virtual osgEarth::GeoImage createImageImplementation(
+		const osgEarth::TileKey& key,
+		osgEarth::ProgressCallback* progress
+	) const {
+		osg::ref_ptr<osg::Image> image = _assemble(_window(key));
+
+		if(!image.valid()) return osgEarth::GeoImage::INVALID;
+
+		return osgEarth::GeoImage(image.get(), key.getExtent());
+	}
+
+	size_t cachedTiles() const {
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		return _cache.size();
+	}
+
+	// File tiles wrapped in place, decoded, and keys served by an assembled copy, so far.
+	size_t zeroCopyTiles() const {
+		return _zeroCopy;
+	}
+
+	size_t decodedTiles() const {
+		return _decoded;
+	}
+
+	size_t assembledKeys() const {
+		return _assembled;
+	}
+
+	const osg_qt6::tiff::File& tiff() const {
+		return _tiff;
+	}
+
+protected:
+	// A key's footprint in one level of the file, in that level's pixels (rows from the top), and
+	// the range of file tiles it touches.
+	struct Window {
+		size_t level = 0;
+
+		double u0 = 0.0;
+		double v0 = 0.0;
+		double du = 0.0;
+		double dv = 0.0;
+
+		uint32_t tx0 = 0;
+		uint32_t ty0 = 0;
+		uint32_t tx1 = 0;
+		uint32_t ty1 = 0;
+	};
+
+	using ImageFuture = std::shared_future<osg::ref_ptr<osg::Image>>;
+
+	struct Tile {
+		ImageFuture image;
+
+		osg::ref_ptr<osg::Texture2D> texture;
+
+		std::list<uint64_t>::iterator lru;
+
+		// NOTE: Wrapped tiles live in the page cache, so only decoded ones count as images.
+		int64_t imageBytes = 0;
+		int64_t textureBytes = 0;
+	};
+
+	Window _window(const osgEarth::TileKey& key) const {
+		const osgEarth::GeoExtent& extent = key.getExtent();
+
+		double width = _tiff.east - _tiff.west;
+		double height = _tiff.north - _tiff.south;
+
+		// Pick the coarsest level that still has at least a tile's worth of pixels under the key
+		// (the same rule as MyTiledTextureLayer); finer keys just get a smaller window of level 0.
+		Window w;
+
+		for(size_t i = 1; i < _tiff.levels.size(); i++) {
+			if(extent.width() / width * _tiff.levels[i].width < getTileSize()) break;
+
+			w.level = i;
+		}
+
+		const auto& level = _tiff.levels[w.level];
+
+		w.u0 = (extent.xMin() - _tiff.west) / width * level.width;
+		w.v0 = (_tiff.north - extent.yMax()) / height * level.height;
+		w.du = extent.width() / width * level.width;
+		w.dv = extent.height() / height * level.height;
+
+		// NOTE: A hair inside the window, so a key that ends exactly on a tile edge doesn't count
+		// the next tile too.
+		auto tile = [](double pixel, uint32_t size, uint32_t count) {
+			return static_cast<uint32_t>(std::clamp(std::floor(pixel / size), 0.0, count - 1.0));
+		};
+
+		w.tx0 = tile(w.u0 + 1e-6, level.tileWidth, level.tilesAcross());
+		w.ty0 = tile(w.v0 + 1e-6, level.tileHeight, level.tilesDown());
+		w.tx1 = tile(w.u0 + w.du - 1e-6, level.tileWidth, level.tilesAcross());
+		w.ty1 = tile(w.v0 + w.dv - 1e-6, level.tileHeight, level.tilesDown());
+
+		return w;
+	}
+
+	// The decoded (or wrapped) tile, already waiting in the cache or started now.
+	ImageFuture _tile(size_t level, uint32_t tx, uint32_t ty) const {
+		return _cacheEntry(level, tx, ty).image;
+	}
+
+	osg::ref_ptr<osg::Texture2D> _tileTexture(size_t level, uint32_t tx, uint32_t ty) const {
+		ImageFuture future = _tile(level, tx, ty);
+		osg::ref_ptr<osg::Image> image = future.get();
+
+		if(!image.valid()) return nullptr;
+
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		// NOTE: Evicted meanwhile (or never cached): a texture just for this caller.
+		auto i = _cache.find(_tileId(level, tx, ty));
+
+		if(i == _cache.end()) return _createTexture(image.get());
+
+		if(i->second.texture.valid()) return i->second.texture;
+
+		osg::ref_ptr<osg::Texture2D> texture = _createTexture(image.get());
+
+		i->second.texture = texture;
+		i->second.textureBytes = osg_qt6::textureBytes(texture.get());
+
+		_textureBytes += i->second.textureBytes;
+
+		_trim(i->first);
+
+		return texture;
+	}
+
+	// Finds (and bumps) or inserts the cache entry for a tile, evicting the oldest ones.
+	Tile _cacheEntry(size_t level, uint32_t tx, uint32_t ty) const {
+		uint64_t id = _tileId(level, tx, ty);
+
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		if(auto i = _cache.find(id); i != _cache.end()) {
+			_lru.splice(_lru.begin(), _lru, i->second.lru);
+
+			return i->second;
+		}
+
+		Tile tile;
+
+		const auto& l = _tiff.levels[level];
+		size_t index = static_cast<size_t>(ty) * l.tilesAcross() + tx;
+
+		if(l.compression == osg_qt6::tiff::COMPRESSION_NONE) {
+			std::promise<osg::ref_ptr<osg::Image>> wrapped;
+
+			wrapped.set_value(_wrapTile(l, index));
+
+			tile.image = wrapped.get_future().share();
+		}
+
+		else {
+			tile.image = _pool->submit([this, &l, index]() {
+				return _decodeTile(l, index);
+			}).share();
+
+			tile.imageBytes = static_cast<int64_t>(l.tileBytes());
+		}
+
+		_lru.push_front(id);
+
+		tile.lru = _lru.begin();
+
+		_cache[id] = tile;
+		_imageBytes += tile.imageBytes;
+
+		_trim(id);
+
+		return tile;
+	}
+
+	// Evicts the oldest entries while there are too many or the account is over budget, never
+	// `keep` (the entry just touched). Mutex must be held.
+	void _trim(uint64_t keep) const {
+		auto update = [this]() {
+			if(!_account) return;
+
+			_account->set(osg_qt6::MemoryAccount::IMAGES, _imageBytes);
+			_account->set(osg_qt6::MemoryAccount::TEXTURES, _textureBytes);
+		};
+
+		update();
+
+		while(_cache.size() > _maxTiles || (_cache.size() > 1 && _account && _account->overBudget())) {
+			if(_lru.back() == keep) break;
+
+			auto i = _cache.find(_lru.back());
+
+			_imageBytes -= i->second.imageBytes;
+			_textureBytes -= i->second.textureBytes;
+
+			_cache.erase(i);
+			_lru.pop_back();
+
+			update();
+		}
+	}
+
+	static uint64_t _tileId(size_t level, uint32_t tx, uint32_t ty) {
+		return static_cast<uint64_t>(level) << 48 | static_cast<uint64_t>(ty) << 24 | tx;
+	}
+
+	static GLenum _pixelFormat(const osg_qt6::tiff::Level& level) {
+		return level.samples == 4 ? GL_RGBA : level.samples == 3 ? GL_RGB : GL_LUMINANCE;
+	}
+
+	// NOTE: The image's rows are the file's, top first; only ever sampled through _window() math
+	// or the flipped texture matrix, never as a GeoImage.
+	osg::Image* _wrapTile(const osg_qt6::tiff::Level& level, size_t index) const {
+		if(level.byteCounts[index] < level.tileBytes()) return nullptr;
+
+		auto* image = new osg::Image();
+		auto format = _pixelFormat(level);
+
+		image->setImage(
+			level.tileWidth,
+			level.tileHeight,
+			1,
+			format,
+			format,
+			GL_UNSIGNED_BYTE,
+			const_cast<unsigned char*>(_mapping->data + level.offsets[index]),
+			osg::Image::NO_DELETE,
+			1
+		);
+
+		image->setOrigin(osg::Image::TOP_LEFT);
+		image->setUserData(_mapping.get());
+
+		_zeroCopy++;
+
+		return image;
+	}
+
+	osg::Image* _decodeTile(const osg_qt6::tiff::Level& level, size_t index) const {
+		auto* image = new osg::Image();
+		auto format = _pixelFormat(level);
+
+		image->allocateImage(level.tileWidth, level.tileHeight, 1, format, GL_UNSIGNED_BYTE, 1);
+		image->setOrigin(osg::Image::TOP_LEFT);
+
+		std::memset(image->data(), 0, level.tileBytes());
+
+		// NOTE: Tiles that were never written (sparse files) have no bytes at all, and stay empty.
+		if(level.byteCounts[index]) osg_qt6::tiff::decodeLzw(
+			_mapping->data + level.offsets[index],
+			level.byteCounts[index],
+			image->data(),
+			level.tileBytes()
+		);
+
+		if(level.predictor == osg_qt6::tiff::PREDICTOR_HORIZONTAL) osg_qt6::tiff::undoPredictor(image->data(), level);
+
+		_decoded++;
+
+		return image;
+	}
+
+	// Copies the window into a new, south-up RGBA image of the layer's tile size, fetching (and,
+	// where they need it, decoding) all the file tiles it touches in parallel first.
+	osg::Image* _assemble(const Window& w) const {
+		const auto& level = _tiff.levels[w.level];
+
+		std::vector<ImageFuture> futures;
+
+		for(uint32_t ty = w.ty0; ty <= w.ty1; ty++) for(uint32_t tx = w.tx0; tx <= w.tx1; tx++) {
+			futures.push_back(_tile(w.level, tx, ty));
+		}
+
+		std::vector<osg::ref_ptr<osg::Image>> tiles;
+
+		for(auto& future : futures) tiles.push_back(future.get());
+
+		auto size = static_cast<int>(getTileSize());
+		auto* image = new osg::Image();
+
+		image->allocateImage(size, size, 1, GL_RGBA, GL_UNSIGNED_BYTE);
+
+		for(int y = 0; y < size; y++) for(int x = 0; x < size; x++) {
+			unsigned char* out = image->data(x, y);
+
+			auto u = static_cast<uint32_t>(std::clamp(w.u0 + w.du * (x + 0.5) / size, 0.0, level.width - 1.0));
+			auto v = static_cast<uint32_t>(std::clamp(w.v0 + w.dv * (size - y - 0.5) / size, 0.0, level.height - 1.0));
+
+			auto tx = std::clamp(u / level.tileWidth, w.tx0, w.tx1);
+			auto ty = std::clamp(v / level.tileHeight, w.ty0, w.ty1);
+
+			const osg::Image* tile = tiles[(ty - w.ty0) * (w.tx1 - w.tx0 + 1) + (tx - w.tx0)].get();
+
+			if(!tile) {
+				std::fill_n(out, 4, 0);
+
+				continue;
+			}
+
+			const unsigned char* in = tile->data(u - tx * level.tileWidth, v - ty * level.tileHeight);
+
+			out[0] = in[0];
+			out[1] = in[level.samples >= 3 ? 1 : 0];
+			out[2] = in[level.samples >= 3 ? 2 : 0];
+			out[3] = level.samples == 4 ? in[3] : 255;
+		}
+
+		return image;
+	}
+
+	static osg::Texture2D* _createTexture(osg::Image* image) {
+		auto* texture = new osg::Texture2D(image);
+
+		texture->setFilter(osg::Texture::MIN_FILTER, osg::Texture::LINEAR_MIPMAP_LINEAR);
+		texture->setFilter(osg::Texture::MAG_FILTER, osg::Texture::LINEAR);
+		texture->setWrap(osg::Texture::WRAP_S, osg::Texture::CLAMP_TO_EDGE);
+		texture->setWrap(osg::Texture::WRAP_T, osg::Texture::CLAMP_TO_EDGE);
+		texture->setResizeNonPowerOfTwoHint(false);
+
+		return texture;
+	}
+
+	std::string _path;
+
+	size_t _maxTiles = 256;
+	unsigned int _decodeThreads = std::max(1u, std::thread::hardware_concurrency() / 2);
+
+	osg::ref_ptr<osg_qt6::MappedFile> _mapping;
+	osg_qt6::tiff::File _tiff;
+
+	mutable std::mutex _mutex;
+	mutable std::unordered_map<uint64_t, Tile> _cache;
+	mutable std::list<uint64_t> _lru;
+	mutable int64_t _imageBytes = 0;
+	mutable int64_t _textureBytes = 0;
+
+	std::shared_ptr<osg_qt6::MemoryAccount> _account;
+
+	mutable std::atomic<size_t> _zeroCopy = 0;
+	mutable std::atomic<size_t> _decoded = 0;
+	mutable std::atomic<size_t> _assembled = 0;
+
+	// NOTE: Last, so it's the first to go: any decode still queued finishes against everything
+	// above.
+	std::unique_ptr<osg_qt6::ThreadPool> _pool;
+};
@@ -0,0 +1,217 @@
+#pragma once
+
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+#include <osg/observer_ptr>
+#include <osgGA/EventQueue>
+
+#include "osg-qt6/input-recording.hpp"
+
+namespace osg_qt6 {
+
+// Sits between the QT input handlers and osgGA::EventQueue. High-rate mice/trackpads deliver many
+// move (and wheel) events per frame; pushing each one straight into the EventQueue means every
+// handler (manipulators, pickers, ...) processes every one of them. Instead, events are buffered
+// here and consecutive motion events collapse into one, so the queue sees at most one per run of
+// motion between button/key events. Consecutive wheel events are summed too, but still delivered
+// as one scroll event per notch (see deliverScroll()). Press/release order and timestamps are
+// preserved.
+//
+// Call flush() right before `_viewer->frame()` (on whichever thread calls it).
+class InputCoalescer {
+public:
+	InputCoalescer(osgGA::EventQueue* queue=nullptr):
+	_queue(queue) {
+	}
+
+	void setEventQueue(osgGA::EventQueue* queue) {
+		std::lock_guard lock(_mutex);
+
+		_queue = queue;
+	}
+
+	// Every event flush() delivers is also written to `recorder` (after merging, so replays see the
+	// same stream), stamped with when it arrived; nullptr stops.
+	//
+	// NOTE: The recorder is GUI thread only, so with one, flush() has to run there too.
+	void setRecorder(InputRecorder* recorder) {
+		std::lock_guard lock(_mutex);
+
+		_recorder = recorder;
+	}
+
+	void mousePress(float x, float y, unsigned int button) {
+		_push({Event::PRESS, x, y, button});
+	}
+
+	void mouseRelease(float x, float y, unsigned int button) {
+		_push({Event::RELEASE, x, y, button});
+	}
+
+	void mouseMove(float x, float y) {
+		_push({Event::MOVE, x, y});
+	}
+
+	// NOTE: The delta is in "notches" (QWheelEvent::angleDelta() / 120); a run merged within a
+	// frame still goes out as one scroll event per notch (see deliverScroll()).
+	void wheel(float dx, float dy) {
+		_push({Event::WHEEL, dx, dy});
+	}
+
+	void keyPress(int key) {
+		_push({Event::KEY_PRESS, 0.0f, 0.0f, 0, key});
+	}
+
+	void keyRelease(int key) {
+		_push({Event::KEY_RELEASE, 0.0f, 0.0f, 0, key});
+	}
+
+	void flush() {
+		std::lock_guard lock(_mutex);
+
+		if(!_queue.valid()) return;
+
+		for(const auto& e : _pending) {
+			if(_recorder) _recorder->record(
+				static_cast<InputRecord::Type>(e.type),
+				e.x,
+				e.y,
+				e.type == Event::PRESS || e.type == Event::RELEASE ? static_cast<std::int32_t>(e.button) : e.key,
+				e.arrived
+			);
+
+			switch(e.type) {
+				case Event::PRESS:
+					_queue->mouseButtonPress(e.x, e.y, e.button, e.time);
+					_eventsDelivered++;
+
+					break;
+
+				case Event::RELEASE:
+					_queue->mouseButtonRelease(e.x, e.y, e.button, e.time);
+					_eventsDelivered++;
+
+					break;
+
+				case Event::MOVE:
+					_queue->mouseMotion(e.x, e.y, e.time);
+					_eventsDelivered++;
+
+					break;
+
+				case Event::WHEEL:
+					_eventsDelivered += deliverScroll(_queue.get(), e.x, e.y, e.time);
+
+					break;
+
+				case Event::KEY_PRESS:
+					_queue->keyPress(e.key, e.time);
+					_eventsDelivered++;
+
+					break;
+
+				case Event::KEY_RELEASE:
+					_queue->keyRelease(e.key, e.time);
+					_eventsDelivered++;
+
+					break;
+			}
+		}
+
+		_pending.clear();
+	}
+
+	size_t pending() const {
+		std::lock_guard lock(_mutex);
+
+		return _pending.size();
+	}
+
+	unsigned long long eventsReceived() const {
+		std::lock_guard lock(_mutex);
+
+		return _eventsReceived;
+	}
+
+	unsigned long long eventsDelivered() const {
+		std::lock_guard lock(_mutex);
+
+		return _eventsDelivered;
+	}
+
+private:
+	struct Event {
+		enum Type {
+			PRESS,
+			RELEASE,
+			MOVE,
+			WHEEL,
+			KEY_PRESS,
+			KEY_RELEASE
+		};
+
+		Type type;
+
+		float x = 0.0f;
+		float y = 0.0f;
+
+		unsigned int button = 0;
+
+		int key = 0;
+
+		double time = 0.0;
+
+		std::chrono::steady_clock::time_point arrived;
+	};
+
+	void _push(Event e) {
+		std::lock_guard lock(_mutex);
+
+		_eventsReceived++;
+
+		e.arrived = std::chrono::steady_clock::now();
+
+		// Stamp with the EventQueue's clock as the event ARRIVES, so merged/deferred events still
+		// carry the time the user actually generated them.
+		e.time = _queue.valid() ? _queue->getTime() : 0.0;
+
+		if(!_pending.empty() && _pending.back().type == e.type) {
+			auto& back = _pending.back();
+
+			if(e.type == Event::MOVE) {
+				back = e;
+
+				return;
+			}
+
+			else if(e.type == Event::WHEEL) {
+				back.x += e.x;
+				back.y += e.y;
+				back.time = e.time;
+				back.arrived = e.arrived;
+
+				// Opposing spins that cancel out don't need to be delivered at all.
+				if(back.x == 0.0f && back.y == 0.0f) _pending.pop_back();
+
+				return;
+			}
+		}
+
+		_pending.push_back(e);
+	}
+
+	mutable std::mutex _mutex;
+
+	osg::observer_ptr<osgGA::EventQueue> _queue;
+
+	std::vector<Event> _pending;
+
+	InputRecorder* _recorder = nullptr;
+
+	unsigned long long _eventsReceived = 0;
+	unsigned long long _eventsDelivered = 0;
+};
+
+}
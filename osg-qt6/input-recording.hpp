@@ -0,0 +1,280 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <osgGA/EventQueue>
+
+namespace osg_qt6 {
+
+// One input event as InputRecorder writes it and InputReplay reads it back: 24 bytes in native
+// byte order (recordings aren't meant to travel between architectures), after a 16-byte header of
+// "OQ6INPUT", a version and the record size.
+struct InputRecord {
+	// NOTE: The first six match InputCoalescer's own event types, in the same order.
+	enum Type: std::uint32_t {
+		PRESS,
+		RELEASE,
+		MOVE,
+		WHEEL,
+		KEY_PRESS,
+		KEY_RELEASE,
+		// `x` and `y` are the new width and height.
+		RESIZE
+	};
+
+	// Seconds since the recording started.
+	double time;
+
+	std::uint32_t type;
+
+	// The button for PRESS/RELEASE, the key for KEY_PRESS/KEY_RELEASE.
+	std::int32_t code;
+
+	// Window coordinates (already flipped to OSG's bottom-up Y), wheel notches, or a size.
+	float x;
+	float y;
+};
+
+static_assert(sizeof(InputRecord) == 24);
+
+// Delivers a wheel delta in "notches" as InputCoalescer does, live or replayed: the stock
+// manipulators zoom one step per SCROLL_UP/SCROLL_DOWN and ignore the delta, so it goes out as
+// round(|delta|) of those (at least one); the first also carries the whole delta, for handlers that
+// read it via `GUIEventAdapter::getScrollingDeltaX/Y()`, and the rest carry none. Returns how many
+// events that was.
+inline size_t deliverScroll(osgGA::EventQueue* queue, float dx, float dy, double time) {
+	auto motion = dy != 0.0f ?
+		(dy > 0.0f ? osgGA::GUIEventAdapter::SCROLL_UP : osgGA::GUIEventAdapter::SCROLL_DOWN) :
+		(dx > 0.0f ? osgGA::GUIEventAdapter::SCROLL_RIGHT : osgGA::GUIEventAdapter::SCROLL_LEFT)
+	;
+
+	auto count = std::max(1L, std::lround(std::abs(dy != 0.0f ? dy : dx)));
+
+	for(long i = 0; i < count; i++) {
+		auto* ea = queue->mouseScroll(motion, time);
+
+		// NOTE: setScrollingMotionDelta() switches the motion to SCROLL_2D; put it back.
+		ea->setScrollingMotionDelta(i ? 0.0f : dx, i ? 0.0f : dy);
+		ea->setScrollingMotion(motion);
+	}
+
+	return static_cast<size_t>(count);
+}
+
+constexpr char INPUT_RECORDING_MAGIC[8] = {'O', 'Q', '6', 'I', 'N', 'P', 'U', 'T'};
+constexpr std::uint32_t INPUT_RECORDING_VERSION = 1;
+
+// Writes the input stream to a file as InputCoalescer delivers it (after merging, but stamped with
+// when each event arrived), so a replay feeds the viewer exactly what it saw live; hand it to
+// InputCoalescer::setRecorder() and call resize() from resizeGL(). GUI thread only.
+class InputRecorder {
+public:
+	~InputRecorder() {
+		close();
+	}
+
+	bool open(const std::string& path) {
+		close();
+
+		_file = std::fopen(path.c_str(), "wb");
+
+		if(!_file) return false;
+
+		std::uint32_t header[2] = {INPUT_RECORDING_VERSION, sizeof(InputRecord)};
+
+		std::fwrite(INPUT_RECORDING_MAGIC, sizeof(INPUT_RECORDING_MAGIC), 1, _file);
+		std::fwrite(header, sizeof(header), 1, _file);
+
+		_start = std::chrono::steady_clock::now();
+		_count = 0;
+
+		return true;
+	}
+
+	void close() {
+		if(!_file) return;
+
+		std::fclose(_file);
+
+		_file = nullptr;
+	}
+
+	bool recording() const {
+		return _file != nullptr;
+	}
+
+	size_t count() const {
+		return _count;
+	}
+
+	// NOTE: Anything that arrived before the recording started is stamped with its start.
+	void record(
+		InputRecord::Type type,
+		float x,
+		float y,
+		std::int32_t code=0,
+		std::chrono::steady_clock::time_point when=std::chrono::steady_clock::now()
+	) {
+		if(!_file) return;
+
+		InputRecord r{
+			std::max(0.0, std::chrono::duration<double>(when - _start).count()),
+			type,
+			code,
+			x,
+			y
+		};
+
+		std::fwrite(&r, sizeof(r), 1, _file);
+
+		_count++;
+	}
+
+	void resize(int width, int height) {
+		record(InputRecord::RESIZE, static_cast<float>(width), static_cast<float>(height));
+	}
+
+private:
+	std::FILE* _file = nullptr;
+
+	std::chrono::steady_clock::time_point _start;
+
+	size_t _count = 0;
+};
+
+// Plays an InputRecorder file back into an osgGA::EventQueue on a simulated clock: advance(t)
+// delivers every event recorded up to `t` seconds in, stamped with its recorded time. Drive the
+// viewer with the same clock (i.e., `frame(t)`, so the reference time the event traversal and the
+// manipulators go by is `t` as well) and a session replays identically on every run.
+//
+// NOTE: Recordings already hold what InputCoalescer delivered, so events go straight into the
+// queue; wheel records are expanded into notches the same way (deliverScroll()).
+class InputReplay {
+public:
+	// Called for RESIZE records (after the queue's windowResize()); the initial size is available up
+	// front from initialSize().
+	using ResizeCallback = std::function<void(int width, int height)>;
+
+	bool open(const std::string& path) {
+		_records.clear();
+		_next = 0;
+
+		std::FILE* f = std::fopen(path.c_str(), "rb");
+
+		if(!f) return false;
+
+		char magic[sizeof(INPUT_RECORDING_MAGIC)];
+		std::uint32_t header[2] = {0, 0};
+
+		bool ok =
+			std::fread(magic, sizeof(magic), 1, f) == 1 &&
+			std::fread(header, sizeof(header), 1, f) == 1 &&
+			!std::memcmp(magic, INPUT_RECORDING_MAGIC, sizeof(magic)) &&
+			header[0] == INPUT_RECORDING_VERSION &&
+			header[1] == sizeof(InputRecord)
+		;
+
+		for(InputRecord r; ok && std::fread(&r, sizeof(r), 1, f) == 1;) _records.push_back(r);
+
+		std::fclose(f);
+
+		return ok;
+	}
+
+	void setResizeCallback(ResizeCallback callback) {
+		_resize = std::move(callback);
+	}
+
+	size_t size() const {
+		return _records.size();
+	}
+
+	double duration() const {
+		return _records.empty() ? 0.0 : _records.back().time;
+	}
+
+	bool done() const {
+		return _next >= _records.size();
+	}
+
+	// The window size at the start of the recording (the first RESIZE, if it comes before any input).
+	bool initialSize(int& width, int& height) const {
+		for(const auto& r : _records) {
+			if(r.type != InputRecord::RESIZE) continue;
+
+			width = static_cast<int>(r.x);
+			height = static_cast<int>(r.y);
+
+			return true;
+		}
+
+		return false;
+	}
+
+	// Delivers everything up to `time`; returns how many events that was.
+	size_t advance(osgGA::EventQueue* queue, double time) {
+		size_t count = 0;
+
+		for(; _next < _records.size() && _records[_next].time <= time; _next++, count++) {
+			const auto& r = _records[_next];
+
+			switch(r.type) {
+				case InputRecord::PRESS:
+					queue->mouseButtonPress(r.x, r.y, static_cast<unsigned int>(r.code), r.time);
+
+					break;
+
+				case InputRecord::RELEASE:
+					queue->mouseButtonRelease(r.x, r.y, static_cast<unsigned int>(r.code), r.time);
+
+					break;
+
+				case InputRecord::MOVE:
+					queue->mouseMotion(r.x, r.y, r.time);
+
+					break;
+
+				case InputRecord::WHEEL:
+					deliverScroll(queue, r.x, r.y, r.time);
+
+					break;
+
+				case InputRecord::KEY_PRESS:
+					queue->keyPress(r.code, r.time);
+
+					break;
+
+				case InputRecord::KEY_RELEASE:
+					queue->keyRelease(r.code, r.time);
+
+					break;
+
+				case InputRecord::RESIZE:
+					queue->windowResize(0, 0, static_cast<int>(r.x), static_cast<int>(r.y), r.time);
+
+					if(_resize) _resize(static_cast<int>(r.x), static_cast<int>(r.y));
+
+					break;
+			}
+		}
+
+		return count;
+	}
+
+private:
+	std::vector<InputRecord> _records;
+
+	size_t _next = 0;
+
+	ResizeCallback _resize;
+};
+
+}
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include <osg/Geometry>
+#include <osg/Program>
+#include <osg/VertexAttribDivisor>
+
+namespace osg_qt6 {
+
+// Per-instance data for a sphere field: center (xyz) and radius (w).
+using SphereInstances = std::vector<osg::Vec4>;
+
+// `count` spheres scattered uniformly through a cube sized to keep the density constant, so the
+// view (and per-sphere screen size) stays comparable as the count grows. Seeded, so every run and
+// both scene variants see the same field.
+inline SphereInstances createSphereInstances(size_t count, float radius=1.0f, unsigned int seed=1234) {
+	double side = 10.0 * radius * std::cbrt(static_cast<double>(count));
+
+	std::mt19937 rng(seed);
+	std::uniform_real_distribution<double> pos(-side / 2.0, side / 2.0);
+
+	SphereInstances instances;
+
+	instances.reserve(count);
+
+	for(size_t i = 0; i < count; i++) instances.emplace_back(pos(rng), pos(rng), pos(rng), radius);
+
+	return instances;
+}
+
+// A unit sphere as an indexed triangle mesh (with normals), tessellated like ShapeDrawable's default.
+inline void createUnitSphereMesh(
+	osg::Vec3Array* vertices,
+	osg::Vec3Array* normals,
+	osg::DrawElementsUInt* triangles,
+	unsigned int segments=40,
+	unsigned int rings=20
+) {
+	for(unsigned int r = 0; r <= rings; r++) {
+		double phi = osg::PI * r / rings - osg::PI_2;
+
+		for(unsigned int s = 0; s <= segments; s++) {
+			double theta = 2.0 * osg::PI * s / segments;
+
+			osg::Vec3 n(std::cos(phi) * std::cos(theta), std::cos(phi) * std::sin(theta), std::sin(phi));
+
+			vertices->push_back(n);
+			normals->push_back(n);
+		}
+	}
+
+	for(unsigned int r = 0; r < rings; r++) for(unsigned int s = 0; s < segments; s++) {
+		unsigned int a = r * (segments + 1) + s;
+		unsigned int b = a + segments + 1;
+
+		triangles->push_back(a);
+		triangles->push_back(a + 1);
+		triangles->push_back(b);
+		triangles->push_back(a + 1);
+		triangles->push_back(b + 1);
+		triangles->push_back(b);
+	}
+}
+
+// Every sphere in `instances` as ONE instanced draw of one shared mesh: the centers/radii live in a
+// single per-instance vertex buffer (attribute divisor 1), so there's one node, one state set and one
+// draw call no matter the count. Compare to createSphereAt(), which is a MatrixTransform, a Geode,
+// a ShapeDrawable and an osg::Point per sphere.
+//
+// NOTE: Lighting is a fixed headlight in the shader, standing in for the FFP's default light.
+inline osg::Geometry* createInstancedSpheres(const SphereInstances& instances) {
+	static constexpr unsigned int INSTANCE_ATTRIBUTE = 6;
+
+	static const char* vertexSource =
+		"#version 120\n"
+		"attribute vec4 osg_qt6_instance;\n"
+		"varying vec4 vColor;\n"
+		"void main() {\n"
+		"	vec3 n = normalize(gl_NormalMatrix * gl_Normal);\n"
+		"	float d = max(dot(n, vec3(0.0, 0.0, 1.0)), 0.0);\n"
+		"	vColor = vec4(vec3(0.2 + 0.8 * d), 1.0);\n"
+		"	gl_Position = gl_ModelViewProjectionMatrix * vec4(osg_qt6_instance.xyz + gl_Vertex.xyz * osg_qt6_instance.w, 1.0);\n"
+		"}\n"
+	;
+
+	static const char* fragmentSource =
+		"#version 120\n"
+		"varying vec4 vColor;\n"
+		"void main() {\n"
+		"	gl_FragColor = vColor;\n"
+		"}\n"
+	;
+
+	auto* vertices = new osg::Vec3Array();
+	auto* normals = new osg::Vec3Array();
+	auto* triangles = new osg::DrawElementsUInt(GL_TRIANGLES);
+	auto* data = new osg::Vec4Array(instances.begin(), instances.end());
+
+	createUnitSphereMesh(vertices, normals, triangles);
+
+	triangles->setNumInstances(static_cast<int>(instances.size()));
+
+	auto* geometry = new osg::Geometry();
+
+	geometry->setUseDisplayList(false);
+	geometry->setUseVertexBufferObjects(true);
+	geometry->setVertexArray(vertices);
+	geometry->setNormalArray(normals, osg::Array::BIND_PER_VERTEX);
+	// NOTE: Bound "per vertex" as far as OSG is concerned; the divisor below is what makes GL
+	// advance it once per instance instead.
+	geometry->setVertexAttribArray(INSTANCE_ATTRIBUTE, data, osg::Array::BIND_PER_VERTEX);
+	geometry->addPrimitiveSet(triangles);
+
+	// OSG only sees the one unit mesh, so the bound has to come from the instances.
+	osg::BoundingBox bound;
+
+	for(const auto& i : instances) bound.expandBy(osg::BoundingSphere(osg::Vec3(i.x(), i.y(), i.z()), i.w()));
+
+	geometry->setInitialBound(bound);
+
+	auto* program = new osg::Program();
+
+	program->addShader(new osg::Shader(osg::Shader::VERTEX, vertexSource));
+	program->addShader(new osg::Shader(osg::Shader::FRAGMENT, fragmentSource));
+	program->addBindAttribLocation("osg_qt6_instance", INSTANCE_ATTRIBUTE);
+
+	osg::StateSet* ss = geometry->getOrCreateStateSet();
+
+	ss->setAttributeAndModes(program, osg::StateAttribute::ON);
+	ss->setAttribute(new osg::VertexAttribDivisor(INSTANCE_ATTRIBUTE, 1));
+
+	return geometry;
+}
+
+}
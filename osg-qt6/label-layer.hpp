@@ -0,0 +1,556 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <osg/MatrixTransform>
+#include <osgText/Text>
+#include <osgUtil/CullVisitor>
+#include <osgViewer/View>
+
+#include <osgEarth/GeoData>
+
+#include "osg-qt6/memory-ledger.hpp"
+
+namespace osg_qt6 {
+
+// Screen-space label decluttering in roughly O(n): every label's rectangle is projected, the
+// labels are bucketed by (quantized) priority, and then, highest priority first, each one is kept
+// only if it overlaps none already kept, which a uniform grid of CELL-pixel cells answers by
+// looking at just the few cells the rectangle covers.
+//
+// That pass runs on a worker thread, with whatever matrices submit() was last given (the previous
+// frame's, in practice), and poll() picks up its latest result without waiting. fade() then
+// moves each label's opacity toward shown/hidden over FADE_SECONDS, so nothing pops.
+//
+// A camera (and set of labels) that hasn't changed since the last submit() isn't decluttered again,
+// so a still view leaves the worker, and pending(), idle.
+class LabelDeclutter {
+public:
+	static constexpr int CELL = 64;
+	static constexpr int PRIORITY_LEVELS = 256;
+
+	static constexpr float FADE_SECONDS = 0.25f;
+
+	struct Label {
+		// Relative to the origin given to submit().
+		osg::Vec3 position;
+
+		// Pixels, to the right of (and vertically centered on) the anchor.
+		float width;
+		float height;
+
+		// 0 to 1; higher wins.
+		float priority;
+	};
+
+	struct Stats {
+		double ms = 0.0;
+
+		size_t visible = 0;
+	};
+
+	LabelDeclutter() {
+		_worker = std::thread([this]() {
+			_workLoop();
+		});
+	}
+
+	~LabelDeclutter() {
+		{
+			std::lock_guard lock(_mutex);
+
+			_quit = true;
+		}
+
+		_wake.notify_all();
+		_worker.join();
+	}
+
+	size_t add(const Label& label) {
+		_labels.push_back(label);
+		_alphas.push_back(0.0f);
+		_shown.push_back(0);
+
+		_dirty = true;
+
+		return _labels.size() - 1;
+	}
+
+	size_t size() const {
+		return _labels.size();
+	}
+
+	float alpha(size_t i) const {
+		return _alphas[i];
+	}
+
+	// Hands the worker the camera to declutter for; replaces anything it hasn't started on yet.
+	// `modelView` maps label positions to eye space, and `origin` is where they're relative to (for
+	// telling which side of the globe they're on). `ready`, if given, is called from the worker
+	// once the result is in. Returns false (and does nothing) if neither the camera nor the labels
+	// changed since the last one.
+	bool submit(
+		const osg::Matrixd& modelView,
+		const osg::Matrixd& projection,
+		int width,
+		int height,
+		const osg::Vec3d& origin,
+		std::function<void()> ready=nullptr
+	) {
+		bool same = _snapshot &&
+			modelView == _last.modelView &&
+			projection == _last.projection &&
+			width == _last.width &&
+			height == _last.height &&
+			origin == _last.origin
+		;
+
+		if(same && !_dirty) return false;
+
+		// NOTE: The worker gets its own copy of the labels, only remade when they've changed.
+		if(_dirty || !_snapshot) _snapshot = std::make_shared<const std::vector<Label>>(_labels);
+
+		_dirty = false;
+		_last = {_snapshot, modelView, projection, width, height, origin};
+
+		{
+			std::lock_guard lock(_mutex);
+
+			_job = _last;
+			_job.ready = std::move(ready);
+			_job.sequence = ++_submitted;
+			_hasJob = true;
+		}
+
+		_wake.notify_one();
+
+		return true;
+	}
+
+	// Whether a submit() is still waiting on poll() to take its result.
+	bool pending() {
+		std::lock_guard lock(_mutex);
+
+		return _polled != _submitted;
+	}
+
+	// Takes the worker's newest result, if there's one; returns whether there was.
+	bool poll() {
+		std::lock_guard lock(_mutex);
+
+		if(!_hasResult) return false;
+
+		_hasResult = false;
+		_polled = _resultSequence;
+
+		// NOTE: A result for fewer labels than there are now (some were added since) leaves the new
+		// ones hidden until the next.
+		std::copy(_result.begin(), _result.begin() + std::min(_result.size(), _shown.size()), _shown.begin());
+
+		_stats = _resultStats;
+
+		return true;
+	}
+
+	// Steps every label's opacity `dt` seconds toward its target; appends the ones that changed
+	// (none, once every label has arrived).
+	void fade(float dt, std::vector<size_t>& changed) {
+		float step = dt / FADE_SECONDS;
+
+		for(size_t i = 0; i < _alphas.size(); i++) {
+			float target = _shown[i] ? 1.0f : 0.0f;
+			float& a = _alphas[i];
+
+			if(a == target) continue;
+
+			a = target > a ? std::min(target, a + step) : std::max(target, a - step);
+
+			changed.push_back(i);
+		}
+	}
+
+	// From the last result poll() took.
+	const Stats& stats() const {
+		return _stats;
+	}
+
+private:
+	struct Job {
+		std::shared_ptr<const std::vector<Label>> labels;
+
+		osg::Matrixd modelView;
+		osg::Matrixd projection;
+
+		int width = 0;
+		int height = 0;
+
+		osg::Vec3d origin;
+
+		std::function<void()> ready;
+
+		unsigned long long sequence = 0;
+	};
+
+	struct Rect {
+		float x0;
+		float y0;
+		float x1;
+		float y1;
+
+		bool overlaps(const Rect& r) const {
+			return x0 < r.x1 && r.x0 < x1 && y0 < r.y1 && r.y0 < y1;
+		}
+	};
+
+	void _workLoop() {
+		std::unique_lock lock(_mutex);
+
+		while(true) {
+			_wake.wait(lock, [this]() {
+				return _quit || _hasJob;
+			});
+
+			if(_quit) return;
+
+			Job job = std::move(_job);
+
+			_hasJob = false;
+
+			lock.unlock();
+
+			auto start = std::chrono::steady_clock::now();
+
+			_declutter(job);
+
+			Stats stats;
+
+			stats.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+			stats.visible = static_cast<size_t>(std::count(_shownWork.begin(), _shownWork.end(), 1));
+
+			lock.lock();
+
+			_result.swap(_shownWork);
+			_resultStats = stats;
+			_resultSequence = job.sequence;
+			_hasResult = true;
+
+			if(!job.ready) continue;
+
+			lock.unlock();
+
+			job.ready();
+
+			lock.lock();
+		}
+	}
+
+	// Worker thread only (it owns everything `...Work`).
+	void _declutter(const Job& job) {
+		const auto& labels = *job.labels;
+
+		size_t n = labels.size();
+
+		_shownWork.assign(n, 0);
+		_rectsWork.resize(n);
+		_orderWork.resize(n);
+
+		osg::Matrixd mvp = job.modelView * job.projection;
+		osg::Vec3d eye = osg::Matrixd::inverse(job.modelView).getTrans();
+
+		float w = static_cast<float>(job.width);
+		float h = static_cast<float>(job.height);
+
+		// Project, and count each priority level.
+		std::fill(std::begin(_levels), std::end(_levels), 0);
+
+		std::vector<int>& level = _levelWork;
+
+		level.assign(n, -1);
+
+		for(size_t i = 0; i < n; i++) {
+			const auto& l = labels[i];
+
+			osg::Vec3d p(l.position);
+
+			// NOTE: On the far side of the globe (facing away from the eye).
+			if((p + job.origin) * (eye - p) < 0.0) continue;
+
+			osg::Vec4d clip = osg::Vec4d(p, 1.0) * mvp;
+
+			if(clip.w() <= 0.0) continue;
+
+			float x = static_cast<float>((clip.x() / clip.w() * 0.5 + 0.5) * w);
+			float y = static_cast<float>((clip.y() / clip.w() * 0.5 + 0.5) * h);
+
+			Rect r{x, y - l.height * 0.5f, x + l.width, y + l.height * 0.5f};
+
+			if(r.x1 < 0.0f || r.x0 > w || r.y1 < 0.0f || r.y0 > h) continue;
+
+			_rectsWork[i] = r;
+
+			level[i] = PRIORITY_LEVELS - 1 - std::clamp(static_cast<int>(l.priority * (PRIORITY_LEVELS - 1) + 0.5f), 0, PRIORITY_LEVELS - 1);
+
+			_levels[level[i]]++;
+		}
+
+		// Counting sort: highest priority first, insertion order within a level.
+		size_t total = 0;
+
+		for(auto& c : _levels) {
+			size_t count = c;
+
+			c = total;
+			total += count;
+		}
+
+		_orderWork.resize(total);
+
+		for(size_t i = 0; i < n; i++) if(level[i] >= 0) _orderWork[_levels[level[i]]++] = static_cast<std::uint32_t>(i);
+
+		// Resolve against the grid.
+		int columns = std::max(1, (job.width + CELL - 1) / CELL);
+		int rows = std::max(1, (job.height + CELL - 1) / CELL);
+
+		_cellsWork.resize(static_cast<size_t>(columns) * rows);
+
+		for(auto& cell : _cellsWork) cell.clear();
+
+		for(auto i : _orderWork) {
+			const Rect& r = _rectsWork[i];
+
+			int cx0 = std::clamp(static_cast<int>(r.x0) / CELL, 0, columns - 1);
+			int cx1 = std::clamp(static_cast<int>(r.x1) / CELL, 0, columns - 1);
+			int cy0 = std::clamp(static_cast<int>(r.y0) / CELL, 0, rows - 1);
+			int cy1 = std::clamp(static_cast<int>(r.y1) / CELL, 0, rows - 1);
+
+			bool free = true;
+
+			for(int cy = cy0; free && cy <= cy1; cy++) for(int cx = cx0; free && cx <= cx1; cx++) {
+				for(auto j : _cellsWork[cy * columns + cx]) if(r.overlaps(_rectsWork[j])) {
+					free = false;
+
+					break;
+				}
+			}
+
+			if(!free) continue;
+
+			_shownWork[i] = 1;
+
+			for(int cy = cy0; cy <= cy1; cy++) for(int cx = cx0; cx <= cx1; cx++) _cellsWork[cy * columns + cx].push_back(i);
+		}
+	}
+
+	// GUI/update thread.
+	std::vector<Label> _labels;
+	std::vector<float> _alphas;
+	std::vector<std::uint8_t> _shown;
+
+	std::shared_ptr<const std::vector<Label>> _snapshot;
+
+	Job _last;
+
+	bool _dirty = false;
+
+	Stats _stats;
+
+	// Worker thread; reused frame to frame so a pass doesn't allocate.
+	std::vector<std::uint8_t> _shownWork;
+	std::vector<Rect> _rectsWork;
+	std::vector<std::uint32_t> _orderWork;
+	std::vector<int> _levelWork;
+	std::vector<std::vector<std::uint32_t>> _cellsWork;
+
+	size_t _levels[PRIORITY_LEVELS];
+
+	// Shared (under `_mutex`).
+	std::mutex _mutex;
+	std::condition_variable _wake;
+	std::thread _worker;
+
+	Job _job;
+	std::vector<std::uint8_t> _result;
+	Stats _resultStats;
+
+	unsigned long long _submitted = 0;
+	unsigned long long _resultSequence = 0;
+	unsigned long long _polled = 0;
+
+	bool _hasJob = false;
+	bool _hasResult = false;
+	bool _quit = false;
+};
+
+// Text labels (screen-sized osgText, to the right of their anchor) for any number of points, kept
+// from overlapping by a LabelDeclutter: only the labels that won their spot are drawn at all, and
+// they fade in and out as the camera moves.
+//
+// The update callback (which picks up declutter results and fades) is only installed while there's
+// a result coming or a fade running, so a still view lets the viewer go idle (checkNeedToDoFrame()
+// is false); the worker asks the view for a redraw when a result is in.
+//
+// NOTE: Like PlacemarkLayer, positions are relative to the first label, for precision. Add labels
+// between frames (or from the update traversal), not while the viewer is culling.
+class LabelLayer: public osg::MatrixTransform {
+public:
+	LabelLayer(float characterSize=16.0f):
+	_characterSize(characterSize) {
+		_updateCallback = new UpdateCallback();
+
+		setCullingActive(false);
+
+		osg::StateSet* ss = getOrCreateStateSet();
+
+		ss->setMode(GL_DEPTH_TEST, osg::StateAttribute::OFF);
+		ss->setMode(GL_LIGHTING, osg::StateAttribute::OFF | osg::StateAttribute::PROTECTED);
+		ss->setRenderingHint(osg::StateSet::TRANSPARENT_BIN);
+
+		_account = memoryLedger().open("LabelLayer");
+		_account->setMeasure([this]() {
+			return MemoryVisitor::measure(*this);
+		});
+	}
+
+	// `priority` from 0 to 1; where labels collide, the higher one is shown.
+	size_t add(const osg::Vec3d& world, const std::string& label, float priority=0.5f) {
+		if(_texts.empty()) setMatrix(osg::Matrix::translate(world));
+
+		osg::Vec3 position(world - getMatrix().getTrans());
+
+		auto* text = new osgText::Text();
+
+		text->setDataVariance(osg::Object::DYNAMIC);
+		text->setCharacterSize(_characterSize);
+		text->setCharacterSizeMode(osgText::Text::SCREEN_COORDS);
+		text->setAutoRotateToScreen(true);
+		text->setAlignment(osgText::Text::LEFT_CENTER);
+		text->setBackdropType(osgText::Text::OUTLINE);
+		text->setPosition(position);
+		text->setText(label);
+		text->setNodeMask(0);
+
+		addChild(text);
+
+		_texts.push_back(text);
+
+		// NOTE: An estimate from the character count; measuring the real glyphs would need the font
+		// loaded, and decluttering only needs to be about right.
+		return _declutter.add({
+			position,
+			_characterSize * (0.6f * static_cast<float>(label.size()) + 0.5f),
+			_characterSize * 1.2f,
+			priority
+		});
+	}
+
+	size_t add(const osgEarth::GeoPoint& gp, const std::string& label, float priority=0.5f) {
+		osg::Vec3d world;
+
+		if(!gp.toWorld(world)) return static_cast<size_t>(-1);
+
+		return add(world, label, priority);
+	}
+
+	size_t size() const {
+		return _texts.size();
+	}
+
+	const LabelDeclutter& declutter() const {
+		return _declutter;
+	}
+
+	void traverse(osg::NodeVisitor& nv) override {
+		if(nv.getVisitorType() == osg::NodeVisitor::CULL_VISITOR) _submit(static_cast<osgUtil::CullVisitor&>(nv));
+
+		osg::MatrixTransform::traverse(nv);
+	}
+
+protected:
+	struct UpdateCallback: public osg::NodeCallback {
+		void operator()(osg::Node* node, osg::NodeVisitor* nv) override {
+			static_cast<LabelLayer*>(node)->_update(*nv);
+
+			traverse(node, nv);
+		}
+	};
+
+	// Only the view's own camera; osgEarth's RTT cameras (draping, etc.) traverse the map too.
+	void _submit(osgUtil::CullVisitor& cv) {
+		auto* camera = cv.getCurrentCamera();
+
+		if(!camera || !camera->getView() || !camera->getViewport() || !cv.getModelViewMatrix()) return;
+
+		osg::observer_ptr<osgViewer::View> view = dynamic_cast<osgViewer::View*>(camera->getView());
+
+		bool submitted = _declutter.submit(
+			*cv.getModelViewMatrix(),
+			*cv.getProjectionMatrix(),
+			static_cast<int>(camera->getViewport()->width()),
+			static_cast<int>(camera->getViewport()->height()),
+			getMatrix().getTrans(),
+			[view]() {
+				if(osg::ref_ptr<osgViewer::View> v; view.lock(v)) v->requestRedraw();
+			}
+		);
+
+		// NOTE: The update traversal isn't running now (it's done for this frame), and only the
+		// view's own camera gets here.
+		if(submitted) _setUpdating(true);
+	}
+
+	void _setUpdating(bool updating) {
+		if(updating == (getUpdateCallback() != nullptr)) return;
+
+		// A fade starts from where it is, not from however long ago the last one ended.
+		_lastTime = -1.0;
+
+		setUpdateCallback(updating ? _updateCallback.get() : nullptr);
+	}
+
+	void _update(osg::NodeVisitor& nv) {
+		double t = nv.getFrameStamp() ? nv.getFrameStamp()->getReferenceTime() : 0.0;
+		float dt = _lastTime < 0.0 ? 0.0f : static_cast<float>(t - _lastTime);
+
+		_lastTime = t;
+
+		_declutter.poll();
+
+		_changed.clear();
+		_declutter.fade(dt, _changed);
+
+		for(auto i : _changed) {
+			float a = _declutter.alpha(i);
+			auto* text = _texts[i].get();
+
+			text->setColor(osg::Vec4(1.0f, 1.0f, 1.0f, a));
+			text->setBackdropColor(osg::Vec4(0.0f, 0.0f, 0.0f, a));
+			text->setNodeMask(a > 0.0f ? ~0u : 0u);
+		}
+
+		if(_changed.empty() && !_declutter.pending()) _setUpdating(false);
+	}
+
+	float _characterSize;
+
+	osg::ref_ptr<UpdateCallback> _updateCallback;
+
+	std::vector<osg::ref_ptr<osgText::Text>> _texts;
+	std::vector<size_t> _changed;
+
+	LabelDeclutter _declutter;
+
+	double _lastTime = -1.0;
+
+	std::shared_ptr<MemoryAccount> _account;
+};
+
+}
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+#include <osg/ref_ptr>
+
+#include <osgEarth/MapNode>
+
+namespace osg_qt6 {
+
+// Named startup milestones, in milliseconds since the profile was created (which main() should do
+// first thing, via startupProfile()). Safe to mark() from any thread.
+class StartupProfile {
+public:
+	struct Phase {
+		std::string name;
+
+		// Since the profile started, and since the previous mark.
+		double ms;
+		double deltaMs;
+	};
+
+	StartupProfile() {
+		_clock.start();
+	}
+
+	void mark(const std::string& name) {
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		double ms = _clock.nsecsElapsed() / 1.0e6;
+
+		_phases.push_back({name, ms, ms - (_phases.empty() ? 0.0 : _phases.back().ms)});
+	}
+
+	// Marks `name` unless it already has been; returns whether it did.
+	bool markOnce(const std::string& name) {
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+
+			for(const auto& p : _phases) if(p.name == name) return false;
+		}
+
+		mark(name);
+
+		return true;
+	}
+
+	QJsonArray toJson() const {
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		QJsonArray phases;
+
+		for(const auto& p : _phases) phases.append(QJsonObject{
+			{"phase", QString::fromStdString(p.name)},
+			{"ms", p.ms},
+			{"delta_ms", p.deltaMs}
+		});
+
+		return phases;
+	}
+
+	std::string toString() const {
+		return QJsonDocument(toJson()).toJson(QJsonDocument::Compact).toStdString();
+	}
+
+private:
+	mutable std::mutex _mutex;
+
+	QElapsedTimer _clock;
+
+	std::vector<Phase> _phases;
+};
+
+inline StartupProfile& startupProfile() {
+	static StartupProfile profile;
+
+	return profile;
+}
+
+// Builds a MapNode (osgEarth::initialize(), opening layers, the terrain engine, ...) on a thread of
+// its own, then hands it to `ready` on the thread `context` lives on (i.e. the GUI thread, through
+// its event loop), so the widget can show a placeholder scene in the meantime and simply
+// `setSceneData()` the real one when it arrives.
+//
+// NOTE: If `context` is destroyed first, `ready` is never called. The destructor waits for the
+// build to finish; osgEarth has no way to cancel a layer that's halfway open.
+class MapLoader {
+public:
+	using Build = std::function<osgEarth::MapNode*(StartupProfile&)>;
+	using Ready = std::function<void(osgEarth::MapNode*)>;
+
+	~MapLoader() {
+		if(_thread.joinable()) _thread.join();
+	}
+
+	void start(QObject* context, Build build, Ready ready, StartupProfile& profile=startupProfile()) {
+		if(_thread.joinable()) return;
+
+		_thread = std::thread([context, build=std::move(build), ready=std::move(ready), &profile]() {
+			osg::ref_ptr<osgEarth::MapNode> node = build(profile);
+
+			QMetaObject::invokeMethod(context, [ready, node]() {
+				ready(node.get());
+			}, Qt::QueuedConnection);
+		});
+	}
+
+private:
+	std::thread _thread;
+};
+
+// The usual build for MapLoader: osgEarth::initialize(), `create` (which opens the map's layers as
+// it adds them) and the MapNode's terrain engine, each marked in `profile`.
+inline osgEarth::MapNode* buildMapNode(const std::function<osgEarth::MapNode*()>& create, StartupProfile& profile) {
+	osgEarth::initialize();
+
+	profile.mark("osgearth_initialize");
+
+	auto* node = create();
+
+	profile.mark("layers_open");
+
+	node->open();
+
+	profile.mark("map_node");
+
+	return node;
+}
+
+}
@@ -0,0 +1,364 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+#include <osg/DisplaySettings>
+#include <osg/Geometry>
+#include <osg/NodeVisitor>
+#include <osg/Texture2D>
+
+namespace osg_qt6 {
+
+// Bytes one image holds in memory, mipmaps included.
+inline int64_t imageBytes(const osg::Image* image) {
+	return image ? static_cast<int64_t>(image->getTotalSizeInBytesIncludingMipmaps()) : 0;
+}
+
+// Roughly what a texture takes on the GPU: its images plus a third for mipmaps the driver
+// generates or, once those are released, what its texture object was allocated with (RGBA8 if it
+// hasn't been uploaded anywhere yet).
+inline int64_t textureBytes(const osg::Texture* texture) {
+	if(!texture) return 0;
+
+	if(!texture->getNumImages() || !texture->getImage(0)) {
+		for(unsigned int id = 0; id < osg::DisplaySettings::instance()->getMaxNumberOfGraphicsContexts(); id++) {
+			if(const osg::Texture::TextureObject* object = texture->getTextureObject(id)) {
+				return static_cast<int64_t>(object->size());
+			}
+		}
+	}
+
+	int64_t bytes = 0;
+	bool prebuilt = false;
+
+	for(unsigned int i = 0; i < texture->getNumImages(); i++) {
+		if(const osg::Image* image = texture->getImage(i)) {
+			bytes += imageBytes(image);
+			prebuilt = prebuilt || image->isMipmap();
+		}
+	}
+
+	auto* t2d = dynamic_cast<const osg::Texture2D*>(texture);
+
+	if(!bytes && t2d) bytes = static_cast<int64_t>(t2d->getTextureWidth()) * t2d->getTextureHeight() * 4;
+
+	auto filter = texture->getFilter(osg::Texture::MIN_FILTER);
+	bool mipmapped = filter != osg::Texture::LINEAR && filter != osg::Texture::NEAREST;
+
+	return mipmapped && !prebuilt ? bytes * 4 / 3 : bytes;
+}
+
+// One layer's (or any other subsystem's) share of memory, by category. Layers that can track their
+// own bytes cheaply add() and set() as they go; scene-graph layers instead give a measure
+// callback (usually MemoryVisitor) that MemoryLedger runs when it needs fresh numbers.
+//
+// A budget (0 for none) is only a number here: layers with an LRU check overBudget() as they
+// insert and evict until they're under it, and a release callback lets MemoryLedger::enforce()
+// drop CPU-side copies (e.g. of images already uploaded) on top of that.
+class MemoryAccount {
+public:
+	enum Category {
+		TEXTURES,
+		BUFFERS,
+		IMAGES,
+		NODES,
+		CATEGORIES
+	};
+
+	using Totals = std::array<int64_t, CATEGORIES>;
+
+	MemoryAccount(const std::string& name):
+	_name(name) {
+	}
+
+	static const char* categoryName(Category category) {
+		static const char* names[CATEGORIES] = {"textures", "buffers", "images", "nodes"};
+
+		return names[category];
+	}
+
+	const std::string& name() const {
+		return _name;
+	}
+
+	void add(Category category, int64_t bytes) {
+		_bytes[category] += bytes;
+	}
+
+	void set(Category category, int64_t bytes) {
+		_bytes[category] = bytes;
+	}
+
+	void set(const Totals& totals) {
+		for(int c = 0; c < CATEGORIES; c++) _bytes[c] = totals[c];
+	}
+
+	int64_t bytes(Category category) const {
+		return _bytes[category];
+	}
+
+	int64_t total() const {
+		int64_t sum = 0;
+
+		for(const auto& bytes : _bytes) sum += bytes;
+
+		return sum;
+	}
+
+	void setBudget(int64_t bytes) {
+		_budget = std::max<int64_t>(bytes, 0);
+	}
+
+	int64_t budget() const {
+		return _budget;
+	}
+
+	bool overBudget() const {
+		return _budget > 0 && total() > _budget;
+	}
+
+	void setMeasure(std::function<Totals()> measure) {
+		_measure = std::move(measure);
+	}
+
+	void setRelease(std::function<void()> release) {
+		_release = std::move(release);
+	}
+
+	bool measured() const {
+		return static_cast<bool>(_measure);
+	}
+
+	void refresh() {
+		if(_measure) set(_measure());
+	}
+
+	void release() {
+		if(_release) _release();
+	}
+
+	QJsonObject toJson() const {
+		QJsonObject json{{"name", QString::fromStdString(_name)}};
+
+		for(int c = 0; c < CATEGORIES; c++) json[categoryName(static_cast<Category>(c))] = static_cast<qint64>(_bytes[c].load());
+
+		json["total"] = static_cast<qint64>(total());
+		json["budget"] = static_cast<qint64>(_budget.load());
+		json["over_budget"] = overBudget();
+
+		return json;
+	}
+
+private:
+	std::string _name;
+
+	std::array<std::atomic<int64_t>, CATEGORIES> _bytes{};
+	std::atomic<int64_t> _budget = 0;
+
+	std::function<Totals()> _measure;
+	std::function<void()> _release;
+};
+
+// Every live MemoryAccount, and the budgets to give them by name. Accounts belong to whatever
+// opened them; the ledger only watches, and forgets them once they're gone.
+//
+// NOTE: enforce() and toJson() run measure and release callbacks, which touch the scene graph;
+// call them between frames, on the thread that renders.
+class MemoryLedger {
+public:
+	std::shared_ptr<MemoryAccount> open(const std::string& name) {
+		auto account = std::make_shared<MemoryAccount>(name);
+
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		if(auto i = _budgets.find(name); i != _budgets.end()) account->setBudget(i->second);
+
+		_accounts.push_back(account);
+
+		return account;
+	}
+
+	// Applies to every account of that name, open now or later.
+	void setBudget(const std::string& name, int64_t bytes) {
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		_budgets[name] = bytes;
+
+		for(auto& weak : _accounts) if(auto account = weak.lock(); account && account->name() == name) account->setBudget(bytes);
+	}
+
+	std::vector<std::shared_ptr<MemoryAccount>> accounts() {
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		std::vector<std::shared_ptr<MemoryAccount>> live;
+
+		_accounts.erase(std::remove_if(_accounts.begin(), _accounts.end(), [&](const auto& weak) {
+			auto account = weak.lock();
+
+			if(account) live.push_back(account);
+
+			return !account;
+		}), _accounts.end());
+
+		return live;
+	}
+
+	// Re-measures the accounts that have a budget and releases what it can from those over it.
+	void enforce() {
+		for(auto& account : accounts()) {
+			if(!account->budget()) continue;
+
+			account->refresh();
+
+			if(account->overBudget()) {
+				account->release();
+				account->refresh();
+			}
+		}
+	}
+
+	// Every account (freshly measured) and the totals per category.
+	QJsonObject toJson() {
+		QJsonArray list;
+		MemoryAccount::Totals totals{};
+
+		for(auto& account : accounts()) {
+			account->refresh();
+
+			for(int c = 0; c < MemoryAccount::CATEGORIES; c++) totals[c] += account->bytes(static_cast<MemoryAccount::Category>(c));
+
+			list.append(account->toJson());
+		}
+
+		QJsonObject sum;
+		int64_t total = 0;
+
+		for(int c = 0; c < MemoryAccount::CATEGORIES; c++) {
+			sum[MemoryAccount::categoryName(static_cast<MemoryAccount::Category>(c))] = static_cast<qint64>(totals[c]);
+
+			total += totals[c];
+		}
+
+		sum["total"] = static_cast<qint64>(total);
+
+		return {{"accounts", list}, {"totals", sum}};
+	}
+
+	bool dump(const QString& path) {
+		QFile file(path);
+
+		if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) return false;
+
+		return file.write(QJsonDocument(toJson()).toJson(QJsonDocument::Indented)) > 0;
+	}
+
+private:
+	std::mutex _mutex;
+	std::vector<std::weak_ptr<MemoryAccount>> _accounts;
+	std::unordered_map<std::string, int64_t> _budgets;
+};
+
+inline MemoryLedger& memoryLedger() {
+	static MemoryLedger ledger;
+
+	return ledger;
+}
+
+// Measures a subgraph: the textures in its state sets (and the images they still hold), its
+// geometry's arrays and index data (what ends up in VBOs), and a nominal size per node and drawable.
+// Anything shared is only counted once.
+class MemoryVisitor: public osg::NodeVisitor {
+public:
+	MemoryVisitor():
+	osg::NodeVisitor(osg::NodeVisitor::TRAVERSE_ALL_CHILDREN) {
+	}
+
+	static MemoryAccount::Totals measure(osg::Node& node) {
+		MemoryVisitor visitor;
+
+		node.accept(visitor);
+
+		return visitor.totals;
+	}
+
+	void apply(osg::Node& node) override {
+		if(_seen.insert(&node).second) {
+			totals[MemoryAccount::NODES] += sizeof(osg::Group);
+
+			_apply(node.getStateSet());
+		}
+
+		traverse(node);
+	}
+
+	void apply(osg::Drawable& drawable) override {
+		if(!_seen.insert(&drawable).second) return;
+
+		totals[MemoryAccount::NODES] += sizeof(osg::Geometry);
+
+		_apply(drawable.getStateSet());
+
+		auto* geometry = drawable.asGeometry();
+
+		if(!geometry) return;
+
+		_apply(geometry->getVertexArray());
+		_apply(geometry->getNormalArray());
+		_apply(geometry->getColorArray());
+		_apply(geometry->getSecondaryColorArray());
+		_apply(geometry->getFogCoordArray());
+
+		for(const auto& array : geometry->getTexCoordArrayList()) _apply(array.get());
+		for(const auto& array : geometry->getVertexAttribArrayList()) _apply(array.get());
+
+		for(const auto& primitives : geometry->getPrimitiveSetList()) {
+			if(auto* elements = primitives->getDrawElements(); elements && _seen.insert(elements).second) {
+				totals[MemoryAccount::BUFFERS] += elements->getTotalDataSize();
+			}
+		}
+	}
+
+	MemoryAccount::Totals totals{};
+
+private:
+	void _apply(const osg::Array* array) {
+		if(array && _seen.insert(array).second) totals[MemoryAccount::BUFFERS] += array->getTotalDataSize();
+	}
+
+	void _apply(const osg::StateSet* ss) {
+		if(!ss || !_seen.insert(ss).second) return;
+
+		for(const auto& unit : ss->getTextureAttributeList()) for(const auto& attribute : unit) {
+			auto* texture = dynamic_cast<const osg::Texture*>(attribute.second.first.get());
+
+			if(!texture || !_seen.insert(texture).second) continue;
+
+			totals[MemoryAccount::TEXTURES] += textureBytes(texture);
+
+			for(unsigned int i = 0; i < texture->getNumImages(); i++) {
+				if(const osg::Image* image = texture->getImage(i); image && _seen.insert(image).second) {
+					totals[MemoryAccount::IMAGES] += imageBytes(image);
+				}
+			}
+		}
+	}
+
+	std::unordered_set<const void*> _seen;
+};
+
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <osgDB/ReadFile>
+
+#include <osgEarth/ImageLayer>
+
+#include "osg-qt6/memory-ledger.hpp"
+#include "osg-qt6/texture-compression.hpp"
+
+class MyTextureLayer: public osgEarth::ImageLayer {
+public:
+	META_Layer(osgEarth, MyTextureLayer, Options, ImageLayer, mytexturelayer);
+
+	void setPath(const std::string& path) {
+		_path = path.c_str();
+	}
+
+	// Uploads the image block compressed, with prebuilt mipmaps, from a DDS copy kept in
+	// `cacheDir` (made on the first open).
+	void setCompressedCache(const std::string& cacheDir) {
+		_compressedCache = cacheDir;
+	}
+
+	virtual osgEarth::Status openImplementation() {
+		osg::ref_ptr<osg::Image> image = _compressedCache.empty() ?
+			osgDB::readRefImageFile(_path) :
+			osg_qt6::readImageCompressed(_path, _compressedCache)
+		;
+
+		if(image.valid()) _tex = new Texture(image.get());
+
+		else return osgEarth::Status(osgEarth::Status::ConfigurationError, "no path");
+
+		_account = osg_qt6::memoryLedger().open(getName().empty() ? "MyTextureLayer" : getName());
+		_account->set(osg_qt6::MemoryAccount::TEXTURES, osg_qt6::textureBytes(_tex.get()));
+		_account->set(osg_qt6::MemoryAccount::IMAGES, osg_qt6::imageBytes(image.get()));
+
+		// NOTE: Over budget, the CPU copy of the image goes once every context has it; the texture
+		// then can't be re-uploaded (e.g. into a new context), which is the trade a budget asks for.
+		osg::observer_ptr<Texture> texture = _tex;
+		auto* account = _account.get();
+
+		_account->setRelease([texture, account]() {
+			osg::ref_ptr<Texture> tex;
+
+			if(!texture.lock(tex) || !tex->getImage() || !tex->areAllTextureObjectsLoaded()) return;
+
+			account->add(osg_qt6::MemoryAccount::IMAGES, -osg_qt6::imageBytes(tex->getImage()));
+
+			tex->releaseImage();
+
+			account->set(osg_qt6::MemoryAccount::TEXTURES, osg_qt6::textureBytes(tex.get()));
+		});
+
+		setProfile(osgEarth::Profile::create(osgEarth::Profile::GLOBAL_GEODETIC));
+		setUseCreateTexture();
+		addDataExtent(osgEarth::DataExtent(getProfile()->getExtent(), 0, 0));
+
+		return osgEarth::Status::OK();
+	}
+
+	virtual osgEarth::TextureWindow createTexture(
+		const osgEarth::TileKey& key,
+		osgEarth::ProgressCallback* progress
+	) const {
+		osg::Matrixf textureMatrix;
+
+		key.getExtent().createScaleBias(getProfile()->getExtent(), textureMatrix);
+
+		return osgEarth::TextureWindow(_tex.get(), textureMatrix);
+	}
+
+protected:
+	// NOTE: Texture2D::setImage() dirties the texture, i.e. deletes what's already uploaded. This
+	// drops the image the way setUnRefImageDataAfterApply() does after a load instead, leaving the
+	// texture objects alone.
+	struct Texture: public osg::Texture2D {
+		using osg::Texture2D::Texture2D;
+
+		void releaseImage() {
+			_image = nullptr;
+		}
+	};
+
+	std::string _path;
+	std::string _compressedCache;
+	osg::ref_ptr<Texture> _tex;
+
+	std::shared_ptr<osg_qt6::MemoryAccount> _account;
+};
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <memory>
+
+#include <QOffscreenSurface>
+#include <QOpenGLContext>
+#include <QOpenGLFunctions>
+#include <QOpenGLFramebufferObject>
+#include <QImage>
+
+#include <osgViewer/Viewer>
+
+#include "osg-qt6/trace.hpp"
+
+namespace osg_qt6 {
+
+// The headless equivalent of the examples' OSGWidget: a QOffscreenSurface, a (compatibility
+// profile) QOpenGLContext made current on the calling thread, and an FBO that osgViewer treats as
+// its "default" framebuffer. Under `QT_QPA_PLATFORM=offscreen` this runs without a display; set
+// `LIBGL_ALWAYS_SOFTWARE=1` (or `GALLIUM_DRIVER=llvmpipe`) to pin Mesa's llvmpipe.
+class OffscreenViewer {
+public:
+	OffscreenViewer(int width, int height, int samples=0):
+	_width(width),
+	_height(height) {
+		QSurfaceFormat format;
+
+		format.setRenderableType(QSurfaceFormat::OpenGL);
+		format.setProfile(QSurfaceFormat::CompatibilityProfile);
+		format.setDepthBufferSize(24);
+		format.setStencilBufferSize(8);
+
+		_surface = std::make_unique<QOffscreenSurface>();
+		_surface->setFormat(format);
+		_surface->create();
+
+		_context = std::make_unique<QOpenGLContext>();
+		_context->setFormat(format);
+
+		if(!_context->create() || !_context->makeCurrent(_surface.get())) return;
+
+		QOpenGLFramebufferObjectFormat fboFormat;
+
+		fboFormat.setAttachment(QOpenGLFramebufferObject::CombinedDepthStencil);
+		fboFormat.setSamples(samples);
+
+		_fbo = std::make_unique<QOpenGLFramebufferObject>(width, height, fboFormat);
+
+		_viewer = new osgViewer::Viewer();
+		_gw = _viewer->setUpViewerAsEmbeddedInWindow(0, 0, width, height);
+
+		_viewer->getCamera()->setViewport(new osg::Viewport(0, 0, width, height));
+		_viewer->getCamera()->setProjectionMatrixAsPerspective(30.0f, static_cast<double>(width) / height, 1.0, 1000.0);
+	}
+
+	~OffscreenViewer() {
+		if(!_context || !_context->makeCurrent(_surface.get())) return;
+
+		_viewer = nullptr;
+		_fbo.reset();
+
+		_context->doneCurrent();
+	}
+
+	bool valid() const {
+		return _fbo && _fbo->isValid();
+	}
+
+	// NOTE: An explicit `time` drives the viewer on a simulated clock (see trace::pacedAdvance()).
+	void frame(double time=USE_REFERENCE_TIME) {
+		_fbo->bind();
+
+		_gw->setDefaultFboId(_fbo->handle());
+
+		trace::frame(_viewer.get(), time);
+	}
+
+	// Blocks until the GPU has actually finished everything submitted so far.
+	void finish() {
+		_context->functions()->glFinish();
+	}
+
+	QImage grab() {
+		return _fbo->toImage();
+	}
+
+	QString renderer() {
+		auto* gl = _context->functions();
+
+		return QString::fromLatin1(reinterpret_cast<const char*>(gl->glGetString(GL_RENDERER)));
+	}
+
+	osgViewer::Viewer* viewer() const {
+		return _viewer.get();
+	}
+
+	osgViewer::GraphicsWindowEmbedded* graphicsWindow() const {
+		return _gw;
+	}
+
+	QOpenGLContext* context() const {
+		return _context.get();
+	}
+
+	QOpenGLFramebufferObject* fbo() const {
+		return _fbo.get();
+	}
+
+	int width() const {
+		return _width;
+	}
+
+	int height() const {
+		return _height;
+	}
+
+private:
+	int _width = 0;
+	int _height = 0;
+
+	std::unique_ptr<QOffscreenSurface> _surface;
+	std::unique_ptr<QOpenGLContext> _context;
+	std::unique_ptr<QOpenGLFramebufferObject> _fbo;
+
+	osg::ref_ptr<osgViewer::Viewer> _viewer;
+	osgViewer::GraphicsWindowEmbedded* _gw = nullptr;
+};
+
+}
@@ -0,0 +1,432 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <osg/BlendFunc>
+#include <osg/MatrixTransform>
+#include <osg/Geometry>
+#include <osg/Program>
+#include <osg/PointSprite>
+#include <osg/Texture2D>
+#include <osgDB/ReadFile>
+
+#include <osgEarth/GeoData>
+#include <osgEarth/SpatialReference>
+#include <osgEarth/ImageUtils>
+
+#include "osg-qt6/geodetic.hpp"
+#include "osg-qt6/memory-ledger.hpp"
+
+namespace osg_qt6 {
+
+// Every icon any PlacemarkLayer uses, packed into one fixed grid of equally-sized cells in a single
+// RGBA texture (so the whole layer binds exactly one texture).
+class IconAtlas: public osg::Referenced {
+public:
+	IconAtlas(unsigned int cellSize=64, unsigned int columns=16):
+	_cellSize(cellSize),
+	_columns(columns) {
+		_image = new osg::Image();
+		_image->allocateImage(cellSize * columns, cellSize * columns, 1, GL_RGBA, GL_UNSIGNED_BYTE);
+
+		std::memset(_image->data(), 0, _image->getTotalSizeInBytes());
+
+		_texture = new osg::Texture2D(_image.get());
+		_texture->setFilter(osg::Texture::MIN_FILTER, osg::Texture::LINEAR);
+		_texture->setFilter(osg::Texture::MAG_FILTER, osg::Texture::LINEAR);
+		_texture->setWrap(osg::Texture::WRAP_S, osg::Texture::CLAMP_TO_EDGE);
+		_texture->setWrap(osg::Texture::WRAP_T, osg::Texture::CLAMP_TO_EDGE);
+		_texture->setResizeNonPowerOfTwoHint(false);
+	}
+
+	// Returns the cell for `path`, loading and packing it on first use; -1 if it can't be loaded or
+	// the atlas is full.
+	int add(const std::string& path) {
+		if(auto i = _cells.find(path); i != _cells.end()) return i->second;
+
+		if(_next >= _columns * _columns) return -1;
+
+		osg::ref_ptr<osg::Image> src = osgDB::readRefImageFile(path);
+
+		if(!src.valid()) return -1;
+
+		osg::ref_ptr<osg::Image> rgba = osgEarth::ImageUtils::convertToRGBA8(src.get());
+		osg::ref_ptr<osg::Image> cell;
+
+		if(!rgba.valid() || !osgEarth::ImageUtils::resizeImage(rgba.get(), _cellSize, _cellSize, cell)) return -1;
+
+		int index = static_cast<int>(_next++);
+		unsigned int cx = (index % _columns) * _cellSize;
+		unsigned int cy = (index / _columns) * _cellSize;
+
+		for(unsigned int row = 0; row < _cellSize; row++) std::memcpy(
+			_image->data(cx, cy + row),
+			cell->data(0, row),
+			_cellSize * 4
+		);
+
+		_image->dirty();
+
+		_cells[path] = index;
+
+		return index;
+	}
+
+	// Atlas origin (xy) and cell extent (z) in texture coordinates.
+	osg::Vec3 uv(int index) const {
+		float du = 1.0f / static_cast<float>(_columns);
+
+		return osg::Vec3(
+			static_cast<float>(index % _columns) * du,
+			static_cast<float>(index / _columns) * du,
+			du
+		);
+	}
+
+	osg::Texture2D* texture() const {
+		return _texture.get();
+	}
+
+private:
+	unsigned int _cellSize = 64;
+	unsigned int _columns = 16;
+	unsigned int _next = 0;
+
+	osg::ref_ptr<osg::Image> _image;
+	osg::ref_ptr<osg::Texture2D> _texture;
+
+	std::unordered_map<std::string, int> _cells;
+};
+
+// Draws any number of icon placemarks as point sprites out of ONE packed vertex buffer, with ONE
+// state set and ONE draw call, sampling ONE shared IconAtlas. Compare to a PlaceNode per point, which
+// is a node, a state set and a draw per placemark. Add, move and remove are O(1) by id (removal
+// swaps the last point into the hole).
+//
+// NOTE: Icons only; labels are not drawn here.
+class PlacemarkLayer: public osg::MatrixTransform {
+public:
+	using id_t = std::uint64_t;
+
+	static constexpr unsigned int ICON_ATTRIBUTE = 6;
+
+	PlacemarkLayer(IconAtlas* atlas=new IconAtlas()):
+	_atlas(atlas) {
+		_positions = new osg::Vec3Array();
+		_colors = new osg::Vec4Array();
+		_icons = new osg::Vec4Array();
+		_draw = new osg::DrawArrays(GL_POINTS, 0, 0);
+
+		_geometry = new osg::Geometry();
+		_geometry->setUseDisplayList(false);
+		_geometry->setUseVertexBufferObjects(true);
+		_geometry->setDataVariance(osg::Object::DYNAMIC);
+		_geometry->setVertexArray(_positions.get());
+		_geometry->setColorArray(_colors.get(), osg::Array::BIND_PER_VERTEX);
+		_geometry->setVertexAttribArray(ICON_ATTRIBUTE, _icons.get(), osg::Array::BIND_PER_VERTEX);
+		_geometry->addPrimitiveSet(_draw.get());
+
+		addChild(_geometry.get());
+
+		_createStateSet();
+
+		_account = memoryLedger().open("PlacemarkLayer");
+		_account->setMeasure([this]() {
+			return MemoryVisitor::measure(*this);
+		});
+	}
+
+	void setDefaultIcon(const std::string& path, float size=64.0f) {
+		_defaultIcon = path;
+		_defaultSize = size;
+	}
+
+	id_t add(
+		const osgEarth::GeoPoint& gp,
+		const std::string& icon="",
+		float size=0.0f,
+		const osg::Vec4& color=osg::Vec4(1.0f, 1.0f, 1.0f, 1.0f)
+	) {
+		osg::Vec3d world;
+
+		if(!gp.toWorld(world)) return 0;
+
+		// NOTE: Vertices are floats relative to the first point, so precision stays at the meter
+		// level across the whole globe instead of degrading with the magnitude of ECEF coordinates.
+		if(_positions->empty()) setMatrix(osg::Matrix::translate(world));
+
+		int cell = _atlas->add(icon.empty() ? _defaultIcon : icon);
+		osg::Vec3 uv = _atlas->uv(std::max(cell, 0));
+
+		id_t id = ++_nextId;
+
+		_indices[id] = _positions->size();
+		_ids.push_back(id);
+
+		_positions->push_back(_local(world));
+		_colors->push_back(cell < 0 ? osg::Vec4() : color);
+		_icons->push_back(osg::Vec4(uv, size > 0.0f ? size : _defaultSize));
+
+		_dirty();
+
+		return id;
+	}
+
+	bool move(id_t id, const osgEarth::GeoPoint& gp) {
+		auto i = _indices.find(id);
+		osg::Vec3d world;
+
+		if(i == _indices.end() || !gp.toWorld(world)) return false;
+
+		(*_positions)[i->second] = _local(world);
+
+		_positions->dirty();
+		_geometry->dirtyBound();
+
+		return true;
+	}
+
+	// Moves `count` placemarks at once to WGS84 lon/lat/alt (degrees, degrees, meters), converted
+	// in batches by geodeticToEcef() instead of a GeoPoint each; for geocentric WGS84 maps (like the
+	// examples'). Returns how many of the ids were found.
+	size_t move(const id_t* ids, const double* lon, const double* lat, const double* alt, size_t count) {
+		constexpr size_t BATCH = 1024;
+
+		double x[BATCH];
+		double y[BATCH];
+		double z[BATCH];
+
+		osg::Vec3d origin = getMatrix().getTrans();
+		size_t moved = 0;
+
+		for(size_t begin = 0; begin < count; begin += BATCH) {
+			size_t n = std::min(BATCH, count - begin);
+
+			osg_qt6::geodeticToEcef(lon + begin, lat + begin, alt + begin, x, y, z, n);
+
+			for(size_t i = 0; i < n; i++) {
+				auto found = _indices.find(ids[begin + i]);
+
+				if(found == _indices.end()) continue;
+
+				(*_positions)[found->second] = osg::Vec3(osg::Vec3d(x[i], y[i], z[i]) - origin);
+
+				moved++;
+			}
+		}
+
+		if(moved) {
+			_positions->dirty();
+			_geometry->dirtyBound();
+		}
+
+		return moved;
+	}
+
+	bool setColor(id_t id, const osg::Vec4& color) {
+		auto i = _indices.find(id);
+
+		if(i == _indices.end()) return false;
+
+		(*_colors)[i->second] = color;
+
+		_colors->dirty();
+
+		return true;
+	}
+
+	bool remove(id_t id) {
+		auto i = _indices.find(id);
+
+		if(i == _indices.end()) return false;
+
+		size_t hole = i->second;
+		size_t last = _positions->size() - 1;
+
+		if(hole != last) {
+			(*_positions)[hole] = (*_positions)[last];
+			(*_colors)[hole] = (*_colors)[last];
+			(*_icons)[hole] = (*_icons)[last];
+
+			_ids[hole] = _ids[last];
+			_indices[_ids[hole]] = hole;
+		}
+
+		_positions->pop_back();
+		_colors->pop_back();
+		_icons->pop_back();
+		_ids.pop_back();
+		_indices.erase(i);
+
+		_dirty();
+
+		return true;
+	}
+
+	size_t size() const {
+		return _ids.size();
+	}
+
+	IconAtlas* atlas() const {
+		return _atlas.get();
+	}
+
+protected:
+	osg::Vec3 _local(const osg::Vec3d& world) const {
+		return osg::Vec3(world - getMatrix().getTrans());
+	}
+
+	void _dirty() {
+		_draw->setCount(static_cast<GLsizei>(_positions->size()));
+		_draw->dirty();
+
+		_positions->dirty();
+		_colors->dirty();
+		_icons->dirty();
+
+		_geometry->dirtyBound();
+	}
+
+	void _createStateSet() {
+		static const char* vertexSource =
+			"#version 120\n"
+			"attribute vec4 osg_qt6_icon;\n"
+			"varying vec3 vIcon;\n"
+			"varying vec4 vColor;\n"
+			"void main() {\n"
+			"	vIcon = osg_qt6_icon.xyz;\n"
+			"	vColor = gl_Color;\n"
+			"	gl_Position = gl_ModelViewProjectionMatrix * gl_Vertex;\n"
+			// Pull the sprite slightly toward the eye so it doesn't z-fight the terrain it sits on.
+			"	gl_Position.z -= 1.0e-4 * gl_Position.w;\n"
+			"	gl_PointSize = osg_qt6_icon.w;\n"
+			"}\n"
+		;
+
+		static const char* fragmentSource =
+			"#version 120\n"
+			"uniform sampler2D osg_qt6_atlas;\n"
+			"varying vec3 vIcon;\n"
+			"varying vec4 vColor;\n"
+			"void main() {\n"
+			"	vec2 uv = vIcon.xy + vec2(gl_PointCoord.x, 1.0 - gl_PointCoord.y) * vIcon.z;\n"
+			"	vec4 c = texture2D(osg_qt6_atlas, uv) * vColor;\n"
+			"	if(c.a < 0.05) discard;\n"
+			"	gl_FragColor = c;\n"
+			"}\n"
+		;
+
+		osg::Program* program = new osg::Program();
+
+		program->addShader(new osg::Shader(osg::Shader::VERTEX, vertexSource));
+		program->addShader(new osg::Shader(osg::Shader::FRAGMENT, fragmentSource));
+		program->addBindAttribLocation("osg_qt6_icon", ICON_ATTRIBUTE);
+
+		osg::StateSet* ss = getOrCreateStateSet();
+
+		ss->setAttributeAndModes(program, osg::StateAttribute::ON);
+		ss->setTextureAttributeAndModes(0, _atlas->texture(), osg::StateAttribute::ON);
+		ss->setTextureAttributeAndModes(0, new osg::PointSprite(), osg::StateAttribute::ON);
+		ss->addUniform(new osg::Uniform("osg_qt6_atlas", 0));
+		ss->setMode(GL_VERTEX_PROGRAM_POINT_SIZE, osg::StateAttribute::ON);
+		ss->setAttributeAndModes(
+			new osg::BlendFunc(osg::BlendFunc::SRC_ALPHA, osg::BlendFunc::ONE_MINUS_SRC_ALPHA),
+			osg::StateAttribute::ON
+		);
+		ss->setMode(GL_LIGHTING, osg::StateAttribute::OFF | osg::StateAttribute::PROTECTED);
+		ss->setRenderingHint(osg::StateSet::TRANSPARENT_BIN);
+	}
+
+	osg::ref_ptr<IconAtlas> _atlas;
+
+	osg::ref_ptr<osg::Geometry> _geometry;
+	osg::ref_ptr<osg::Vec3Array> _positions;
+	osg::ref_ptr<osg::Vec4Array> _colors;
+	osg::ref_ptr<osg::Vec4Array> _icons;
+	osg::ref_ptr<osg::DrawArrays> _draw;
+
+	std::unordered_map<id_t, size_t> _indices;
+	std::vector<id_t> _ids;
+
+	id_t _nextId = 0;
+
+	std::shared_ptr<MemoryAccount> _account;
+
+	std::string _defaultIcon = "../blackdot.png";
+	// NOTE: The same 128px blackdot.png at 0.5 scale the PlaceNode version used.
+	float _defaultSize = 64.0f;
+};
+
+// Keeps a PlacemarkLayer's placemarks across sessions: one "lon lat alt" line per placemark (in
+// the map's geographic SRS), appended as they're added.
+class PlacemarkFile {
+public:
+	PlacemarkFile(const std::string& path=""):
+	_path(path) {
+	}
+
+	bool valid() const {
+		return !_path.empty();
+	}
+
+	// Adds every saved placemark to `layer` (and calls `added` with each); returns how many there
+	// were.
+	size_t load(
+		PlacemarkLayer* layer,
+		const osgEarth::SpatialReference* srs,
+		const std::function<void(const osgEarth::GeoPoint& gp)>& added={}
+	) const {
+		std::FILE* f = valid() ? std::fopen(_path.c_str(), "r") : nullptr;
+
+		if(!f) return 0;
+
+		const auto* geo = srs->getGeographicSRS();
+
+		char line[256];
+		size_t count = 0;
+
+		while(std::fgets(line, sizeof(line), f)) {
+			double lon, lat, alt;
+
+			if(std::sscanf(line, "%lf %lf %lf", &lon, &lat, &alt) != 3) continue;
+
+			osgEarth::GeoPoint gp(geo, lon, lat, alt, osgEarth::ALTMODE_ABSOLUTE);
+
+			if(!layer->add(gp)) continue;
+
+			if(added) added(gp);
+
+			count++;
+		}
+
+		std::fclose(f);
+
+		return count;
+	}
+
+	bool append(const osgEarth::GeoPoint& gp) const {
+		osgEarth::GeoPoint geo = gp.transform(gp.getSRS()->getGeographicSRS());
+
+		std::FILE* f = valid() && geo.isValid() ? std::fopen(_path.c_str(), "a") : nullptr;
+
+		if(!f) return false;
+
+		std::fprintf(f, "%.9f %.9f %.3f\n", geo.x(), geo.y(), geo.z());
+		std::fclose(f);
+
+		return true;
+	}
+
+private:
+	std::string _path;
+};
+
+}
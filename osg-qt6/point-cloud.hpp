@@ -0,0 +1,586 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <QFile>
+
+#include <osg/Geometry>
+#include <osg/MatrixTransform>
+#include <osg/Point>
+#include <osgUtil/CullVisitor>
+
+namespace osg_qt6 {
+
+// The on-disk format (".opc") tool-pointcloud writes and PointCloudNode maps: a header, an octree
+// of node records in depth-first order, then every point, grouped so each node's points are
+// contiguous. Each node holds a random subsample of everything under it (up to the converter's
+// `nodePoints`) and its children hold the rest, so any cut through the tree draws a uniformly
+// thinned cloud; parents and children are drawn together, never instead of each other.
+//
+// Positions are floats relative to `origin` (in doubles), like PlacemarkLayer's.
+struct PointCloudHeader {
+	char magic[8];
+
+	std::uint32_t version;
+	std::uint32_t nodeCount;
+	std::uint64_t pointCount;
+
+	double origin[3];
+};
+
+struct PointCloudNodeRecord {
+	float min[3];
+	float max[3];
+	// Average distance between this node's points; its error when drawn without its children.
+	float spacing;
+
+	std::uint32_t count;
+	std::uint64_t offset;
+
+	std::int32_t children[8];
+};
+
+struct PointCloudPoint {
+	float x;
+	float y;
+	float z;
+
+	std::uint8_t r;
+	std::uint8_t g;
+	std::uint8_t b;
+	std::uint8_t a;
+};
+
+static_assert(sizeof(PointCloudHeader) == 48);
+static_assert(sizeof(PointCloudNodeRecord) == 72);
+static_assert(sizeof(PointCloudPoint) == 16);
+
+constexpr char POINT_CLOUD_MAGIC[8] = {'O', 'Q', '6', 'P', 'C', 0, 0, 0};
+constexpr std::uint32_t POINT_CLOUD_VERSION = 1;
+
+// Reorders `points` into octree order and writes the whole .opc file; returns false on I/O errors.
+// `points` are already relative to `origin`.
+//
+// NOTE: This works in memory (16 bytes per point), which is fine for the converter up to a few
+// hundred million points; only the viewer side is out-of-core.
+inline bool writePointCloud(
+	const std::string& path,
+	std::vector<PointCloudPoint>& points,
+	const osg::Vec3d& origin,
+	std::uint32_t nodePoints=16384
+) {
+	static constexpr int MAX_DEPTH = 24;
+
+	// A random order up front means the first `nodePoints` of any range are a uniform subsample.
+	std::shuffle(points.begin(), points.end(), std::mt19937(1234));
+
+	std::vector<PointCloudNodeRecord> records;
+
+	std::function<std::int32_t(size_t, size_t, osg::Vec3f, osg::Vec3f, int)> build = [&](
+		size_t begin,
+		size_t end,
+		osg::Vec3f min,
+		osg::Vec3f max,
+		int depth
+	) {
+		auto index = static_cast<std::int32_t>(records.size());
+
+		records.emplace_back();
+
+		PointCloudNodeRecord record = {};
+
+		size_t count = depth < MAX_DEPTH ? std::min<size_t>(nodePoints, end - begin) : end - begin;
+
+		for(int i = 0; i < 3; i++) {
+			record.min[i] = min[i];
+			record.max[i] = max[i];
+		}
+
+		record.spacing = (max - min).length() / std::sqrt(static_cast<float>(std::max<size_t>(count, 1)));
+		record.count = static_cast<std::uint32_t>(count);
+		record.offset = begin;
+
+		std::fill(std::begin(record.children), std::end(record.children), -1);
+
+		osg::Vec3f c = (min + max) * 0.5f;
+
+		// Split what's left into octants (x, then y, then z); octant bit 0 is +x, 1 is +y, 2 is +z.
+		std::array<size_t, 9> bounds;
+
+		bounds[0] = begin + count;
+		bounds[8] = end;
+
+		auto split = [&](size_t b, size_t e, int axis) {
+			return static_cast<size_t>(std::partition(
+				points.begin() + b,
+				points.begin() + e,
+				[&](const PointCloudPoint& p) { return (&p.x)[axis] < c[axis]; }
+			) - points.begin());
+		};
+
+		bounds[4] = split(bounds[0], bounds[8], 0);
+
+		for(int x = 0; x < 2; x++) {
+			bounds[x * 4 + 2] = split(bounds[x * 4], bounds[x * 4 + 4], 1);
+
+			for(int y = 0; y < 2; y++) bounds[x * 4 + y * 2 + 1] = split(
+				bounds[x * 4 + y * 2],
+				bounds[x * 4 + y * 2 + 2],
+				2
+			);
+		}
+
+		for(int x = 0; x < 2; x++) for(int y = 0; y < 2; y++) for(int z = 0; z < 2; z++) {
+			int slot = x * 4 + y * 2 + z;
+
+			if(bounds[slot] == bounds[slot + 1]) continue;
+
+			osg::Vec3f cmin(x ? c.x() : min.x(), y ? c.y() : min.y(), z ? c.z() : min.z());
+			osg::Vec3f cmax(x ? max.x() : c.x(), y ? max.y() : c.y(), z ? max.z() : c.z());
+
+			record.children[x | (y << 1) | (z << 2)] = build(bounds[slot], bounds[slot + 1], cmin, cmax, depth + 1);
+		}
+
+		records[index] = record;
+
+		return index;
+	};
+
+	osg::BoundingBoxf box;
+
+	for(const auto& p : points) box.expandBy(p.x, p.y, p.z);
+
+	if(!points.empty()) build(0, points.size(), box._min, box._max, 0);
+
+	std::ofstream out(path, std::ios::binary);
+
+	if(!out) return false;
+
+	PointCloudHeader header = {};
+
+	std::memcpy(header.magic, POINT_CLOUD_MAGIC, sizeof(header.magic));
+
+	header.version = POINT_CLOUD_VERSION;
+	header.nodeCount = static_cast<std::uint32_t>(records.size());
+	header.pointCount = points.size();
+	header.origin[0] = origin.x();
+	header.origin[1] = origin.y();
+	header.origin[2] = origin.z();
+
+	out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	out.write(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(PointCloudNodeRecord));
+	out.write(reinterpret_cast<const char*>(points.data()), points.size() * sizeof(PointCloudPoint));
+
+	return static_cast<bool>(out);
+}
+
+// A synthetic "lidar" tile for testing without data: rolling terrain over a square `size` meters
+// across, colored by height.
+inline std::vector<PointCloudPoint> createSyntheticPoints(size_t count, float size=2000.0f, unsigned int seed=1234) {
+	std::mt19937 rng(seed);
+	std::uniform_real_distribution<float> pos(0.0f, size);
+	std::normal_distribution<float> noise(0.0f, 0.05f);
+
+	std::vector<PointCloudPoint> points(count);
+
+	for(auto& p : points) {
+		p.x = pos(rng);
+		p.y = pos(rng);
+		p.z = 40.0f * std::sin(p.x * 0.01f) * std::cos(p.y * 0.013f) + 10.0f * std::sin(p.x * 0.05f) + noise(rng);
+
+		float t = std::clamp((p.z + 50.0f) / 100.0f, 0.0f, 1.0f);
+
+		p.r = static_cast<std::uint8_t>(255.0f * t);
+		p.g = static_cast<std::uint8_t>(255.0f * (1.0f - std::abs(t - 0.5f) * 2.0f));
+		p.b = static_cast<std::uint8_t>(255.0f * (1.0f - t));
+		p.a = 255;
+	}
+
+	return points;
+}
+
+// Draws a memory-mapped .opc file of any size. Every cull walks the octree, refining wherever a
+// node's point spacing projects to more than `maxError` pixels; selected nodes that aren't resident
+// yet are queued (most visible error first) for worker threads, which copy them out of the mapping
+// into VBO-backed geometry. The cull thread only ever picks up finished geometry, so the frame
+// never waits on disk or decoding. Resident nodes are kept under `budgetBytes` of vertex data,
+// evicting the least recently drawn first, and refinement stops at whatever fits.
+//
+// Coordinates: the node's matrix is the file's origin; the points are floats relative to it.
+class PointCloudNode: public osg::MatrixTransform {
+public:
+	PointCloudNode(
+		const QString& path,
+		size_t budgetBytes=size_t(512) << 20,
+		float maxError=2.0f,
+		unsigned int threads=0
+	):
+	_file(path),
+	_budgetBytes(budgetBytes),
+	_maxError(maxError) {
+		if(!_file.open(QIODevice::ReadOnly)) return;
+
+		auto size = static_cast<size_t>(_file.size());
+
+		if(size < sizeof(PointCloudHeader)) return;
+
+		_data = _file.map(0, _file.size());
+
+		if(!_data) return;
+
+		_header = reinterpret_cast<const PointCloudHeader*>(_data);
+
+		if(
+			std::memcmp(_header->magic, POINT_CLOUD_MAGIC, sizeof(POINT_CLOUD_MAGIC)) != 0 ||
+			_header->version != POINT_CLOUD_VERSION ||
+			size < sizeof(PointCloudHeader) +
+				_header->nodeCount * sizeof(PointCloudNodeRecord) +
+				_header->pointCount * sizeof(PointCloudPoint)
+		) {
+			_header = nullptr;
+
+			return;
+		}
+
+		_nodes = reinterpret_cast<const PointCloudNodeRecord*>(_data + sizeof(PointCloudHeader));
+		_points = reinterpret_cast<const PointCloudPoint*>(_nodes + _header->nodeCount);
+
+		setMatrix(osg::Matrix::translate(_header->origin[0], _header->origin[1], _header->origin[2]));
+
+		osg::StateSet* ss = getOrCreateStateSet();
+
+		ss->setAttribute(new osg::Point(2.0f), osg::StateAttribute::ON);
+		ss->setMode(GL_LIGHTING, osg::StateAttribute::OFF);
+
+		if(!threads) threads = std::max(2u, std::thread::hardware_concurrency() / 2);
+
+		for(unsigned int i = 0; i < threads; i++) _workers.emplace_back([this]() {
+			_work();
+		});
+	}
+
+	~PointCloudNode() override {
+		{
+			std::lock_guard<std::mutex> lock(_queueMutex);
+
+			_quit = true;
+		}
+
+		_queueCondition.notify_all();
+
+		for(auto& worker : _workers) worker.join();
+	}
+
+	bool valid() const {
+		return _header != nullptr;
+	}
+
+	// Called (on a worker thread) whenever another node becomes drawable, so an on-demand viewer
+	// knows to render again.
+	void setLoadedCallback(std::function<void()> callback) {
+		_loaded = std::move(callback);
+	}
+
+	void setPointSize(float size) {
+		getOrCreateStateSet()->setAttribute(new osg::Point(size), osg::StateAttribute::ON);
+	}
+
+	void setMaxError(float pixels) {
+		_maxError = pixels;
+	}
+
+	std::uint64_t totalPoints() const {
+		return valid() ? _header->pointCount : 0;
+	}
+
+	// As of the last cull: points drawn, and selected nodes not drawn yet for want of data.
+	size_t drawnPoints() const {
+		return _drawnPoints;
+	}
+
+	size_t missingNodes() const {
+		return _missingNodes;
+	}
+
+	size_t residentBytes() const {
+		return _residentBytes;
+	}
+
+	size_t residentNodes() const {
+		return _resident.size();
+	}
+
+	size_t pendingLoads() const {
+		std::lock_guard<std::mutex> lock(_queueMutex);
+
+		return _queue.size() + _inFlight.size();
+	}
+
+	// Settled: everything the last cull wanted is drawn, and nothing is in flight.
+	bool idle() const {
+		return _missingNodes == 0 && pendingLoads() == 0;
+	}
+
+	osg::BoundingSphere computeBound() const override {
+		if(!valid()) return osg::BoundingSphere();
+
+		osg::BoundingSphere bs(_box(0));
+
+		bs.center() = bs.center() * getMatrix();
+
+		return bs;
+	}
+
+	void traverse(osg::NodeVisitor& nv) override {
+		if(!valid()) return;
+
+		if(auto* cv = nv.asCullVisitor()) _cull(cv);
+	}
+
+protected:
+	static constexpr size_t BYTES_PER_POINT = sizeof(osg::Vec3f) + sizeof(osg::Vec4ub);
+
+	struct Resident {
+		osg::ref_ptr<osg::Geometry> geometry;
+
+		unsigned int lastUsed = 0;
+	};
+
+	struct Request {
+		std::int32_t node;
+
+		float priority;
+	};
+
+	osg::BoundingBox _box(std::int32_t node) const {
+		const auto& r = _nodes[node];
+
+		return osg::BoundingBox(r.min[0], r.min[1], r.min[2], r.max[0], r.max[1], r.max[2]);
+	}
+
+	void _cull(osgUtil::CullVisitor* cv) {
+		unsigned int frame = cv->getFrameStamp() ? cv->getFrameStamp()->getFrameNumber() : 0;
+
+		_integrate(frame);
+
+		std::vector<Request> wanted;
+		std::vector<std::int32_t> stack = {0};
+
+		// Bytes the non-resident children accepted so far this cull will take once loaded.
+		size_t reserved = 0;
+
+		_drawnPoints = 0;
+		_missingNodes = 0;
+
+		while(!stack.empty()) {
+			std::int32_t node = stack.back();
+
+			stack.pop_back();
+
+			osg::BoundingSphere bs(_box(node));
+
+			if(cv->isCulled(bs)) continue;
+
+			const auto& record = _nodes[node];
+			float error = cv->pixelSize(bs.center(), record.spacing);
+			auto i = _resident.find(node);
+
+			if(i == _resident.end()) {
+				wanted.push_back({node, error});
+
+				_missingNodes++;
+
+				continue;
+			}
+
+			i->second.lastUsed = frame;
+			i->second.geometry->accept(*cv);
+
+			_drawnPoints += record.count;
+
+			if(error <= _maxError) continue;
+
+			for(auto child : record.children) if(child >= 0) {
+				if(_resident.count(child)) {
+					stack.push_back(child);
+
+					continue;
+				}
+
+				size_t bytes = _nodes[child].count * BYTES_PER_POINT;
+
+				if(!_evict(frame, reserved + bytes)) continue;
+
+				reserved += bytes;
+
+				stack.push_back(child);
+			}
+		}
+
+		std::sort(wanted.begin(), wanted.end(), [](const Request& a, const Request& b) {
+			return a.priority < b.priority;
+		});
+
+		// The queue is rebuilt every cull (highest priority last), so nodes that scrolled out of
+		// view are simply never loaded.
+		{
+			std::lock_guard<std::mutex> lock(_queueMutex);
+
+			_queue.clear();
+
+			for(const auto& r : wanted) if(!_inFlight.count(r.node)) _queue.push_back(r);
+		}
+
+		_queueCondition.notify_all();
+	}
+
+	// Makes room for `bytes` by dropping nodes not drawn in the last couple of frames, least
+	// recently drawn first; false if even that isn't enough.
+	bool _evict(unsigned int frame, size_t bytes) {
+		if(_residentBytes + bytes <= _budgetBytes) return true;
+
+		std::vector<std::pair<unsigned int, std::int32_t>> candidates;
+
+		for(const auto& [node, r] : _resident) if(r.lastUsed + 2 <= frame) candidates.emplace_back(r.lastUsed, node);
+
+		std::sort(candidates.begin(), candidates.end());
+
+		for(const auto& [lastUsed, node] : candidates) {
+			if(_residentBytes + bytes <= _budgetBytes) break;
+
+			_residentBytes -= _nodes[node].count * BYTES_PER_POINT;
+			_resident.erase(node);
+		}
+
+		return _residentBytes + bytes <= _budgetBytes;
+	}
+
+	// Adopts whatever the workers have finished since the last cull.
+	void _integrate(unsigned int frame) {
+		std::vector<std::pair<std::int32_t, osg::ref_ptr<osg::Geometry>>> ready;
+
+		{
+			std::lock_guard<std::mutex> lock(_readyMutex);
+
+			ready.swap(_ready);
+		}
+
+		// NOTE: The cull that asked for these made room for them, but the camera (and what's drawn)
+		// may have moved on since; one that doesn't fit anymore is dropped, and asked for again if
+		// it's still wanted.
+		for(auto& [node, geometry] : ready) {
+			size_t bytes = _nodes[node].count * BYTES_PER_POINT;
+
+			if(_resident.count(node) || !_evict(frame, bytes)) continue;
+
+			_resident[node] = {geometry, frame};
+			_residentBytes += bytes;
+		}
+	}
+
+	void _work() {
+		while(true) {
+			Request request;
+
+			{
+				std::unique_lock<std::mutex> lock(_queueMutex);
+
+				_queueCondition.wait(lock, [this]() {
+					return _quit || !_queue.empty();
+				});
+
+				if(_quit) return;
+
+				request = _queue.back();
+
+				_queue.pop_back();
+				_inFlight.insert(request.node);
+			}
+
+			osg::ref_ptr<osg::Geometry> geometry = _decode(request.node);
+
+			{
+				std::lock_guard<std::mutex> lock(_readyMutex);
+
+				_ready.emplace_back(request.node, geometry);
+			}
+
+			{
+				std::lock_guard<std::mutex> lock(_queueMutex);
+
+				_inFlight.erase(request.node);
+			}
+
+			if(_loaded) _loaded();
+		}
+	}
+
+	// Runs on a worker: touching the mapping here is what pages the points in.
+	osg::Geometry* _decode(std::int32_t node) const {
+		const auto& record = _nodes[node];
+		const PointCloudPoint* src = _points + record.offset;
+
+		auto* vertices = new osg::Vec3Array(record.count);
+		auto* colors = new osg::Vec4ubArray(record.count);
+
+		for(std::uint32_t i = 0; i < record.count; i++) {
+			(*vertices)[i].set(src[i].x, src[i].y, src[i].z);
+			(*colors)[i].set(src[i].r, src[i].g, src[i].b, src[i].a);
+		}
+
+		auto* geometry = new osg::Geometry();
+
+		geometry->setUseDisplayList(false);
+		geometry->setUseVertexBufferObjects(true);
+		geometry->setVertexArray(vertices);
+		geometry->setColorArray(colors, osg::Array::BIND_PER_VERTEX);
+		geometry->addPrimitiveSet(new osg::DrawArrays(GL_POINTS, 0, static_cast<GLsizei>(record.count)));
+		geometry->setInitialBound(_box(node));
+
+		return geometry;
+	}
+
+	QFile _file;
+
+	const uchar* _data = nullptr;
+	const PointCloudHeader* _header = nullptr;
+	const PointCloudNodeRecord* _nodes = nullptr;
+	const PointCloudPoint* _points = nullptr;
+
+	size_t _budgetBytes = 0;
+	float _maxError = 2.0f;
+
+	// Cull thread only.
+	std::unordered_map<std::int32_t, Resident> _resident;
+	size_t _residentBytes = 0;
+	size_t _drawnPoints = 0;
+	size_t _missingNodes = 0;
+
+	mutable std::mutex _queueMutex;
+	std::condition_variable _queueCondition;
+	std::vector<Request> _queue;
+	std::unordered_set<std::int32_t> _inFlight;
+	bool _quit = false;
+
+	std::mutex _readyMutex;
+	std::vector<std::pair<std::int32_t, osg::ref_ptr<osg::Geometry>>> _ready;
+
+	std::vector<std::thread> _workers;
+
+	std::function<void()> _loaded;
+};
+
+}
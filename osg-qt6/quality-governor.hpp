@@ -0,0 +1,270 @@
+#pragma once
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QOpenGLContext>
+#include <QOpenGLExtraFunctions>
+#include <QOpenGLFramebufferObject>
+
+#include <osg/Stats>
+#include <osgViewer/Viewer>
+
+namespace osg_qt6 {
+
+// Renders the osgViewer camera into an FBO of its own at `scale` times the widget's device-pixel
+// size (with its own MSAA sample count), then upscales that into the widget's framebuffer. After
+// each frame it compares what the frame cost (the larger of the CPU time around `frame()` and the
+// GPU time osgViewer measured) against the target, and steps quality down when over budget (MSAA
+// first, then resolution) or back up when comfortably under (resolution first, then MSAA).
+//
+// In paintGL(), with the widget's context current:
+//
+//   _governor.begin(_viewer, w, h);
+//   _viewer->frame();
+//   _governor.end(defaultFramebufferObject(), w, h, _viewer, cpuMs);
+//
+// (where w and h are the widget's size in device pixels).
+//
+// NOTE: The camera's viewport is in the governor's FBO pixels while it's active; anything mapping
+// window coordinates onto it (e.g., DepthPicker) has to scale by viewportScale().
+class QualityGovernor {
+public:
+	struct Change {
+		unsigned int frame;
+
+		double seconds;
+
+		float scale;
+		int samples;
+
+		// The smoothed frame cost that triggered it.
+		double frameMs;
+	};
+
+	QualityGovernor(double targetMs=1000.0 / 60.0, int maxSamples=4):
+	_targetMs(targetMs),
+	_maxSamples(maxSamples),
+	_samples(maxSamples) {
+		_clock.start();
+	}
+
+	~QualityGovernor() {
+		release();
+	}
+
+	void setTarget(double targetMs) {
+		_targetMs = targetMs;
+	}
+
+	void setScaleRange(float minScale, float maxScale) {
+		_minScale = minScale;
+		_maxScale = maxScale;
+		_scale = std::clamp(_scale, _minScale, _maxScale);
+	}
+
+	float scale() const {
+		return _scale;
+	}
+
+	int samples() const {
+		return _samples;
+	}
+
+	// Governor FBO pixels per logical (widget) pixel.
+	double viewportScale(qreal dpr) const {
+		return dpr * _scale;
+	}
+
+	GLuint fbo() const {
+		return _fbo ? _fbo->handle() : 0;
+	}
+
+	const std::vector<Change>& history() const {
+		return _history;
+	}
+
+	QJsonObject toJson() const {
+		QJsonArray history;
+
+		for(const auto& c : _history) history.append(QJsonObject{
+			{"frame", static_cast<qint64>(c.frame)},
+			{"seconds", c.seconds},
+			{"scale", c.scale},
+			{"samples", c.samples},
+			{"frame_ms", c.frameMs}
+		});
+
+		return {
+			{"target_ms", _targetMs},
+			{"scale", _scale},
+			{"samples", _samples},
+			{"frame_ms", _averageMs},
+			{"history", history}
+		};
+	}
+
+	// Binds the (possibly re-created) governor FBO and points the camera at it.
+	void begin(osgViewer::Viewer* viewer, int width, int height) {
+		int w = std::max(1, static_cast<int>(width * _scale + 0.5f));
+		int h = std::max(1, static_cast<int>(height * _scale + 0.5f));
+
+		if(!_fbo || _fbo->width() != w || _fbo->height() != h || _fboSamples != _samples) {
+			QOpenGLFramebufferObjectFormat format;
+
+			format.setAttachment(QOpenGLFramebufferObject::CombinedDepthStencil);
+			format.setSamples(_samples);
+
+			_fbo = std::make_unique<QOpenGLFramebufferObject>(w, h, format);
+			_resolve = _samples > 0 ? std::make_unique<QOpenGLFramebufferObject>(w, h) : nullptr;
+			_fboSamples = _samples;
+			_context = QOpenGLContext::currentContext();
+		}
+
+		_fbo->bind();
+
+		viewer->getCamera()->getGraphicsContext()->setDefaultFboId(_fbo->handle());
+		viewer->getCamera()->setViewport(0, 0, w, h);
+
+		if(!_statsEnabled) {
+			viewer->getCamera()->getStats()->collectStats("gpu", true);
+
+			_statsEnabled = true;
+		}
+	}
+
+	// Upscales the frame into `target` (the widget's FBO) and feeds the governor this frame's cost.
+	void end(GLuint target, int width, int height, osgViewer::Viewer* viewer, double cpuMs) {
+		auto* gl = _context->extraFunctions();
+
+		GLuint source = _fbo->handle();
+
+		// NOTE: A multisampled source can only be blitted 1:1, so resolve first and scale second.
+		if(_resolve) {
+			gl->glBindFramebuffer(GL_READ_FRAMEBUFFER, source);
+			gl->glBindFramebuffer(GL_DRAW_FRAMEBUFFER, _resolve->handle());
+			gl->glBlitFramebuffer(
+				0, 0, _fbo->width(), _fbo->height(),
+				0, 0, _fbo->width(), _fbo->height(),
+				GL_COLOR_BUFFER_BIT,
+				GL_NEAREST
+			);
+
+			source = _resolve->handle();
+		}
+
+		gl->glBindFramebuffer(GL_READ_FRAMEBUFFER, source);
+		gl->glBindFramebuffer(GL_DRAW_FRAMEBUFFER, target);
+		gl->glBlitFramebuffer(
+			0, 0, _fbo->width(), _fbo->height(),
+			0, 0, width, height,
+			GL_COLOR_BUFFER_BIT,
+			_scale == 1.0f ? GL_NEAREST : GL_LINEAR
+		);
+		gl->glBindFramebuffer(GL_FRAMEBUFFER, target);
+
+		_update(viewer, cpuMs);
+	}
+
+	// Context must be current.
+	void release() {
+		if(QOpenGLContext::currentContext() != _context) return;
+
+		_fbo.reset();
+		_resolve.reset();
+	}
+
+private:
+	// GPU times come from timer queries and show up a few frames late.
+	static constexpr unsigned int GPU_LAG = 3;
+
+	static constexpr unsigned int DOWN_FRAMES = 10;
+	static constexpr unsigned int UP_FRAMES = 90;
+	static constexpr unsigned int COOLDOWN_FRAMES = 30;
+	static constexpr float STEP = 0.125f;
+
+	void _update(osgViewer::Viewer* viewer, double cpuMs) {
+		double gpuMs = 0.0;
+
+		auto frameNumber = viewer->getViewerFrameStamp()->getFrameNumber();
+
+		if(frameNumber >= GPU_LAG) {
+			double seconds = 0.0;
+
+			if(viewer->getCamera()->getStats()->getAttribute(frameNumber - GPU_LAG, "GPU draw time taken", seconds)) {
+				gpuMs = seconds * 1000.0;
+			}
+		}
+
+		double cost = std::max(cpuMs, gpuMs);
+
+		_averageMs = _averageMs > 0.0 ? _averageMs * 0.9 + cost * 0.1 : cost;
+
+		if(_cooldown > 0) {
+			_cooldown--;
+
+			return;
+		}
+
+		_over = _averageMs > _targetMs * 1.05 ? _over + 1 : 0;
+		_under = _averageMs < _targetMs * 0.7 ? _under + 1 : 0;
+
+		float scale = _scale;
+		int samples = _samples;
+
+		if(_over >= DOWN_FRAMES) {
+			if(samples > 0) samples /= 2;
+
+			else scale = std::max(_minScale, scale - STEP);
+		}
+
+		else if(_under >= UP_FRAMES) {
+			if(scale < _maxScale) scale = std::min(_maxScale, scale + STEP);
+
+			else if(samples < _maxSamples) samples = samples ? samples * 2 : 2;
+		}
+
+		if(scale == _scale && samples == _samples) return;
+
+		_scale = scale;
+		_samples = std::min(samples, _maxSamples);
+		_over = 0;
+		_under = 0;
+		_cooldown = COOLDOWN_FRAMES;
+
+		_history.push_back({frameNumber, _clock.nsecsElapsed() / 1.0e9, _scale, _samples, _averageMs});
+	}
+
+	double _targetMs = 1000.0 / 60.0;
+
+	float _minScale = 0.5f;
+	float _maxScale = 1.0f;
+	float _scale = 1.0f;
+
+	int _maxSamples = 4;
+	int _samples = 4;
+	int _fboSamples = -1;
+
+	double _averageMs = 0.0;
+
+	unsigned int _over = 0;
+	unsigned int _under = 0;
+	unsigned int _cooldown = 0;
+
+	bool _statsEnabled = false;
+
+	std::unique_ptr<QOpenGLFramebufferObject> _fbo;
+	std::unique_ptr<QOpenGLFramebufferObject> _resolve;
+
+	QOpenGLContext* _context = nullptr;
+
+	std::vector<Change> _history;
+
+	QElapsedTimer _clock;
+};
+
+}
@@ -0,0 +1,373 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QOpenGLWidget>
+#include <QOpenGLContext>
+#include <QOpenGLFramebufferObject>
+#include <QOpenGLTextureBlitter>
+#include <QOffscreenSurface>
+
+#include <osgViewer/Viewer>
+#include <osgViewer/GraphicsWindow>
+
+#include "osg-qt6/frame-scheduler.hpp"
+#include "osg-qt6/trace.hpp"
+
+namespace osg_qt6 {
+
+// An embedded GraphicsWindow backed by its own QOpenGLContext (shared with the widget's) and a
+// QOffscreenSurface. Unlike the stock GraphicsWindowEmbedded, makeCurrent() really does make a
+// context current, which is what lets osgViewer's CullDrawThreadPerContext/DrawThreadPerContext
+// models run their draw on a thread of their choosing.
+class QtGraphicsWindow: public osgViewer::GraphicsWindowEmbedded {
+public:
+	QtGraphicsWindow(QOpenGLContext* context, QOffscreenSurface* surface, int w, int h):
+	osgViewer::GraphicsWindowEmbedded(0, 0, w, h),
+	_context(context),
+	_surface(surface) {
+	}
+
+	bool makeCurrentImplementation() override {
+		// NOTE: QT refuses to make a context current on a thread other than the one it "lives" in.
+		// Contexts that aren't current anywhere are parked with NO thread affinity (see below), and
+		// an object with no affinity is the one case QT allows to be "pulled" into the caller's
+		// thread.
+		if(!_context->thread()) _context->moveToThread(QThread::currentThread());
+
+		return _context->makeCurrent(_surface);
+	}
+
+	bool releaseContextImplementation() override {
+		_context->doneCurrent();
+		_context->moveToThread(nullptr);
+
+		return true;
+	}
+
+	void swapBuffersImplementation() override {
+		// Nothing to swap; frames land in the RenderThread's FBOs and the widget composites them.
+	}
+
+	QOpenGLContext* context() const {
+		return _context;
+	}
+
+private:
+	QOpenGLContext* _context = nullptr;
+	QOffscreenSurface* _surface = nullptr;
+};
+
+inline osgViewer::ViewerBase::ThreadingModel threadingModelFromString(const std::string& name) {
+	if(name == "cull-draw") return osgViewer::ViewerBase::CullDrawThreadPerContext;
+
+	else if(name == "draw") return osgViewer::ViewerBase::DrawThreadPerContext;
+
+	else if(name == "cull-thread") return osgViewer::ViewerBase::CullThreadPerCameraDrawThreadPerContext;
+
+	return osgViewer::ViewerBase::SingleThreaded;
+}
+
+// Runs the osgViewer frame loop off the QT GUI thread. Each frame is drawn into one of three FBOs
+// (back, ready, front); the draw side publishes "back" as "ready" once the GPU is done with it and
+// the GUI thread only ever blits "front" into the QOpenGLWidget's framebuffer. Nothing on the GUI
+// thread waits on event/update/cull/draw anymore.
+//
+// Usage (from the widget's initializeGL(), with the widget's context current):
+//
+//   _renderThread = new osg_qt6::RenderThread(this, _viewer, osgViewer::Viewer::DrawThreadPerContext);
+//   _renderThread->setFrameReadyCallback([this]() { ... update(); });
+//   _scheduler->setDemandFunction([this]() { return _renderThread->demand(); });
+//   _renderThread->start();
+//
+// ...and from paintGL(), `_renderThread->composite()`.
+class RenderThread: public QThread {
+public:
+	using FrameReadyCallback = std::function<void()>;
+
+	RenderThread(
+		QOpenGLWidget* widget,
+		osgViewer::Viewer* viewer,
+		osgViewer::ViewerBase::ThreadingModel threadingModel=osgViewer::ViewerBase::SingleThreaded
+	):
+	_viewer(viewer) {
+		_width = std::max(widget->width(), 1);
+		_height = std::max(widget->height(), 1);
+
+		// NOTE: The surface MUST be created on the GUI thread; the context is created here (while
+		// the widget's context is current, so sharing works) and then parked with no affinity until
+		// whichever osgViewer thread does the drawing pulls it over.
+		_surface = std::make_unique<QOffscreenSurface>();
+		_surface->setFormat(widget->context()->format());
+		_surface->create();
+
+		_context = new QOpenGLContext();
+		_context->setFormat(widget->context()->format());
+		_context->setShareContext(widget->context());
+		_context->create();
+		_context->moveToThread(nullptr);
+
+		_gw = new QtGraphicsWindow(_context, _surface.get(), _width, _height);
+
+		osg::Camera* camera = _viewer->getCamera();
+
+		camera->setGraphicsContext(_gw.get());
+		camera->setViewport(new osg::Viewport(0, 0, _width, _height));
+		camera->setProjectionMatrixAsPerspective(30.0f, static_cast<double>(_width) / _height, 1.0, 1000.0);
+		camera->setInitialDrawCallback(new BindCallback(this));
+		camera->setFinalDrawCallback(new PublishCallback(this));
+
+		_viewer->setThreadingModel(threadingModel);
+		_viewer->setReleaseContextAtEndOfFrameHint(true);
+	}
+
+	// NOTE: Delete this with the WIDGET'S context current (i.e., after a `makeCurrent()` in the
+	// widget's destructor); the blitter belongs to it.
+	~RenderThread() override {
+		_blitter.destroy();
+
+		stop();
+
+		// The FBOs belong to the render context; tear them down with it current (the GUI thread
+		// can pull it now that every osgViewer thread has released it).
+		if(_gw->makeCurrent()) {
+			for(auto& fbo : _fbos) fbo.reset();
+
+			_gw->releaseContext();
+		}
+
+		osg::Camera* camera = _viewer->getCamera();
+
+		camera->setInitialDrawCallback(nullptr);
+		camera->setFinalDrawCallback(nullptr);
+
+		// NOTE: The viewer (which may well outlive us; the widget holds it too) closes whatever
+		// contexts its camera still has when it goes, and _gw would make _context current doing
+		// so. Close _gw (releasing the scene's GL objects) and detach it while _context still
+		// exists.
+		_gw->close();
+
+		camera->setGraphicsContext(nullptr);
+
+		_viewer = nullptr;
+		_gw = nullptr;
+
+		delete _context;
+	}
+
+	void setFrameReadyCallback(FrameReadyCallback callback) {
+		_frameReady = std::move(callback);
+	}
+
+	void requestFrame() {
+		QMutexLocker lock(&_mutex);
+
+		_requested = true;
+
+		_wake.wakeOne();
+	}
+
+	void resize(int w, int h) {
+		QMutexLocker lock(&_mutex);
+
+		_width = std::max(w, 1);
+		_height = std::max(h, 1);
+		_resized = true;
+		_requested = true;
+
+		_wake.wakeOne();
+	}
+
+	void stop() {
+		{
+			QMutexLocker lock(&_mutex);
+
+			_done = true;
+
+			_wake.wakeOne();
+		}
+
+		wait();
+	}
+
+	// GUI thread, from paintGL(); blits the most recently published frame (if any) into whatever
+	// framebuffer QOpenGLWidget has bound.
+	bool composite() {
+		QMutexLocker lock(&_fboMutex);
+
+		if(_fresh) {
+			std::swap(_ready, _front);
+
+			_fresh = false;
+		}
+
+		const auto& fbo = _fbos[_front];
+
+		if(!fbo) return false;
+
+		if(!_blitter.isCreated()) _blitter.create();
+
+		_blitter.bind();
+		_blitter.blit(fbo->texture(), QMatrix4x4(), QOpenGLTextureBlitter::OriginBottomLeft);
+		_blitter.release();
+
+		return true;
+	}
+
+	QtGraphicsWindow* graphicsWindow() const {
+		return _gw.get();
+	}
+
+	unsigned long long framesRendered() const {
+		return _framesRendered;
+	}
+
+	// What the viewer wanted after the last frame; FRAME while one is still in progress. Safe from
+	// any thread (unlike asking the viewer, which this thread may be in the middle of).
+	FrameScheduler::Demand demand() const {
+		return _demand;
+	}
+
+protected:
+	void run() override {
+		trace::setThreadName("render");
+
+		while(true) {
+			bool resized = false;
+			int w = 0;
+			int h = 0;
+
+			{
+				QMutexLocker lock(&_mutex);
+
+				while(!_done && !_requested) _wake.wait(&_mutex);
+
+				if(_done) break;
+
+				std::swap(resized, _resized);
+
+				_requested = false;
+
+				w = _width;
+				h = _height;
+			}
+
+			_demand = FrameScheduler::FRAME;
+
+			if(resized) {
+				_gw->resized(0, 0, w, h);
+				_viewer->getCamera()->setViewport(new osg::Viewport(0, 0, w, h));
+				_viewer->getCamera()->setProjectionMatrixAsPerspective(30.0f, static_cast<double>(w) / h, 1.0, 1000.0);
+				_viewer->getEventQueue()->windowResize(0, 0, w, h);
+			}
+
+			trace::frame(_viewer.get());
+
+			_demand = FrameScheduler::demand(_viewer.get());
+		}
+
+		_viewer->setDone(true);
+		_viewer->stopThreading();
+	}
+
+	// Draw thread; context current.
+	void _bind(osg::RenderInfo& renderInfo) {
+		const osg::Viewport* vp = _viewer->getCamera()->getViewport();
+		const QSize size(static_cast<int>(vp->width()), static_cast<int>(vp->height()));
+
+		auto& fbo = _fbos[_back];
+
+		// NOTE: Only ever (re)create the back buffer; "ready" and "front" may be in use by the GUI
+		// context, and they'll get resized as they cycle back around.
+		if(!fbo || fbo->size() != size) fbo = std::make_unique<QOpenGLFramebufferObject>(
+			size,
+			QOpenGLFramebufferObject::CombinedDepthStencil
+		);
+
+		fbo->bind();
+
+		// osgEarth's RTT cameras re-bind the "default" FBO when they finish; it has to be ours.
+		renderInfo.getState()->getGraphicsContext()->setDefaultFboId(fbo->handle());
+	}
+
+	// Draw thread; context current.
+	void _publish(osg::RenderInfo&) {
+		// The GUI context samples this texture next; make sure the GPU has actually finished it.
+		_context->functions()->glFinish();
+
+		{
+			QMutexLocker lock(&_fboMutex);
+
+			std::swap(_back, _ready);
+
+			_fresh = true;
+		}
+
+		_framesRendered++;
+
+		if(_frameReady) _frameReady();
+	}
+
+	struct BindCallback: public osg::Camera::DrawCallback {
+		BindCallback(RenderThread* rt): _rt(rt) {}
+
+		void operator()(osg::RenderInfo& renderInfo) const override {
+			_rt->_bind(renderInfo);
+		}
+
+		RenderThread* _rt;
+	};
+
+	struct PublishCallback: public osg::Camera::DrawCallback {
+		PublishCallback(RenderThread* rt): _rt(rt) {}
+
+		void operator()(osg::RenderInfo& renderInfo) const override {
+			_rt->_publish(renderInfo);
+		}
+
+		RenderThread* _rt;
+	};
+
+private:
+	osg::ref_ptr<osgViewer::Viewer> _viewer;
+	osg::ref_ptr<QtGraphicsWindow> _gw;
+
+	std::unique_ptr<QOffscreenSurface> _surface;
+	QOpenGLContext* _context = nullptr;
+
+	QMutex _mutex;
+	QWaitCondition _wake;
+
+	bool _requested = true;
+	bool _resized = false;
+	bool _done = false;
+
+	int _width = 1;
+	int _height = 1;
+
+	QMutex _fboMutex;
+
+	std::array<std::unique_ptr<QOpenGLFramebufferObject>, 3> _fbos;
+
+	size_t _back = 0;
+	size_t _ready = 1;
+	size_t _front = 2;
+	bool _fresh = false;
+
+	QOpenGLTextureBlitter _blitter;
+
+	FrameReadyCallback _frameReady;
+
+	std::atomic<unsigned long long> _framesRendered = 0;
+	std::atomic<FrameScheduler::Demand> _demand = FrameScheduler::FRAME;
+};
+
+}
@@ -0,0 +1,174 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+#include <QFile>
+
+#include <osg/Node>
+#include <osgDB/ReadFile>
+#include <osgDB/Registry>
+
+namespace osg_qt6 {
+
+// Bumped whenever the scene builders change what they produce, so old snapshots stop matching.
+constexpr const char* SNAPSHOT_VERSION = "1";
+
+// FNV-1a over everything that determines a scene (builder name, parameters, ...), as 16 hex
+// digits: the snapshot's file name.
+inline std::string contentHash(const std::vector<std::string>& parts) {
+	std::uint64_t h = 14695981039346656037ull;
+
+	auto mix = [&h](const char* data, size_t size) {
+		for(size_t i = 0; i < size; i++) {
+			h ^= static_cast<unsigned char>(data[i]);
+			h *= 1099511628211ull;
+		}
+	};
+
+	mix(SNAPSHOT_VERSION, std::char_traits<char>::length(SNAPSHOT_VERSION));
+
+	for(const auto& p : parts) {
+		// NOTE: The separator keeps {"ab", "c"} and {"a", "bc"} apart.
+		mix(p.data(), p.size());
+		mix("", 1);
+	}
+
+	char hex[17];
+
+	std::snprintf(hex, sizeof(hex), "%016llx", static_cast<unsigned long long>(h));
+
+	return hex;
+}
+
+// A read-only std::streambuf straight over a block of memory (a mapped file), so the osgb reader
+// parses the snapshot where it lies instead of from a copy.
+class MemoryStreamBuf: public std::streambuf {
+public:
+	MemoryStreamBuf(const char* data, size_t size) {
+		char* p = const_cast<char*>(data);
+
+		setg(p, p, p + size);
+	}
+
+protected:
+	pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode) override {
+		char* base = dir == std::ios_base::beg ? eback() : dir == std::ios_base::cur ? gptr() : egptr();
+
+		if(base + off < eback() || base + off > egptr()) return pos_type(off_type(-1));
+
+		setg(eback(), base + off, egptr());
+
+		return pos_type(gptr() - eback());
+	}
+
+	pos_type seekpos(pos_type pos, std::ios_base::openmode mode) override {
+		return seekoff(off_type(pos), std::ios_base::beg, mode);
+	}
+};
+
+// A directory of `<hash>.osgb` scene graphs. load() maps the file and reads it in place; save()
+// writes to a temporary and renames it into place, so a snapshot is either complete or absent.
+//
+// NOTE: Only plain OSG graphs round-trip; anything without osgDB serializers (PointCloudNode, an
+// osgEarth MapNode and its terrain) has to be rebuilt every time.
+class SceneSnapshot {
+public:
+	SceneSnapshot(const std::string& root=""):
+	_root(root) {
+	}
+
+	bool valid() const {
+		return !_root.empty();
+	}
+
+	std::filesystem::path path(const std::string& hash) const {
+		return _root / (hash + ".osgb");
+	}
+
+	osg::ref_ptr<osg::Node> load(const std::string& hash) const {
+		auto* rw = _readerWriter();
+
+		QFile file(QString::fromStdString(path(hash).string()));
+
+		if(!rw || !file.open(QIODevice::ReadOnly)) return nullptr;
+
+		if(auto* data = file.map(0, file.size())) {
+			MemoryStreamBuf buf(reinterpret_cast<const char*>(data), static_cast<size_t>(file.size()));
+			std::istream in(&buf);
+
+			return rw->readNode(in).getNode();
+		}
+
+		// NOTE: Not every filesystem can be mapped; fall back to a regular read.
+		return osgDB::readRefNodeFile(path(hash).string());
+	}
+
+	bool save(const std::string& hash, const osg::Node& node) const {
+		auto* rw = _readerWriter();
+
+		if(!rw) return false;
+
+		std::error_code ec;
+
+		std::filesystem::create_directories(_root, ec);
+
+		auto p = path(hash);
+		auto tmp = p;
+
+		tmp += ".tmp";
+
+		std::ofstream out(tmp, std::ios::binary);
+
+		// NOTE: Uncompressed, so load() can parse the mapping directly.
+		bool ok = out && rw->writeNode(node, out).success();
+
+		out.close();
+
+		// A short write (e.g. a full disk) may only show up once the stream is flushed.
+		ok = ok && out;
+
+		if(ok) std::filesystem::rename(tmp, p, ec);
+
+		ok = ok && !ec;
+
+		if(!ok) std::filesystem::remove(tmp, ec);
+
+		return ok;
+	}
+
+	// The snapshot for `hash` if there is one; otherwise `build()`'s result, saved for next time.
+	// `loaded` reports which happened.
+	osg::ref_ptr<osg::Node> loadOrBuild(
+		const std::string& hash,
+		const std::function<osg::Node*()>& build,
+		bool* loaded=nullptr
+	) const {
+		osg::ref_ptr<osg::Node> node = valid() ? load(hash) : osg::ref_ptr<osg::Node>();
+
+		if(loaded) *loaded = node.valid();
+
+		if(node.valid()) return node;
+
+		node = build();
+
+		if(node.valid() && valid()) save(hash, *node);
+
+		return node;
+	}
+
+private:
+	static osgDB::ReaderWriter* _readerWriter() {
+		return osgDB::Registry::instance()->getReaderWriterForExtension("osgb");
+	}
+
+	std::filesystem::path _root;
+};
+
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <osg/Geode>
+#include <osg/MatrixTransform>
+#include <osg/ShapeDrawable>
+#include <osg/Point>
+#include <osg/PolygonMode>
+
+#include "osg-qt6/instanced-spheres.hpp"
+
+namespace osg_qt6 {
+
+using vec_t = osg::Vec3::value_type;
+
+inline osg::ShapeDrawable* createSphere(vec_t radius, vec_t pSize) {
+	osg::ShapeDrawable* s = new osg::ShapeDrawable(new osg::Sphere(
+		osg::Vec3(0.0, 0.0, 0.0),
+		radius
+	));
+
+	s->getOrCreateStateSet()->setAttribute(
+		new osg::Point(pSize),
+		osg::StateAttribute::ON
+	);
+
+	return s;
+}
+
+inline osg::MatrixTransform* createSphereAt(const osg::Vec3& pos, vec_t radius, vec_t pSize) {
+	osg::MatrixTransform* m = new osg::MatrixTransform(osg::Matrix::translate(pos));
+	osg::Geode* g = new osg::Geode();
+
+	g->addDrawable(createSphere(radius, pSize));
+
+	m->addChild(g);
+
+	return m;
+}
+
+// The scene from example-osg/example-osg-interactive: one tessellated sphere, drawn as points.
+inline osg::Group* createPointSphereScene() {
+	osg::Group* root = new osg::Group();
+
+	root->addChild(createSphereAt(osg::Vec3(), 10.0, 2.0));
+	root->getOrCreateStateSet()->setAttributeAndModes(
+		new osg::PolygonMode(osg::PolygonMode::FRONT_AND_BACK, osg::PolygonMode::POINT),
+		osg::StateAttribute::ON
+	);
+
+	return root;
+}
+
+// `count` spheres (see createSphereInstances()) with the same point-mode look as
+// createPointSphereScene(). With `instanced` they're one createInstancedSpheres() draw; without,
+// each is built the original way (createSphereAt()), for comparison.
+inline osg::Group* createSphereFieldScene(size_t count, bool instanced=true) {
+	osg::Group* root = new osg::Group();
+	SphereInstances instances = createSphereInstances(count);
+
+	if(instanced) root->addChild(createInstancedSpheres(instances));
+
+	else for(const auto& i : instances) root->addChild(createSphereAt(osg::Vec3(i.x(), i.y(), i.z()), i.w(), 2.0));
+
+	osg::StateSet* ss = root->getOrCreateStateSet();
+
+	ss->setAttributeAndModes(
+		new osg::PolygonMode(osg::PolygonMode::FRONT_AND_BACK, osg::PolygonMode::POINT),
+		osg::StateAttribute::ON
+	);
+
+	// NOTE: The per-node spheres each still carry their own osg::Point; this one only applies to the
+	// instanced draw.
+	ss->setAttribute(new osg::Point(2.0), osg::StateAttribute::ON);
+
+	return root;
+}
+
+}
@@ -0,0 +1,372 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <osg/Image>
+#include <osg/Texture>
+#include <osgDB/ReadFile>
+#include <osgDB/WriteFile>
+
+#include <osgEarth/ImageUtils>
+
+namespace osg_qt6 {
+
+// Block compression (BC1 for opaque images, BC3 when there's any alpha) with the whole mip chain
+// built offline, so the GPU gets 4 or 8 bits per texel instead of 32 and never has to generate
+// mipmaps itself. The encoder is the usual real-time one (inset bounding box, nearest palette
+// entry): not as good as an offline PCA/cluster fit, but fast enough to run on a cache miss.
+namespace bc {
+
+// NOTE: Every encoder takes one 4x4 block of RGBA8 texels, row by row (64 bytes).
+constexpr size_t BLOCK_TEXELS = 16;
+
+inline uint16_t to565(const int* c) {
+	return static_cast<uint16_t>(((c[0] * 31 + 127) / 255) << 11 | ((c[1] * 63 + 127) / 255) << 5 | ((c[2] * 31 + 127) / 255));
+}
+
+inline void from565(uint16_t v, int* c) {
+	int r = (v >> 11) & 31;
+	int g = (v >> 5) & 63;
+	int b = v & 31;
+
+	c[0] = (r << 3) | (r >> 2);
+	c[1] = (g << 2) | (g >> 4);
+	c[2] = (b << 3) | (b >> 2);
+}
+
+// The 8-byte BC1 color block; also the second half of every BC3 block (which always decodes it in
+// four-color mode, so endpoints are kept ordered either way).
+inline void encodeColor(const unsigned char* block, unsigned char* out) {
+	int lo[3] = {255, 255, 255};
+	int hi[3] = {0, 0, 0};
+
+	for(size_t i = 0; i < BLOCK_TEXELS; i++) for(int c = 0; c < 3; c++) {
+		lo[c] = std::min<int>(lo[c], block[i * 4 + c]);
+		hi[c] = std::max<int>(hi[c], block[i * 4 + c]);
+	}
+
+	// NOTE: The box's main diagonal only fits colors that rise together; if red or blue falls as
+	// green rises, that axis is flipped.
+	int center[3];
+	int rg = 0;
+	int bg = 0;
+
+	for(int c = 0; c < 3; c++) center[c] = (lo[c] + hi[c]) / 2;
+
+	for(size_t i = 0; i < BLOCK_TEXELS; i++) {
+		int g = block[i * 4 + 1] - center[1];
+
+		rg += (block[i * 4] - center[0]) * g;
+		bg += (block[i * 4 + 2] - center[2]) * g;
+	}
+
+	if(rg < 0) std::swap(lo[0], hi[0]);
+	if(bg < 0) std::swap(lo[2], hi[2]);
+
+	// Pull the endpoints in by 1/16th of the range; the extremes are usually outliers.
+	for(int c = 0; c < 3; c++) {
+		int inset = (hi[c] - lo[c]) / 16;
+
+		hi[c] -= inset;
+		lo[c] += inset;
+	}
+
+	uint16_t c0 = to565(hi);
+	uint16_t c1 = to565(lo);
+
+	if(c0 < c1) std::swap(c0, c1);
+
+	uint32_t indices = 0;
+
+	// NOTE: c0 == c1 is three-color mode in BC1, but with every index 0 it decodes the same.
+	if(c0 != c1) {
+		int palette[4][3];
+
+		from565(c0, palette[0]);
+		from565(c1, palette[1]);
+
+		for(int c = 0; c < 3; c++) {
+			palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+			palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+		}
+
+		for(size_t i = 0; i < BLOCK_TEXELS; i++) {
+			int best = 0;
+			int bestDistance = 1 << 30;
+
+			for(int p = 0; p < 4; p++) {
+				int distance = 0;
+
+				for(int c = 0; c < 3; c++) {
+					int d = block[i * 4 + c] - palette[p][c];
+
+					distance += d * d;
+				}
+
+				if(distance < bestDistance) {
+					best = p;
+					bestDistance = distance;
+				}
+			}
+
+			indices |= static_cast<uint32_t>(best) << (i * 2);
+		}
+	}
+
+	out[0] = static_cast<unsigned char>(c0);
+	out[1] = static_cast<unsigned char>(c0 >> 8);
+	out[2] = static_cast<unsigned char>(c1);
+	out[3] = static_cast<unsigned char>(c1 >> 8);
+
+	for(int i = 0; i < 4; i++) out[4 + i] = static_cast<unsigned char>(indices >> (i * 8));
+}
+
+// The 8-byte BC3 alpha block: two endpoints and the eight-value ramp between them.
+inline void encodeAlpha(const unsigned char* block, unsigned char* out) {
+	int lo = 255;
+	int hi = 0;
+
+	for(size_t i = 0; i < BLOCK_TEXELS; i++) {
+		lo = std::min<int>(lo, block[i * 4 + 3]);
+		hi = std::max<int>(hi, block[i * 4 + 3]);
+	}
+
+	uint64_t indices = 0;
+
+	if(hi != lo) {
+		int palette[8] = {hi, lo};
+
+		for(int p = 1; p < 7; p++) palette[p + 1] = ((7 - p) * hi + p * lo) / 7;
+
+		for(size_t i = 0; i < BLOCK_TEXELS; i++) {
+			int best = 0;
+
+			for(int p = 1; p < 8; p++) {
+				if(std::abs(block[i * 4 + 3] - palette[p]) < std::abs(block[i * 4 + 3] - palette[best])) best = p;
+			}
+
+			indices |= static_cast<uint64_t>(best) << (i * 3);
+		}
+	}
+
+	out[0] = static_cast<unsigned char>(hi);
+	out[1] = static_cast<unsigned char>(lo);
+
+	for(int i = 0; i < 6; i++) out[2 + i] = static_cast<unsigned char>(indices >> (i * 8));
+}
+
+// Encodes a `width` x `height` RGBA8 image (rows `stride` bytes apart) into `out`, which must hold
+// blockBytes() per 4x4 block. Edge blocks of sizes that aren't a multiple of 4 repeat the last
+// row/column.
+inline void encodeImage(const unsigned char* rgba, int width, int height, size_t stride, bool alpha, unsigned char* out) {
+	unsigned char block[BLOCK_TEXELS * 4];
+
+	for(int by = 0; by < height; by += 4) for(int bx = 0; bx < width; bx += 4) {
+		for(int y = 0; y < 4; y++) for(int x = 0; x < 4; x++) {
+			const unsigned char* texel =
+				rgba +
+				std::min(by + y, height - 1) * stride +
+				std::min(bx + x, width - 1) * 4
+			;
+
+			std::copy_n(texel, 4, block + (y * 4 + x) * 4);
+		}
+
+		if(alpha) {
+			encodeAlpha(block, out);
+
+			out += 8;
+		}
+
+		encodeColor(block, out);
+
+		out += 8;
+	}
+}
+
+inline size_t blockBytes(bool alpha) {
+	return alpha ? 16 : 8;
+}
+
+inline size_t imageBytes(int width, int height, bool alpha) {
+	return static_cast<size_t>((width + 3) / 4) * ((height + 3) / 4) * blockBytes(alpha);
+}
+
+}
+
+// Halves an RGBA8 image with a 2x2 box filter (odd edges repeat their last row/column).
+inline osg::Image* halveImage(const osg::Image* src) {
+	int w = std::max(1, (src->s() + 1) / 2);
+	int h = std::max(1, (src->t() + 1) / 2);
+
+	auto* dst = new osg::Image();
+
+	dst->allocateImage(w, h, 1, GL_RGBA, GL_UNSIGNED_BYTE);
+
+	for(int y = 0; y < h; y++) for(int x = 0; x < w; x++) {
+		int x0 = std::min(x * 2, src->s() - 1);
+		int x1 = std::min(x * 2 + 1, src->s() - 1);
+		int y0 = std::min(y * 2, src->t() - 1);
+		int y1 = std::min(y * 2 + 1, src->t() - 1);
+
+		unsigned char* out = dst->data(x, y);
+
+		for(int c = 0; c < 4; c++) out[c] = static_cast<unsigned char>((
+			src->data(x0, y0)[c] +
+			src->data(x1, y0)[c] +
+			src->data(x0, y1)[c] +
+			src->data(x1, y1)[c] + 2
+		) / 4);
+	}
+
+	return dst;
+}
+
+// Transcodes any image osgEarth can read as RGBA8 into a BC1 (or, given any alpha below 255, BC3)
+// image carrying its full mip chain down to 1x1. Returns null for images that already are
+// compressed, or can't be converted.
+inline osg::ref_ptr<osg::Image> compressImage(const osg::Image* image) {
+	if(!image || image->isCompressed() || image->r() != 1) return nullptr;
+
+	osg::ref_ptr<osg::Image> level = osgEarth::ImageUtils::convertToRGBA8(image);
+
+	if(!level.valid()) return nullptr;
+
+	bool alpha = false;
+
+	for(int y = 0; y < level->t() && !alpha; y++) for(int x = 0; x < level->s() && !alpha; x++) {
+		alpha = level->data(x, y)[3] != 255;
+	}
+
+	// NOTE: Offsets of levels 1 and up, as osg::Image wants them.
+	osg::Image::MipmapDataType offsets;
+	size_t total = 0;
+
+	for(int w = level->s(), h = level->t();; w = std::max(1, w / 2), h = std::max(1, h / 2)) {
+		if(total) offsets.push_back(static_cast<unsigned int>(total));
+
+		total += bc::imageBytes(w, h, alpha);
+
+		if(w == 1 && h == 1) break;
+	}
+
+	auto* data = new unsigned char[total];
+	unsigned char* out = data;
+
+	int width = level->s();
+	int height = level->t();
+
+	// NOTE: GL's mip sizes round down, halveImage() rounds up; an odd edge's last texels are just
+	// left out of the block data.
+	for(int w = width, h = height;; w = std::max(1, w / 2), h = std::max(1, h / 2)) {
+		bc::encodeImage(level->data(), w, h, level->getRowStepInBytes(), alpha, out);
+
+		out += bc::imageBytes(w, h, alpha);
+
+		if(w == 1 && h == 1) break;
+
+		level = halveImage(level.get());
+	}
+
+	GLenum format = alpha ? GL_COMPRESSED_RGBA_S3TC_DXT5_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+
+	osg::ref_ptr<osg::Image> compressed = new osg::Image();
+
+	compressed->setImage(width, height, 1, format, format, GL_UNSIGNED_BYTE, data, osg::Image::USE_NEW_DELETE);
+	compressed->setMipmapLevels(offsets);
+
+	return compressed;
+}
+
+// Reads and writes compressed images as DDS files (through osgDB's own plugin), exactly as they are
+// laid out in memory.
+//
+// NOTE: OSG images are stored bottom row first and DDS files top row first. Neither side is flipped
+// here, so a cache file looks upside down in other DDS viewers, but loading one is a straight read
+// with nothing to do before the upload.
+inline osg::ref_ptr<osg::Image> readCompressedImage(const std::filesystem::path& path) {
+	std::error_code ec;
+
+	if(!std::filesystem::exists(path, ec)) return nullptr;
+
+	osg::ref_ptr<osg::Image> image = osgDB::readRefImageFile(path.string());
+
+	if(!image.valid() || !image->isCompressed()) return nullptr;
+
+	image->setOrigin(osg::Image::BOTTOM_LEFT);
+
+	return image;
+}
+
+// Goes through a per-thread temporary that's renamed into place, like TileCache::write().
+inline bool writeCompressedImage(const osg::Image& image, const std::filesystem::path& path) {
+	std::error_code ec;
+
+	std::filesystem::create_directories(path.parent_path(), ec);
+
+	if(ec) return false;
+
+	auto tmp = path;
+
+	tmp += "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".dds";
+
+	osg::ref_ptr<osgDB::Options> options = new osgDB::Options("ddsNoAutoFlipWrite");
+
+	if(!osgDB::writeImageFile(image, tmp.string(), options.get())) return false;
+
+	std::filesystem::rename(tmp, path, ec);
+
+	bool ok = !ec;
+
+	if(!ok) std::filesystem::remove(tmp, ec);
+
+	return ok;
+}
+
+// Where the compressed copy of the image file `source` lives in `cacheDir`. The name covers the
+// file's size and modification time too, so an edited source is transcoded again.
+inline std::filesystem::path compressedCachePath(const std::filesystem::path& source, const std::filesystem::path& cacheDir) {
+	std::error_code ec;
+
+	auto size = std::filesystem::file_size(source, ec);
+	auto time = std::filesystem::last_write_time(source, ec).time_since_epoch().count();
+
+	auto hash = std::hash<std::string>()(
+		std::filesystem::absolute(source, ec).string() + ":" +
+		std::to_string(size) + ":" +
+		std::to_string(time)
+	);
+
+	char hex[17];
+
+	std::snprintf(hex, sizeof(hex), "%016llx", static_cast<unsigned long long>(hash));
+
+	return cacheDir / (source.stem().string() + "-" + hex + ".dds");
+}
+
+// Loads `source` from its compressed copy in `cacheDir`, transcoding (and caching) it first if
+// there isn't one yet. Falls back to the plain image when it can't be compressed at all.
+inline osg::ref_ptr<osg::Image> readImageCompressed(const std::string& source, const std::string& cacheDir) {
+	auto path = compressedCachePath(source, cacheDir);
+
+	if(osg::ref_ptr<osg::Image> cached = readCompressedImage(path); cached.valid()) return cached;
+
+	osg::ref_ptr<osg::Image> image = osgDB::readRefImageFile(source);
+	osg::ref_ptr<osg::Image> compressed = compressImage(image.get());
+
+	if(!compressed.valid()) return image;
+
+	writeCompressedImage(*compressed, path);
+
+	return compressed;
+}
+
+}
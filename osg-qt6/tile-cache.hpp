@@ -0,0 +1,215 @@
+#pragma once
+
+#include <cstdio>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <thread>
+
+#include <osgDB/ReadFile>
+#include <osgDB/WriteFile>
+
+#include <osgEarth/ImageLayer>
+
+#include "osg-qt6/texture-compression.hpp"
+
+namespace osg_qt6 {
+
+// Whether a createImage() that came back invalid means `source` has nothing for `key` (outside its
+// data extents, or an empty answer without an error) rather than a failure worth asking again
+// (a timeout, a network error, a canceled request).
+inline bool isNoData(
+	const osgEarth::ImageLayer* source,
+	const osgEarth::TileKey& key,
+	const osgEarth::GeoImage& image,
+	osgEarth::ProgressCallback* progress=nullptr
+) {
+	if(image.valid() || (progress && progress->isCanceled())) return false;
+
+	if(!source->mayHaveData(key)) return true;
+
+	return !image.getStatus().isError();
+}
+
+// A plain on-disk tile cache, one PNG per key at `<root>/<lod>/<x>/<y>.png`. Keys the source has no
+// data for (see isNoData()) are recorded as an empty `<y>.empty` file, so they're never asked for
+// again either; errors aren't, so those keys are retried.
+// A `compressed` cache holds block-compressed, fully mipmapped `<y>.dds` tiles instead (see
+// osg-qt6/texture-compression.hpp); write() transcodes whatever it's given.
+//
+// Writes go to a per-thread temporary first and are renamed into place, so a tile is either
+// completely there or not at all; that's what lets tool-seed-cache stop and resume anywhere.
+class TileCache {
+public:
+	TileCache(const std::string& root="", bool compressed=false):
+	_root(root),
+	_compressed(compressed) {
+	}
+
+	bool valid() const {
+		return !_root.empty();
+	}
+
+	const std::filesystem::path& root() const {
+		return _root;
+	}
+
+	bool compressed() const {
+		return _compressed;
+	}
+
+	// NOTE: Without an `ext`, the cache's own tile format.
+	std::filesystem::path path(const osgEarth::TileKey& key, const char* ext=nullptr) const {
+		if(!ext) ext = _compressed ? ".dds" : ".png";
+
+		return _root /
+			std::to_string(key.getLOD()) /
+			std::to_string(key.getTileX()) /
+			(std::to_string(key.getTileY()) + ext)
+		;
+	}
+
+	// Whether `key` has been written (with or without data).
+	bool contains(const osgEarth::TileKey& key) const {
+		std::error_code ec;
+
+		return std::filesystem::exists(path(key), ec) || isEmpty(key);
+	}
+
+	bool isEmpty(const osgEarth::TileKey& key) const {
+		std::error_code ec;
+
+		return std::filesystem::exists(path(key, ".empty"), ec);
+	}
+
+	osg::ref_ptr<osg::Image> read(const osgEarth::TileKey& key) const {
+		if(_compressed) return readCompressedImage(path(key));
+
+		std::error_code ec;
+		auto p = path(key);
+
+		if(!std::filesystem::exists(p, ec)) return nullptr;
+
+		return osgDB::readRefImageFile(p.string());
+	}
+
+	// A null `image` records the key as empty.
+	bool write(const osgEarth::TileKey& key, const osg::Image* image) const {
+		if(image && _compressed) {
+			osg::ref_ptr<const osg::Image> compressed = image;
+
+			if(!image->isCompressed()) compressed = compressImage(image);
+
+			return compressed.valid() && writeCompressedImage(*compressed, path(key));
+		}
+
+		std::error_code ec;
+		auto p = image ? path(key) : path(key, ".empty");
+
+		std::filesystem::create_directories(p.parent_path(), ec);
+
+		if(ec) return false;
+
+		auto tmp = p;
+
+		tmp += "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".png";
+
+		if(image) {
+			if(!osgDB::writeImageFile(*image, tmp.string())) return false;
+		}
+
+		else if(std::FILE* f = std::fopen(tmp.string().c_str(), "wb")) std::fclose(f);
+
+		else return false;
+
+		std::filesystem::rename(tmp, p, ec);
+
+		bool ok = !ec;
+
+		if(!ok) std::filesystem::remove(tmp, ec);
+
+		return ok;
+	}
+
+private:
+	std::filesystem::path _root;
+
+	bool _compressed = false;
+};
+
+}
+
+// Reads tiles from a TileCache first, and only goes to the wrapped source layer (GDAL, for the
+// examples) on a miss. Misses are written back unless told otherwise. With `setCompressed(true)`
+// every tile it hands out is block compressed with its mipmaps (transcoded on a miss), so the
+// terrain uploads it as is.
+class CachedImageLayer: public osgEarth::ImageLayer {
+public:
+	META_Layer(osgEarth, CachedImageLayer, Options, ImageLayer, cachedimagelayer);
+
+	void setSource(osgEarth::ImageLayer* source) {
+		_source = source;
+	}
+
+	void setCachePath(const std::string& path) {
+		_cache = osg_qt6::TileCache(path, _cache.compressed());
+	}
+
+	void setCompressed(bool compressed) {
+		_cache = osg_qt6::TileCache(_cache.root().string(), compressed);
+	}
+
+	void setWriteMisses(bool writeMisses) {
+		_writeMisses = writeMisses;
+	}
+
+	virtual osgEarth::Status openImplementation() {
+		if(!_source.valid()) return osgEarth::Status(osgEarth::Status::ConfigurationError, "no source");
+
+		const osgEarth::Status& status = _source->open();
+
+		if(status.isError()) return status;
+
+		setProfile(_source->getProfile());
+
+		for(const auto& extent : _source->getDataExtents()) addDataExtent(extent);
+
+		return osgEarth::Status::OK();
+	}
+
+	virtual osgEarth::GeoImage createImageImplementation(
+		const osgEarth::TileKey& key,
+		osgEarth::ProgressCallback* progress
+	) const {
+		if(_cache.valid()) {
+			if(osg::ref_ptr<osg::Image> image = _cache.read(key); image.valid()) {
+				return osgEarth::GeoImage(image.get(), key.getExtent());
+			}
+
+			if(_cache.isEmpty(key)) return osgEarth::GeoImage::INVALID;
+		}
+
+		osgEarth::GeoImage image = _source->createImage(key, progress);
+
+		if(image.valid() && _cache.compressed()) {
+			if(osg::ref_ptr<osg::Image> compressed = osg_qt6::compressImage(image.getImage()); compressed.valid()) {
+				image = osgEarth::GeoImage(compressed.get(), key.getExtent());
+			}
+		}
+
+		if(_cache.valid() && _writeMisses) {
+			if(image.valid()) _cache.write(key, image.getImage());
+
+			else if(osg_qt6::isNoData(_source.get(), key, image, progress)) _cache.write(key, nullptr);
+		}
+
+		return image;
+	}
+
+protected:
+	osg::ref_ptr<osgEarth::ImageLayer> _source;
+
+	osg_qt6::TileCache _cache;
+
+	bool _writeMisses = true;
+};
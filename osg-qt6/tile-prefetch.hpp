@@ -0,0 +1,508 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <functional>
+#include <iterator>
+#include <list>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <osg/Camera>
+
+#include <osgEarth/ImageLayer>
+#include <osgEarth/Viewpoint>
+
+#include "osg-qt6/memory-ledger.hpp"
+
+// Serves tiles from a bounded in-memory LRU that TilePrefetcher fills ahead of the camera, and only
+// goes to the wrapped source layer (GDAL, CachedImageLayer, ...) on a miss. A budget on its
+// MemoryAccount bounds the LRU by bytes as well as by count; pinned keys are never evicted.
+class PrefetchImageLayer: public osgEarth::ImageLayer {
+public:
+	META_Layer(osgEarth, PrefetchImageLayer, Options, ImageLayer, prefetchimagelayer);
+
+	// Called (on whichever thread the terrain engine loads from) for every tile handed to it.
+	using ServedCallback = std::function<void(const osgEarth::TileKey& key)>;
+
+	void setSource(osgEarth::ImageLayer* source) {
+		_source = source;
+	}
+
+	void setMaxTiles(size_t maxTiles) {
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		_maxTiles = maxTiles;
+
+		_trim();
+	}
+
+	// NOTE: Waits out any call to the previous callback still in progress, so clearing it is enough
+	// before whatever it points at goes away.
+	void setServedCallback(ServedCallback callback) {
+		std::lock_guard<std::mutex> lock(_servedMutex);
+
+		_served = std::move(callback);
+	}
+
+	// Keeps `keys` (whether they're in memory yet or not) out of eviction until unpin(); replaces
+	// whatever was pinned before.
+	void pin(const std::vector<osgEarth::TileKey>& keys) {
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		_pinned.clear();
+
+		for(const auto& key : keys) _pinned.insert(key.str());
+	}
+
+	void unpin() {
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		_pinned.clear();
+
+		_trim();
+	}
+
+	bool contains(const osgEarth::TileKey& key) const {
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		return _tiles.count(key.str()) != 0;
+	}
+
+	// Loads `key` into memory unless it's already there; returns whether it had to.
+	bool prefetch(const osgEarth::TileKey& key) {
+		if(contains(key)) return false;
+
+		_store(key, _source->createImage(key));
+
+		return true;
+	}
+
+	unsigned long long hits() const {
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		return _hits;
+	}
+
+	unsigned long long misses() const {
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		return _misses;
+	}
+
+	virtual osgEarth::Status openImplementation() {
+		if(!_source.valid()) return osgEarth::Status(osgEarth::Status::ConfigurationError, "no source");
+
+		const osgEarth::Status& status = _source->open();
+
+		if(status.isError()) return status;
+
+		setProfile(_source->getProfile());
+
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+
+			_account = osg_qt6::memoryLedger().open(getName().empty() ? "PrefetchImageLayer" : getName());
+			_account->set(osg_qt6::MemoryAccount::IMAGES, _bytes);
+		}
+
+		for(const auto& extent : _source->getDataExtents()) addDataExtent(extent);
+
+		return osgEarth::Status::OK();
+	}
+
+	virtual osgEarth::GeoImage createImageImplementation(
+		const osgEarth::TileKey& key,
+		osgEarth::ProgressCallback* progress
+	) const {
+		osgEarth::GeoImage image;
+
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+
+			if(auto i = _tiles.find(key.str()); i != _tiles.end()) {
+				_lru.splice(_lru.begin(), _lru, i->second.lru);
+				_hits++;
+
+				image = i->second.image;
+			}
+
+			else _misses++;
+		}
+
+		if(!image.valid()) {
+			image = _source->createImage(key, progress);
+
+			if(!(progress && progress->isCanceled())) _store(key, image);
+		}
+
+		std::lock_guard<std::mutex> lock(_servedMutex);
+
+		if(_served) _served(key);
+
+		return image;
+	}
+
+protected:
+	struct Entry {
+		osgEarth::GeoImage image;
+
+		std::list<std::string>::iterator lru;
+
+		int64_t bytes = 0;
+	};
+
+	void _store(const osgEarth::TileKey& key, const osgEarth::GeoImage& image) const {
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		auto name = key.str();
+
+		if(_tiles.count(name)) return;
+
+		_lru.push_front(name);
+		_tiles[name] = {image, _lru.begin(), osg_qt6::imageBytes(image.getImage())};
+		_bytes += _tiles[name].bytes;
+
+		_trim();
+	}
+
+	// Mutex must be held.
+	void _trim() const {
+		auto over = [this]() {
+			return _account && _tiles.size() > 1 && _account->overBudget();
+		};
+
+		if(_account) _account->set(osg_qt6::MemoryAccount::IMAGES, _bytes);
+
+		// Least recently used first, stepping over pinned keys (which may leave it over, if there
+		// are more of those than fit).
+		for(auto end = _lru.end(); end != _lru.begin() && (_tiles.size() > _maxTiles || over());) {
+			auto name = std::prev(end);
+
+			if(_pinned.count(*name)) {
+				end = name;
+
+				continue;
+			}
+
+			auto i = _tiles.find(*name);
+
+			_bytes -= i->second.bytes;
+			_tiles.erase(i);
+			_lru.erase(name);
+
+			if(_account) _account->set(osg_qt6::MemoryAccount::IMAGES, _bytes);
+		}
+	}
+
+	osg::ref_ptr<osgEarth::ImageLayer> _source;
+
+	mutable std::mutex _mutex;
+
+	// NOTE: Invalid (no data) images are kept too, so empty keys aren't asked for again either.
+	mutable std::unordered_map<std::string, Entry> _tiles;
+	mutable std::list<std::string> _lru;
+	mutable int64_t _bytes = 0;
+
+	std::unordered_set<std::string> _pinned;
+
+	mutable unsigned long long _hits = 0;
+	mutable unsigned long long _misses = 0;
+
+	size_t _maxTiles = 512;
+
+	// NOTE: Only opened with the layer; setMaxTiles() may trim before that.
+	std::shared_ptr<osg_qt6::MemoryAccount> _account;
+
+	mutable std::mutex _servedMutex;
+
+	ServedCallback _served;
+};
+
+namespace osg_qt6 {
+
+// When an EarthManipulator flight starts, works out which tiles the camera will see along the way
+// and at the destination and loads them into a PrefetchImageLayer on threads of its own (the
+// destination first, then the path in flight order), so they're already in memory when the terrain
+// engine asks for them. The destination's keys stay pinned in the layer until landed(), so the path
+// (and whatever the terrain loads on the way) can't push them out first.
+//
+// Also measures "time to full resolution": from landed() until the terrain engine stops asking for
+// tiles over the destination (no new request for QUIET_MS).
+class TilePrefetcher {
+public:
+	static constexpr double QUIET_MS = 500.0;
+
+	// Keeps the number of keys per viewpoint sane by coarsening the LOD.
+	static constexpr size_t MAX_KEYS_PER_VIEW = 64;
+
+	TilePrefetcher(PrefetchImageLayer* layer, unsigned int threads=2):
+	_layer(layer) {
+		_layer->setServedCallback([this](const osgEarth::TileKey& key) {
+			_served(key);
+		});
+
+		for(unsigned int i = 0; i < std::max(1u, threads); i++) _workers.emplace_back([this]() {
+			_work();
+		});
+	}
+
+	~TilePrefetcher() {
+		_layer->setServedCallback(nullptr);
+
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+
+			_quit = true;
+		}
+
+		_wake.notify_all();
+
+		for(auto& worker : _workers) worker.join();
+	}
+
+	// Replaces whatever the previous flight still had queued.
+	void prefetchFlight(
+		const osgEarth::Viewpoint& from,
+		const osgEarth::Viewpoint& to,
+		const osg::Camera* camera,
+		int pathSamples=8
+	) {
+		std::vector<osgEarth::TileKey> keys;
+
+		// NOTE: The terrain refines from the top down, so the destination's coarser levels are
+		// needed (briefly) on the way in as well.
+		for(int coarser = 0; coarser < 3; coarser++) {
+			auto level = keysFor(to, camera, coarser);
+
+			keys.insert(keys.end(), level.begin(), level.end());
+		}
+
+		_layer->pin(keys);
+
+		for(int i = 1; i < pathSamples; i++) {
+			auto path = keysFor(_along(from, to, static_cast<double>(i) / pathSamples), camera);
+
+			keys.insert(keys.end(), path.begin(), path.end());
+		}
+
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		// NOTE: Workers take from the back.
+		_queue.assign(keys.rbegin(), keys.rend());
+		_queued += keys.size();
+
+		_wake.notify_all();
+	}
+
+	// Starts the time-to-full-resolution clock over the area `at` shows, and unpins the destination
+	// (the path keys still queued are of no use anymore either).
+	void landed(const osgEarth::Viewpoint& at, const osg::Camera* camera) {
+		auto keys = keysFor(at, camera);
+
+		_layer->unpin();
+
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		_queue.clear();
+		_watched.clear();
+
+		for(const auto& key : keys) _watched.push_back(key.getExtent());
+
+		_landed = _clock::now();
+		_lastServed = _landed;
+		_reported = false;
+	}
+
+	// Milliseconds from landed() to the last tile the terrain asked for over the destination, once
+	// it's been quiet for QUIET_MS and only the first time; -1 otherwise.
+	double takeFullResolutionMs() {
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		if(_reported || _watched.empty()) return -1.0;
+
+		if(_ms(_clock::now() - _lastServed) < QUIET_MS) return -1.0;
+
+		_reported = true;
+
+		return _ms(_lastServed - _landed);
+	}
+
+	bool watching() const {
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		return !_watched.empty() && !_reported;
+	}
+
+	unsigned long long queued() const {
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		return _queued;
+	}
+
+	unsigned long long prefetched() const {
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		return _prefetched;
+	}
+
+	// The keys covering what `camera` sees from `vp`, at the LOD that puts roughly one tile texel on
+	// each screen pixel (minus `coarser` levels).
+	std::vector<osgEarth::TileKey> keysFor(const osgEarth::Viewpoint& vp, const osg::Camera* camera, int coarser=0) const {
+		std::vector<osgEarth::TileKey> keys;
+
+		const osgEarth::Profile* profile = _layer->getProfile();
+
+		if(!profile || !vp.focalPoint().isSet() || !vp.range().isSet()) return keys;
+
+		double fovy = 30.0;
+		double aspect = 1.0;
+		double zNear, zFar;
+
+		camera->getProjectionMatrixAsPerspective(fovy, aspect, zNear, zFar);
+
+		double range = vp.range()->as(osgEarth::Units::METERS);
+		double pitch = vp.pitch().isSet() ? vp.pitch()->as(osgEarth::Units::DEGREES) : -90.0;
+
+		// NOTE: An oblique camera sees further along its heading; stretching the footprint both ways
+		// is crude, but over-fetching a little is cheap.
+		double oblique = 1.0 / std::max(0.25, std::sin(osg::DegreesToRadians(std::abs(pitch))));
+		double halfHeight = range * std::tan(osg::DegreesToRadians(fovy * 0.5)) * oblique;
+		double halfWidth = halfHeight * aspect;
+
+		const osgEarth::GeoPoint& focal = vp.focalPoint().get();
+
+		double lon = focal.x();
+		double lat = focal.y();
+		double dLat = osg::RadiansToDegrees(halfHeight / osg::WGS_84_RADIUS_EQUATOR);
+		double dLon = osg::RadiansToDegrees(halfWidth / osg::WGS_84_RADIUS_EQUATOR) / std::max(0.1, std::cos(osg::DegreesToRadians(lat)));
+
+		osgEarth::GeoExtent extent(
+			profile->getSRS()->getGeographicSRS(),
+			std::max(-180.0, lon - dLon),
+			std::max(-90.0, lat - dLat),
+			std::min(180.0, lon + dLon),
+			std::min(90.0, lat + dLat)
+		);
+
+		const osg::Viewport* viewport = camera->getViewport();
+
+		double pixels = viewport ? viewport->width() : 1024.0;
+		double tileMeters = 2.0 * halfWidth / oblique / pixels * 256.0;
+		double lod0Meters = osgEarth::TileKey(0, 0, 0, profile).getExtent().width() * 111320.0;
+
+		int lod = static_cast<int>(std::ceil(std::log2(std::max(1.0, lod0Meters / tileMeters)))) - coarser;
+
+		for(lod = std::clamp(lod, 0, 20); lod >= 0; lod--) {
+			keys.clear();
+
+			profile->getIntersectingTiles(extent, static_cast<unsigned int>(lod), keys);
+
+			if(keys.size() <= MAX_KEYS_PER_VIEW) break;
+		}
+
+		return keys;
+	}
+
+private:
+	using _clock = std::chrono::steady_clock;
+
+	static double _ms(_clock::duration d) {
+		return std::chrono::duration<double, std::milli>(d).count();
+	}
+
+	// Roughly where EarthManipulator's arc puts the camera `t` of the way from `from` to `to`: the
+	// focal point slides along, and the range rises with the distance covered.
+	static osgEarth::Viewpoint _along(const osgEarth::Viewpoint& from, const osgEarth::Viewpoint& to, double t) {
+		osgEarth::Viewpoint vp = to;
+
+		if(!from.focalPoint().isSet() || !to.focalPoint().isSet()) return vp;
+
+		const auto& a = from.focalPoint().get();
+		const auto& b = to.focalPoint().get();
+
+		double r0 = from.range().isSet() ? from.range()->as(osgEarth::Units::METERS) : 1.0e7;
+		double r1 = to.range().isSet() ? to.range()->as(osgEarth::Units::METERS) : 1.0e7;
+
+		double distance = a.distanceTo(b.transform(a.getSRS()));
+		double arc = std::max(0.0, 0.5 * distance - std::max(r0, r1)) * std::sin(osg::PI * t);
+
+		vp.focalPoint() = osgEarth::GeoPoint(
+			a.getSRS(),
+			a.x() + (b.x() - a.x()) * t,
+			a.y() + (b.y() - a.y()) * t,
+			0.0,
+			osgEarth::ALTMODE_ABSOLUTE
+		);
+
+		vp.range() = osgEarth::Distance(r0 + (r1 - r0) * t + arc, osgEarth::Units::METERS);
+
+		return vp;
+	}
+
+	void _served(const osgEarth::TileKey& key) {
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		if(_watched.empty() || _reported) return;
+
+		for(const auto& extent : _watched) if(extent.intersects(key.getExtent())) {
+			_lastServed = _clock::now();
+
+			return;
+		}
+	}
+
+	void _work() {
+		while(true) {
+			osgEarth::TileKey key;
+
+			{
+				std::unique_lock<std::mutex> lock(_mutex);
+
+				_wake.wait(lock, [this]() {
+					return _quit || !_queue.empty();
+				});
+
+				if(_quit) return;
+
+				key = _queue.back();
+
+				_queue.pop_back();
+			}
+
+			if(_layer->prefetch(key)) {
+				std::lock_guard<std::mutex> lock(_mutex);
+
+				_prefetched++;
+			}
+		}
+	}
+
+	osg::ref_ptr<PrefetchImageLayer> _layer;
+
+	mutable std::mutex _mutex;
+
+	std::condition_variable _wake;
+
+	std::vector<osgEarth::TileKey> _queue;
+	std::vector<std::thread> _workers;
+
+	std::vector<osgEarth::GeoExtent> _watched;
+
+	_clock::time_point _landed;
+	_clock::time_point _lastServed;
+
+	unsigned long long _queued = 0;
+	unsigned long long _prefetched = 0;
+
+	bool _reported = false;
+	bool _quit = false;
+};
+
+}
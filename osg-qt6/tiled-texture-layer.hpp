@@ -0,0 +1,262 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include <osgDB/ReadFile>
+
+#include <osgEarth/ImageLayer>
+#include <osgEarth/ImageUtils>
+
+#include "osg-qt6/memory-ledger.hpp"
+#include "osg-qt6/texture-compression.hpp"
+
+// Same idea as MyTextureLayer (one global-geodetic image draped over the whole globe), but instead of
+// handing every TileKey the one full-resolution texture, each key gets its own small texture cut
+// from whichever level of a (lazily built) mip pyramid matches its resolution. Only the tiles the
+// terrain actually asks for are ever made, and the most recent `maxTiles` of them are kept in an
+// LRU cache (fewer, if its MemoryAccount has a budget); the rest are released as soon as the
+// terrain lets go of them.
+//
+// NOTE: The budget only covers what the cache can give back (each tile's texture and the image it
+// keeps); the pyramid is counted under IMAGES too, but evicting tiles can't shrink it.
+//
+// NOTE: The source itself still has to be decoded once (osgDB has no partial reads), but it's never
+// uploaded as a whole.
+class MyTiledTextureLayer: public osgEarth::ImageLayer {
+public:
+	META_Layer(osgEarth, MyTiledTextureLayer, Options, ImageLayer, mytiledtexturelayer);
+
+	void setPath(const std::string& path) {
+		_path = path.c_str();
+	}
+
+	// Width/height of the largest tile texture; keys finer than the source get smaller ones.
+	void setTileSize(unsigned int tileSize) {
+		_tileSize = std::max(tileSize, 2u);
+	}
+
+	void setMaxTiles(size_t maxTiles) {
+		_maxTiles = std::max<size_t>(maxTiles, 1);
+	}
+
+	virtual osgEarth::Status openImplementation() {
+		osg::ref_ptr<osg::Image> image = osgDB::readRefImageFile(_path);
+
+		if(!image.valid()) return osgEarth::Status(osgEarth::Status::ConfigurationError, "no path");
+
+		osg::ref_ptr<osg::Image> rgba = osgEarth::ImageUtils::convertToRGBA8(image.get());
+
+		if(!rgba.valid()) return osgEarth::Status(osgEarth::Status::ConfigurationError, "unsupported image");
+
+		// NOTE: Reserved up front so building more levels never moves the ones being sampled.
+		_levels.clear();
+		_levels.reserve(32);
+		_levels.push_back(rgba);
+
+		_account = osg_qt6::memoryLedger().open(getName().empty() ? "MyTiledTextureLayer" : getName());
+		_account->set(osg_qt6::MemoryAccount::IMAGES, osg_qt6::imageBytes(rgba.get()));
+
+		setProfile(osgEarth::Profile::create(osgEarth::Profile::GLOBAL_GEODETIC));
+		setUseCreateTexture();
+		addDataExtent(osgEarth::DataExtent(getProfile()->getExtent(), 0, 0));
+
+		return osgEarth::Status::OK();
+	}
+
+	virtual osgEarth::TextureWindow createTexture(
+		const osgEarth::TileKey& key,
+		osgEarth::ProgressCallback* progress
+	) const {
+		auto name = key.str();
+
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+
+			if(auto i = _cache.find(name); i != _cache.end()) {
+				_lru.splice(_lru.begin(), _lru, i->second.lru);
+
+				return osgEarth::TextureWindow(i->second.texture.get(), osg::Matrixf());
+			}
+		}
+
+		osg::ref_ptr<osg::Texture2D> texture = _createTile(key);
+
+		if(!texture.valid()) return osgEarth::TextureWindow();
+
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		// NOTE: Another loader thread may have made the same tile meanwhile; keep the first.
+		if(auto i = _cache.find(name); i != _cache.end()) return osgEarth::TextureWindow(
+			i->second.texture.get(),
+			osg::Matrixf()
+		);
+
+		auto& tile = _cache[name];
+
+		_lru.push_front(name);
+
+		tile.texture = texture;
+		tile.lru = _lru.begin();
+		tile.bytes = _textureBytes(texture.get());
+		tile.imageBytes = static_cast<size_t>(osg_qt6::imageBytes(texture->getImage()));
+
+		_cachedBytes += tile.bytes;
+		_cachedImageBytes += tile.imageBytes;
+
+		_account->set(osg_qt6::MemoryAccount::TEXTURES, _cachedBytes);
+		_account->add(osg_qt6::MemoryAccount::IMAGES, tile.imageBytes);
+
+		auto budget = static_cast<size_t>(_account->budget());
+
+		// NOTE: The budget never evicts the tile just made.
+		while(_cache.size() > _maxTiles || (_cache.size() > 1 && budget && _cachedBytes + _cachedImageBytes > budget)) {
+			auto i = _cache.find(_lru.back());
+
+			_cachedBytes -= i->second.bytes;
+			_cachedImageBytes -= i->second.imageBytes;
+
+			_account->set(osg_qt6::MemoryAccount::TEXTURES, _cachedBytes);
+			_account->add(osg_qt6::MemoryAccount::IMAGES, -static_cast<int64_t>(i->second.imageBytes));
+
+			_cache.erase(i);
+			_lru.pop_back();
+		}
+
+		return osgEarth::TextureWindow(texture.get(), osg::Matrixf());
+	}
+
+	// Texture memory held by the cache (with mipmaps), in bytes.
+	size_t cachedBytes() const {
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		return _cachedBytes;
+	}
+
+	size_t cachedTiles() const {
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		return _cache.size();
+	}
+
+protected:
+	struct Tile {
+		osg::ref_ptr<osg::Texture2D> texture;
+
+		std::list<std::string>::iterator lru;
+
+		// Its texture (with mipmaps) and the image the texture keeps.
+		size_t bytes = 0;
+		size_t imageBytes = 0;
+	};
+
+	static size_t _textureBytes(const osg::Texture2D* texture) {
+		// NOTE: Called before the first apply, while the image is still attached.
+		const osg::Image* image = texture->getImage();
+
+		return image ? image->getTotalSizeInBytes() * 4 / 3 : 0;
+	}
+
+	// Returns pyramid level `level` (0 is the source), halving its way down from the deepest level
+	// built so far.
+	const osg::Image* _level(unsigned int level) const {
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		while(_levels.size() <= level) {
+			const osg::Image* src = _levels.back().get();
+
+			if(src->s() == 1 && src->t() == 1) break;
+
+			_levels.push_back(osg_qt6::halveImage(src));
+
+			_account->add(osg_qt6::MemoryAccount::IMAGES, osg_qt6::imageBytes(_levels.back().get()));
+		}
+
+		return _levels[std::min<size_t>(level, _levels.size() - 1)].get();
+	}
+
+	osg::Texture2D* _createTile(const osgEarth::TileKey& key) const {
+		const osgEarth::GeoExtent& full = getProfile()->getExtent();
+		const osgEarth::GeoExtent& extent = key.getExtent();
+
+		// The key's footprint in the source, as fractions of the whole image.
+		double u0 = (extent.xMin() - full.xMin()) / full.width();
+		double v0 = (extent.yMin() - full.yMin()) / full.height();
+		double du = extent.width() / full.width();
+		double dv = extent.height() / full.height();
+
+		// Pick the coarsest level that still has at least a tile's worth of pixels under the key;
+		// keys finer than the source get fewer (level 0) pixels instead of being upsampled.
+		const osg::Image* base = _level(0);
+		double span = std::max(du * base->s(), dv * base->t());
+		auto level = static_cast<unsigned int>(std::max(0.0, std::floor(std::log2(span / _tileSize))));
+
+		const osg::Image* src = _level(level);
+
+		auto w = static_cast<int>(std::clamp(std::ceil(du * src->s()), 2.0, static_cast<double>(_tileSize)));
+		auto h = static_cast<int>(std::clamp(std::ceil(dv * src->t()), 2.0, static_cast<double>(_tileSize)));
+
+		osg::ref_ptr<osg::Image> image = new osg::Image();
+
+		image->allocateImage(w, h, 1, GL_RGBA, GL_UNSIGNED_BYTE);
+
+		for(int y = 0; y < h; y++) for(int x = 0; x < w; x++) _sample(
+			src,
+			(u0 + du * (x + 0.5) / w) * src->s() - 0.5,
+			(v0 + dv * (y + 0.5) / h) * src->t() - 0.5,
+			image->data(x, y)
+		);
+
+		auto* texture = new osg::Texture2D(image.get());
+
+		texture->setFilter(osg::Texture::MIN_FILTER, osg::Texture::LINEAR_MIPMAP_LINEAR);
+		texture->setFilter(osg::Texture::MAG_FILTER, osg::Texture::LINEAR);
+		texture->setWrap(osg::Texture::WRAP_S, osg::Texture::CLAMP_TO_EDGE);
+		texture->setWrap(osg::Texture::WRAP_T, osg::Texture::CLAMP_TO_EDGE);
+		texture->setResizeNonPowerOfTwoHint(false);
+		// NOTE: The image stays: the cache hands this texture to later keys, and once the terrain has
+		// released its GL objects (paged out and back in, a new context) it has to upload again.
+		texture->setUnRefImageDataAfterApply(false);
+
+		return texture;
+	}
+
+	// Bilinear RGBA8 sample at continuous pixel coordinates, clamped to the edges.
+	static void _sample(const osg::Image* src, double x, double y, unsigned char* out) {
+		x = std::clamp(x, 0.0, static_cast<double>(src->s() - 1));
+		y = std::clamp(y, 0.0, static_cast<double>(src->t() - 1));
+
+		int x0 = static_cast<int>(x);
+		int y0 = static_cast<int>(y);
+		int x1 = std::min(x0 + 1, src->s() - 1);
+		int y1 = std::min(y0 + 1, src->t() - 1);
+
+		double fx = x - x0;
+		double fy = y - y0;
+
+		for(int c = 0; c < 4; c++) {
+			double top = src->data(x0, y1)[c] * (1.0 - fx) + src->data(x1, y1)[c] * fx;
+			double bottom = src->data(x0, y0)[c] * (1.0 - fx) + src->data(x1, y0)[c] * fx;
+
+			out[c] = static_cast<unsigned char>(bottom * (1.0 - fy) + top * fy + 0.5);
+		}
+	}
+
+	std::string _path;
+
+	unsigned int _tileSize = 256;
+	size_t _maxTiles = 256;
+
+	mutable std::mutex _mutex;
+	mutable std::vector<osg::ref_ptr<osg::Image>> _levels;
+	mutable std::unordered_map<std::string, Tile> _cache;
+	mutable std::list<std::string> _lru;
+	mutable size_t _cachedBytes = 0;
+	mutable size_t _cachedImageBytes = 0;
+
+	std::shared_ptr<osg_qt6::MemoryAccount> _account;
+};
@@ -0,0 +1,439 @@
+#pragma once
+
+// Compile-time-gated tracing. Build with `-DOSG_QT6_TRACE=ON` (see CMakeLists.txt) to compile the
+// trace points in; otherwise every OSG_QT6_TRACE_* macro expands to nothing and trace::frame() is
+// just `viewer->frame()`.
+//
+// When compiled in, each thread records into its own lock-free (single-producer/single-consumer)
+// ring buffer, and a background thread drains all of them into a Chrome trace file (load it in
+// chrome://tracing or https://ui.perfetto.dev). Nothing is recorded until trace::start() is called;
+// the examples call trace::startFromEnvironment(), which looks at OSG_QT6_TRACE_FILE.
+
+#include <osgViewer/Viewer>
+
+namespace osg_qt6::trace {
+
+// `viewer->advance(time)`, except that an explicit `time` (e.g. FramePacer's predicted presentation
+// time) also replaces the reference time: that's what the FRAME event, and so every manipulator
+// animation, is timed by.
+inline void pacedAdvance(osgViewer::Viewer* viewer, double time=USE_REFERENCE_TIME) {
+	viewer->advance(time);
+
+	if(time != USE_REFERENCE_TIME) viewer->getViewerFrameStamp()->setReferenceTime(time);
+}
+
+}
+
+#ifdef OSG_QT6_TRACE
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <osgViewer/Renderer>
+
+namespace osg_qt6::trace {
+
+using ns_t = std::uint64_t;
+
+inline ns_t now() {
+	static const auto epoch = std::chrono::steady_clock::now();
+
+	// NOTE: Offset by one so that 0 can mean "not recording" everywhere else.
+	return static_cast<ns_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now() - epoch
+	).count()) + 1;
+}
+
+struct Event {
+	// NOTE: Must be a string literal (or otherwise outlive the trace); only the pointer is stored.
+	const char* name = nullptr;
+
+	ns_t start = 0;
+	ns_t duration = 0;
+};
+
+class Ring {
+public:
+	static constexpr size_t CAPACITY = 1 << 14;
+
+	Ring(unsigned int tid): _tid(tid) {}
+
+	// Producer (owning thread) only. Never blocks; a full ring drops the event and counts it.
+	void push(const Event& e) {
+		auto head = _head.load(std::memory_order_relaxed);
+
+		if(head - _tail.load(std::memory_order_acquire) >= CAPACITY) {
+			_dropped.fetch_add(1, std::memory_order_relaxed);
+
+			return;
+		}
+
+		_events[head & (CAPACITY - 1)] = e;
+
+		_head.store(head + 1, std::memory_order_release);
+	}
+
+	// Consumer (flusher thread) only.
+	template<typename F>
+	void drain(F&& f) {
+		auto tail = _tail.load(std::memory_order_relaxed);
+		auto head = _head.load(std::memory_order_acquire);
+
+		for(; tail != head; tail++) f(_events[tail & (CAPACITY - 1)]);
+
+		_tail.store(tail, std::memory_order_release);
+	}
+
+	unsigned int tid() const {
+		return _tid;
+	}
+
+	unsigned long long dropped() const {
+		return _dropped.load(std::memory_order_relaxed);
+	}
+
+	std::string name;
+
+private:
+	unsigned int _tid = 0;
+
+	std::array<Event, CAPACITY> _events;
+
+	std::atomic<size_t> _head = 0;
+	std::atomic<size_t> _tail = 0;
+	std::atomic<unsigned long long> _dropped = 0;
+};
+
+class Tracer {
+public:
+	static Tracer& instance() {
+		static Tracer tracer;
+
+		return tracer;
+	}
+
+	~Tracer() {
+		stop();
+	}
+
+	bool start(const std::string& path, int flushIntervalMs=100) {
+		std::lock_guard lock(_fileMutex);
+
+		if(_enabled) return true;
+
+		_out.open(path, std::ios::out | std::ios::trunc);
+
+		if(!_out) return false;
+
+		_out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+		_first = true;
+		_running = true;
+
+		_flusher = std::thread([this, flushIntervalMs]() {
+			while(_running) {
+				std::this_thread::sleep_for(std::chrono::milliseconds(flushIntervalMs));
+
+				flush();
+			}
+		});
+
+		_enabled = true;
+
+		return true;
+	}
+
+	void stop() {
+		if(!_enabled.exchange(false)) return;
+
+		_running = false;
+
+		if(_flusher.joinable()) _flusher.join();
+
+		flush();
+
+		std::lock_guard lock(_fileMutex);
+
+		_out << "\n]}\n";
+		_out.close();
+	}
+
+	bool enabled() const {
+		return _enabled.load(std::memory_order_relaxed);
+	}
+
+	void record(const Event& e) {
+		_ring().push(e);
+	}
+
+	void setThreadName(const std::string& name) {
+		Ring& ring = _ring();
+
+		std::lock_guard lock(_ringsMutex);
+
+		ring.name = name;
+	}
+
+	void flush() {
+		std::lock_guard fileLock(_fileMutex);
+
+		if(!_out.is_open()) return;
+
+		std::vector<Ring*> rings;
+
+		{
+			std::lock_guard lock(_ringsMutex);
+
+			for(auto& ring : _rings) rings.push_back(ring.get());
+
+			for(auto* ring : rings) {
+				if(ring->name.empty() || _named.size() > ring->tid() && _named[ring->tid()]) continue;
+
+				_named.resize(std::max(_named.size(), static_cast<size_t>(ring->tid()) + 1), false);
+				_named[ring->tid()] = true;
+
+				_separator();
+
+				_out << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":" << ring->tid()
+					<< ",\"args\":{\"name\":\"" << ring->name << "\"}}";
+			}
+		}
+
+		for(auto* ring : rings) ring->drain([&](const Event& e) {
+			_separator();
+
+			_out << "{\"ph\":\"X\",\"pid\":1,\"tid\":" << ring->tid()
+				<< ",\"name\":\"" << e.name
+				<< "\",\"ts\":" << static_cast<double>(e.start) / 1000.0
+				<< ",\"dur\":" << static_cast<double>(e.duration) / 1000.0 << "}";
+		});
+
+		_out.flush();
+	}
+
+private:
+	Ring& _ring() {
+		thread_local Ring* ring = nullptr;
+
+		if(!ring) {
+			std::lock_guard lock(_ringsMutex);
+
+			_rings.push_back(std::make_unique<Ring>(static_cast<unsigned int>(_rings.size())));
+
+			ring = _rings.back().get();
+		}
+
+		return *ring;
+	}
+
+	void _separator() {
+		if(!_first) _out << ",\n";
+
+		_first = false;
+	}
+
+	std::atomic<bool> _enabled = false;
+	std::atomic<bool> _running = false;
+
+	std::thread _flusher;
+
+	// NOTE: Rings are never freed (a thread's events may still be waiting to be flushed after it
+	// exits); there are only ever a handful of threads.
+	std::mutex _ringsMutex;
+	std::vector<std::unique_ptr<Ring>> _rings;
+	std::vector<bool> _named;
+
+	std::mutex _fileMutex;
+	std::ofstream _out;
+
+	bool _first = true;
+};
+
+class Scope {
+public:
+	Scope(const char* name): _name(name) {
+		if(Tracer::instance().enabled()) _start = now();
+	}
+
+	~Scope() {
+		if(_start) Tracer::instance().record({_name, _start, now() - _start});
+	}
+
+private:
+	const char* _name;
+
+	ns_t _start = 0;
+};
+
+inline bool start(const std::string& path) {
+	return Tracer::instance().start(path);
+}
+
+inline bool startFromEnvironment() {
+	const char* path = std::getenv("OSG_QT6_TRACE_FILE");
+
+	return path && *path && start(path);
+}
+
+inline void stop() {
+	Tracer::instance().stop();
+}
+
+inline void setThreadName(const std::string& name) {
+	Tracer::instance().setThreadName(name);
+}
+
+inline void complete(const char* name, ns_t start) {
+	if(start && Tracer::instance().enabled()) Tracer::instance().record({name, start, now() - start});
+}
+
+// For spans that don't fit a C++ scope (e.g. the end of paintGL() until QT's frameSwapped()).
+class Span {
+public:
+	void begin() {
+		_start = Tracer::instance().enabled() ? now() : 0;
+	}
+
+	void end(const char* name) {
+		complete(name, _start);
+
+		_start = 0;
+	}
+
+private:
+	ns_t _start = 0;
+};
+
+// Splits cull and draw into their own spans, whichever thread(s) the threading model puts them on.
+class TracingRenderer: public osgViewer::Renderer {
+public:
+	TracingRenderer(osg::Camera* camera): osgViewer::Renderer(camera) {}
+
+	void cull() override {
+		Scope scope("cull");
+
+		osgViewer::Renderer::cull();
+	}
+
+	void draw() override {
+		Scope scope("draw");
+
+		osgViewer::Renderer::draw();
+	}
+
+	void cull_draw() override {
+		Scope scope("cull_draw");
+
+		osgViewer::Renderer::cull_draw();
+	}
+};
+
+inline void install(osgViewer::Viewer* viewer) {
+	osg::Camera* camera = viewer->getCamera();
+
+	camera->setRenderer(new TracingRenderer(camera));
+}
+
+// Equivalent of `viewer->frame(time)`, with each traversal in its own span (see pacedAdvance() for
+// what an explicit `time` means).
+inline void frame(osgViewer::Viewer* viewer, double time=USE_REFERENCE_TIME) {
+	Scope scope("frame");
+
+	// NOTE: The first frame has to go through frame() itself; viewerInit() is protected.
+	if(viewer->getFrameStamp()->getFrameNumber() == 0 || viewer->done()) {
+		viewer->frame(time);
+
+		return;
+	}
+
+	{
+		Scope s("advance");
+
+		pacedAdvance(viewer, time);
+	}
+
+	{
+		Scope s("event");
+
+		viewer->eventTraversal();
+	}
+
+	{
+		Scope s("update");
+
+		viewer->updateTraversal();
+	}
+
+	{
+		Scope s("rendering");
+
+		viewer->renderingTraversals();
+	}
+}
+
+}
+
+#define OSG_QT6_TRACE_CONCAT_(a, b) a##b
+#define OSG_QT6_TRACE_CONCAT(a, b) OSG_QT6_TRACE_CONCAT_(a, b)
+#define OSG_QT6_TRACE_SCOPE(name) osg_qt6::trace::Scope OSG_QT6_TRACE_CONCAT(_traceScope, __LINE__)(name)
+
+#else
+
+#include <string>
+
+namespace osg_qt6::trace {
+
+inline bool start(const std::string&) {
+	return false;
+}
+
+inline bool startFromEnvironment() {
+	return false;
+}
+
+inline void stop() {
+}
+
+inline void setThreadName(const std::string&) {
+}
+
+class Span {
+public:
+	void begin() {
+	}
+
+	void end(const char*) {
+	}
+};
+
+inline void install(osgViewer::Viewer*) {
+}
+
+inline void frame(osgViewer::Viewer* viewer, double time=USE_REFERENCE_TIME) {
+	if(time == USE_REFERENCE_TIME || viewer->getFrameStamp()->getFrameNumber() == 0 || viewer->done()) {
+		viewer->frame(time);
+
+		return;
+	}
+
+	pacedAdvance(viewer, time);
+
+	viewer->eventTraversal();
+	viewer->updateTraversal();
+	viewer->renderingTraversals();
+}
+
+}
+
+#define OSG_QT6_TRACE_SCOPE(name) ((void)0)
+
+#endif
@@ -0,0 +1,110 @@
+// Converts a point set into the indexed .opc format PointCloudNode streams from (see
+// osg-qt6/point-cloud.hpp): either an ASCII "x y z [r g b]" file (the usual lidar text export), or
+// a synthetic terrain of any size for testing:
+//
+//   ./tool-pointcloud --input scan.xyz --output scan.opc
+//   ./tool-pointcloud --generate 100000000 --output synthetic.opc
+
+#include <cstdio>
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QCommandLineParser>
+
+#include "osg-qt6/bench.hpp"
+#include "osg-qt6/point-cloud.hpp"
+
+namespace osg_qt6 {
+
+// Reads "x y z [r g b]" lines (colors 0-255, white if missing), shifting everything so the first
+// point is the origin; returns false if the file can't be opened.
+inline bool readXyz(const std::string& path, std::vector<PointCloudPoint>& points, osg::Vec3d& origin) {
+	std::FILE* f = std::fopen(path.c_str(), "r");
+
+	if(!f) return false;
+
+	char line[512];
+	bool first = true;
+
+	while(std::fgets(line, sizeof(line), f)) {
+		double x, y, z;
+		int r = 255;
+		int g = 255;
+		int b = 255;
+
+		if(std::sscanf(line, "%lf %lf %lf %d %d %d", &x, &y, &z, &r, &g, &b) < 3) continue;
+
+		if(first) {
+			origin.set(x, y, z);
+
+			first = false;
+		}
+
+		points.push_back({
+			static_cast<float>(x - origin.x()),
+			static_cast<float>(y - origin.y()),
+			static_cast<float>(z - origin.z()),
+			static_cast<std::uint8_t>(r),
+			static_cast<std::uint8_t>(g),
+			static_cast<std::uint8_t>(b),
+			255
+		});
+	}
+
+	std::fclose(f);
+
+	return true;
+}
+
+}
+
+int main(int argc, char** argv) {
+	QCoreApplication app(argc, argv);
+	QCommandLineParser parser;
+
+	parser.addHelpOption();
+	parser.addOptions({
+		{"input", "ASCII x y z [r g b] file to convert.", "path"},
+		{"generate", "Instead of --input, generate this many synthetic points.", "count"},
+		{"output", "The .opc file to write.", "path", "points.opc"},
+		{"node-points", "Points per octree node.", "count", "16384"}
+	});
+	parser.process(app);
+
+	QElapsedTimer clock;
+
+	clock.start();
+
+	std::vector<osg_qt6::PointCloudPoint> points;
+	osg::Vec3d origin;
+
+	if(parser.isSet("generate")) points = osg_qt6::createSyntheticPoints(parser.value("generate").toULongLong());
+
+	else if(!parser.isSet("input") || !osg_qt6::readXyz(parser.value("input").toStdString(), points, origin)) {
+		OSG_FATAL << "tool-pointcloud: need a readable --input or --generate" << std::endl;
+
+		return 1;
+	}
+
+	auto readMs = clock.nsecsElapsed() / 1.0e6;
+
+	clock.restart();
+
+	auto nodePoints = static_cast<std::uint32_t>(std::max(1, parser.value("node-points").toInt()));
+
+	if(!osg_qt6::writePointCloud(parser.value("output").toStdString(), points, origin, nodePoints)) {
+		OSG_FATAL << "tool-pointcloud: couldn't write " << parser.value("output").toStdString() << std::endl;
+
+		return 1;
+	}
+
+	osg_qt6::writeJson({
+		{"tool", "pointcloud"},
+		{"output", parser.value("output")},
+		{"points", static_cast<qint64>(points.size())},
+		{"read_ms", readMs},
+		{"index_write_ms", clock.nsecsElapsed() / 1.0e6}
+	});
+
+	return 0;
+}
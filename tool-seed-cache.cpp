@@ -0,0 +1,216 @@
+// Seeds the on-disk TileCache (osg-qt6/tile-cache.hpp) that example-osgearth-interactive reads
+// before going to GDAL: walks every TileKey of `../world.tif` in the given extent and level range,
+// across all cores, and writes whatever the layer produces. Already-cached tiles are skipped, so an
+// interrupted run picks up where it stopped:
+//
+//   ./tool-seed-cache --cache tile-cache --min-level 0 --max-level 6
+//   ./tool-seed-cache --extent -80,35,-70,45 --max-level 10
+//   ./tool-seed-cache --cache tile-cache-bc --compressed
+//
+// With `--compressed` the tiles are written block compressed with their mipmaps, as DDS, for
+// `example-osgearth-interactive --compressed`.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <thread>
+#include <vector>
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QCommandLineParser>
+#include <QTextStream>
+
+#include "osg-qt6/bench.hpp"
+#include "osg-qt6/earth-scenes.hpp"
+#include "osg-qt6/tile-cache.hpp"
+
+namespace osg_qt6 {
+
+// The keys of one level that intersect the extent, as a rectangle of tile indices.
+struct LevelRange {
+	unsigned int lod = 0;
+	unsigned int x0 = 0;
+	unsigned int y0 = 0;
+	unsigned int columns = 0;
+	unsigned int rows = 0;
+
+	size_t size() const {
+		return static_cast<size_t>(columns) * rows;
+	}
+};
+
+inline LevelRange levelRange(const osgEarth::Profile* profile, unsigned int lod, const osgEarth::GeoExtent& extent) {
+	const osgEarth::GeoExtent& full = profile->getExtent();
+
+	unsigned int wide = 0;
+	unsigned int high = 0;
+
+	profile->getNumTiles(lod, wide, high);
+
+	double tw = full.width() / wide;
+	double th = full.height() / high;
+
+	auto clampIndex = [](double i, unsigned int n) {
+		return static_cast<unsigned int>(std::clamp(i, 0.0, static_cast<double>(n - 1)));
+	};
+
+	// NOTE: Tile rows count down from the north edge.
+	unsigned int x0 = clampIndex(std::floor((extent.xMin() - full.xMin()) / tw), wide);
+	unsigned int x1 = clampIndex(std::ceil((extent.xMax() - full.xMin()) / tw) - 1.0, wide);
+	unsigned int y0 = clampIndex(std::floor((full.yMax() - extent.yMax()) / th), high);
+	unsigned int y1 = clampIndex(std::ceil((full.yMax() - extent.yMin()) / th) - 1.0, high);
+
+	return {lod, x0, y0, x1 - x0 + 1, y1 - y0 + 1};
+}
+
+}
+
+int main(int argc, char** argv) {
+	QCoreApplication app(argc, argv);
+	QCommandLineParser parser;
+
+	parser.addHelpOption();
+	parser.addOptions({
+		{"cache", "Cache directory.", "path", "tile-cache"},
+		{"min-level", "First level to seed.", "lod", "0"},
+		{"max-level", "Last level to seed.", "lod", "6"},
+		{"extent", "west,south,east,north in degrees (default: the whole layer).", "extent"},
+		{"threads", "Worker threads (default: one per core).", "count"},
+		{"compressed", "Write BC1/BC3 DDS tiles instead of PNGs."}
+	});
+	parser.process(app);
+
+	osgEarth::initialize();
+
+	osg::ref_ptr<osgEarth::GDALImageLayer> layer = osg_qt6::createWorldImageLayer();
+
+	if(const osgEarth::Status& status = layer->open(); status.isError()) {
+		OSG_FATAL << "tool-seed-cache: " << status.message() << std::endl;
+
+		return 1;
+	}
+
+	const osgEarth::Profile* profile = layer->getProfile();
+	osgEarth::GeoExtent extent = profile->getExtent();
+
+	if(parser.isSet("extent")) {
+		auto parts = parser.value("extent").split(',');
+
+		if(parts.size() != 4) {
+			OSG_FATAL << "tool-seed-cache: --extent wants west,south,east,north" << std::endl;
+
+			return 1;
+		}
+
+		extent = osgEarth::GeoExtent(
+			profile->getSRS(),
+			parts[0].toDouble(),
+			parts[1].toDouble(),
+			parts[2].toDouble(),
+			parts[3].toDouble()
+		);
+	}
+
+	auto minLevel = static_cast<unsigned int>(std::max(0, parser.value("min-level").toInt()));
+	auto maxLevel = static_cast<unsigned int>(std::max(0, parser.value("max-level").toInt()));
+	auto threads = parser.isSet("threads") ?
+		std::max(1, parser.value("threads").toInt()) :
+		static_cast<int>(std::max(1u, std::thread::hardware_concurrency()))
+	;
+
+	std::vector<osg_qt6::LevelRange> levels;
+	size_t total = 0;
+
+	for(auto lod = minLevel; lod <= maxLevel; lod++) {
+		levels.push_back(osg_qt6::levelRange(profile, lod, extent));
+
+		total += levels.back().size();
+	}
+
+	osg_qt6::TileCache cache(parser.value("cache").toStdString(), parser.isSet("compressed"));
+
+	// NOTE: One flat index over all levels; workers just grab the next one.
+	std::atomic<size_t> next = 0;
+	std::atomic<size_t> written = 0;
+	std::atomic<size_t> empty = 0;
+	std::atomic<size_t> skipped = 0;
+	std::atomic<size_t> failed = 0;
+
+	auto work = [&]() {
+		for(size_t i = next++; i < total; i = next++) {
+			size_t index = i;
+			auto level = levels.begin();
+
+			while(index >= level->size()) index -= (level++)->size();
+
+			osgEarth::TileKey key(
+				level->lod,
+				level->x0 + static_cast<unsigned int>(index % level->columns),
+				level->y0 + static_cast<unsigned int>(index / level->columns),
+				profile
+			);
+
+			if(cache.contains(key)) {
+				skipped++;
+
+				continue;
+			}
+
+			osgEarth::GeoImage image = layer->createImage(key);
+
+			// NOTE: Errors aren't written as empty; the next run asks again.
+			if(!image.valid() && !osg_qt6::isNoData(layer.get(), key, image)) failed++;
+
+			else if(!cache.write(key, image.valid() ? image.getImage() : nullptr)) failed++;
+
+			else if(image.valid()) written++;
+
+			else empty++;
+		}
+	};
+
+	QElapsedTimer clock;
+
+	clock.start();
+
+	std::vector<std::thread> workers;
+
+	for(int i = 0; i < threads; i++) workers.emplace_back(work);
+
+	QTextStream err(stderr);
+
+	// Progress on stderr, so stdout stays pure JSON.
+	while(next < total) {
+		std::this_thread::sleep_for(std::chrono::seconds(1));
+
+		size_t done = std::min<size_t>(next, total);
+		double seconds = clock.nsecsElapsed() / 1.0e9;
+
+		err << done << "/" << total << " tiles, " << (written.load() + empty.load()) / seconds << " tiles/s\n";
+		err.flush();
+	}
+
+	for(auto& worker : workers) worker.join();
+
+	double seconds = clock.nsecsElapsed() / 1.0e9;
+
+	osg_qt6::writeJson({
+		{"tool", "seed-cache"},
+		{"cache", parser.value("cache")},
+		{"compressed", parser.isSet("compressed")},
+		{"levels", QJsonObject{{"min", static_cast<int>(minLevel)}, {"max", static_cast<int>(maxLevel)}}},
+		{"threads", threads},
+		{"tiles", static_cast<qint64>(total)},
+		{"written", static_cast<qint64>(written.load())},
+		{"empty", static_cast<qint64>(empty.load())},
+		{"skipped", static_cast<qint64>(skipped.load())},
+		{"failed", static_cast<qint64>(failed.load())},
+		{"seconds", seconds},
+		// NOTE: Only tiles actually produced this run; skipped ones cost (almost) nothing.
+		{"tiles_per_second", (written.load() + empty.load()) / std::max(seconds, 1.0e-9)}
+	});
+
+	return failed ? 1 : 0;
+}